@@ -0,0 +1,311 @@
+/**
+ * @file DicomArchiveIndex.cpp
+ * @brief Implementação do índice persistente de arquivos DICOM.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomArchiveIndex.h"
+#include "DicomLog.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <climits>
+
+static const quint32 kMagic = 0x58444953;  ///< 'SIDX' (lido em little endian)
+static const quint32 kVersion = 1;         ///< Versão do formato
+
+/**
+ * @brief Arquivo de índice: SHA-1 do caminho absoluto da pasta, no diretório de dados da aplicação.
+ */
+QString DicomArchiveIndex::indexFileFor(const QString &directory) {
+    const QByteArray hash = QCryptographicHash::hash(QDir(directory).absolutePath().toUtf8(),
+                                                     QCryptographicHash::Sha1);
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    return QDir(base).filePath("indices/" + QString::fromLatin1(hash.toHex()) + ".idx");
+}
+
+/**
+ * @brief Lê o índice gravado por save().
+ * @details A tabela de strings é lida primeiro; cada registro referencia suas strings por
+ * posição. As QStrings da tabela são compartilhadas (implicit sharing) entre os registros,
+ * então UIDs repetidos também ocupam memória uma única vez.
+ */
+bool DicomArchiveIndex::load(const QString &file) {
+    m_records.clear();
+    m_byPath.clear();
+    m_lookupsValid = false;
+
+    QFile input(file);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QDataStream in(&input);
+    in.setVersion(QDataStream::Qt_5_6);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic = 0, version = 0, stringCount = 0;
+    in >> magic >> version >> stringCount;
+    if (magic != kMagic || version != kVersion) {
+        return false;
+    }
+
+    QVector<QString> strings;
+    strings.reserve(int(stringCount));
+    for (quint32 i = 0; i < stringCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray utf8;
+        in >> utf8;
+        strings.append(QString::fromUtf8(utf8));
+    }
+
+    auto string = [&](quint32 id) -> QString {
+        return id < quint32(strings.size()) ? strings.at(int(id)) : QString();
+    };
+
+    quint32 recordCount = 0;
+    in >> recordCount;
+    m_records.reserve(int(recordCount));
+    for (quint32 i = 0; i < recordCount && in.status() == QDataStream::Ok; ++i) {
+        quint32 ids[10];
+        for (quint32 &id : ids) {
+            in >> id;
+        }
+        DicomInstanceInfo info;
+        info.path              = string(ids[0]);
+        info.patientID         = string(ids[1]);
+        info.patientName       = string(ids[2]);
+        info.studyInstanceUID  = string(ids[3]);
+        info.studyDate         = string(ids[4]);
+        info.studyDescription  = string(ids[5]);
+        info.seriesInstanceUID = string(ids[6]);
+        info.seriesDescription = string(ids[7]);
+        info.sopInstanceUID    = string(ids[8]);
+        info.modality          = string(ids[9]);
+        in >> info.seriesNumber >> info.instanceNumber >> info.fileSize >> info.modified >> info.isValid;
+
+        m_byPath.insert(info.path, m_records.size());
+        m_records.append(info);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        qDebug() << "Índice corrompido, será reconstruído:" << file;
+        m_records.clear();
+        m_byPath.clear();
+        return false;
+    }
+
+    qCDebug(dicomPerf) << "DicomArchiveIndex: carregados" << m_records.size() << "registros em" << timer.elapsed() << "ms";
+    return true;
+}
+
+/**
+ * @brief Grava o índice com tabela de strings (cada string distinta aparece uma única vez).
+ */
+bool DicomArchiveIndex::save(const QString &file) const {
+    QDir().mkpath(QFileInfo(file).absolutePath());
+
+    // Tabela de strings
+    QHash<QString, quint32> ids;
+    QVector<QString> strings;
+    auto intern = [&](const QString &value) -> quint32 {
+        auto it = ids.constFind(value);
+        if (it != ids.constEnd()) {
+            return it.value();
+        }
+        const quint32 id = quint32(strings.size());
+        ids.insert(value, id);
+        strings.append(value);
+        return id;
+    };
+
+    QVector<quint32> recordIds;
+    recordIds.reserve(m_records.size() * 10);
+    for (const DicomInstanceInfo &info : m_records) {
+        recordIds << intern(info.path) << intern(info.patientID) << intern(info.patientName)
+                  << intern(info.studyInstanceUID) << intern(info.studyDate) << intern(info.studyDescription)
+                  << intern(info.seriesInstanceUID) << intern(info.seriesDescription)
+                  << intern(info.sopInstanceUID) << intern(info.modality);
+    }
+
+    QSaveFile output(file);
+    if (!output.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream out(&output);
+    out.setVersion(QDataStream::Qt_5_6);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    out << kMagic << kVersion << quint32(strings.size());
+    for (const QString &value : strings) {
+        out << value.toUtf8();
+    }
+
+    out << quint32(m_records.size());
+    for (int i = 0; i < m_records.size(); ++i) {
+        const DicomInstanceInfo &info = m_records.at(i);
+        for (int f = 0; f < 10; ++f) {
+            out << recordIds.at(i * 10 + f);
+        }
+        out << info.seriesNumber << info.instanceNumber << info.fileSize << info.modified << info.isValid;
+    }
+
+    return output.commit();
+}
+
+/**
+ * @brief Começa a registrar os caminhos encontrados pela varredura.
+ */
+void DicomArchiveIndex::beginScan() {
+    m_seen.clear();
+}
+
+/**
+ * @brief Insere registros novos e substitui os de arquivos alterados.
+ */
+void DicomArchiveIndex::update(const QVector<DicomInstanceInfo> &instances) {
+    for (const DicomInstanceInfo &info : instances) {
+        m_seen.insert(info.path);
+
+        auto it = m_byPath.constFind(info.path);
+        if (it != m_byPath.constEnd()) {
+            m_records[it.value()] = info;
+        } else {
+            m_byPath.insert(info.path, m_records.size());
+            m_records.append(info);
+        }
+    }
+    m_lookupsValid = false;
+}
+
+/**
+ * @brief Remove os registros de arquivos que não existem mais.
+ * @details Só deve ser chamado após uma varredura completa (não cancelada).
+ */
+int DicomArchiveIndex::endScan() {
+    QVector<DicomInstanceInfo> kept;
+    kept.reserve(m_records.size());
+    for (const DicomInstanceInfo &info : m_records) {
+        if (m_seen.contains(info.path)) {
+            kept.append(info);
+        }
+    }
+
+    const int removed = m_records.size() - kept.size();
+    if (removed > 0) {
+        m_records = kept;
+        m_byPath.clear();
+        for (int i = 0; i < m_records.size(); ++i) {
+            m_byPath.insert(m_records.at(i).path, i);
+        }
+        m_lookupsValid = false;
+    }
+    m_seen.clear();
+    return removed;
+}
+
+/**
+ * @brief Cópia dos registros indexada por caminho.
+ */
+QHash<QString, DicomInstanceInfo> DicomArchiveIndex::snapshot() const {
+    QHash<QString, DicomInstanceInfo> byPath;
+    byPath.reserve(m_records.size());
+    for (const DicomInstanceInfo &info : m_records) {
+        byPath.insert(info.path, info);
+    }
+    return byPath;
+}
+
+/**
+ * @brief Apenas os registros de instâncias DICOM válidas.
+ */
+QVector<DicomInstanceInfo> DicomArchiveIndex::instances() const {
+    QVector<DicomInstanceInfo> valid;
+    valid.reserve(m_records.size());
+    for (const DicomInstanceInfo &info : m_records) {
+        if (info.isValid) {
+            valid.append(info);
+        }
+    }
+    return valid;
+}
+
+/**
+ * @brief Remonta os índices secundários (uma passada linear, só após alterações).
+ */
+void DicomArchiveIndex::ensureLookups() const {
+    if (m_lookupsValid) {
+        return;
+    }
+
+    m_byPatient.clear();
+    m_byModality.clear();
+    m_byDate.clear();
+    m_byDate.reserve(m_records.size());
+
+    for (int i = 0; i < m_records.size(); ++i) {
+        const DicomInstanceInfo &info = m_records.at(i);
+        if (!info.isValid) {
+            continue;
+        }
+        m_byPatient.insert(info.patientID, i);
+        m_byModality.insert(info.modality, i);
+        m_byDate.append(qMakePair(info.studyDate, i));
+    }
+    std::sort(m_byDate.begin(), m_byDate.end());
+    m_lookupsValid = true;
+}
+
+/**
+ * @brief Consulta por Patient ID, intervalo de Study Date e modalidade.
+ * @details O critério mais seletivo disponível escolhe os candidatos (Patient ID, depois
+ * modalidade, depois intervalo de datas por busca binária); os demais critérios são
+ * verificados apenas nesses candidatos. Datas YYYYMMDD são comparadas como texto.
+ */
+QVector<DicomInstanceInfo> DicomArchiveIndex::query(const Query &query) const {
+    ensureLookups();
+
+    QVector<int> candidates;
+    if (!query.patientID.isEmpty()) {
+        candidates = m_byPatient.values(query.patientID).toVector();
+    } else if (!query.modality.isEmpty()) {
+        candidates = m_byModality.values(query.modality).toVector();
+    } else {
+        auto first = m_byDate.constBegin();
+        auto last = m_byDate.constEnd();
+        if (!query.dateFrom.isEmpty()) {
+            first = std::lower_bound(m_byDate.constBegin(), m_byDate.constEnd(), qMakePair(query.dateFrom, -1));
+        }
+        if (!query.dateTo.isEmpty()) {
+            last = std::upper_bound(first, m_byDate.constEnd(), qMakePair(query.dateTo, INT_MAX));
+        }
+        candidates.reserve(int(last - first));
+        for (auto it = first; it != last; ++it) {
+            candidates.append(it->second);
+        }
+    }
+
+    QVector<DicomInstanceInfo> result;
+    for (int i : candidates) {
+        const DicomInstanceInfo &info = m_records.at(i);
+        if (!query.patientID.isEmpty() && info.patientID != query.patientID) continue;
+        if (!query.modality.isEmpty() && info.modality != query.modality) continue;
+        if (!query.dateFrom.isEmpty() && info.studyDate < query.dateFrom) continue;
+        if (!query.dateTo.isEmpty() && info.studyDate > query.dateTo) continue;
+        result.append(info);
+    }
+    return result;
+}
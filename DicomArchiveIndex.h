@@ -0,0 +1,113 @@
+/**
+ * @file DicomArchiveIndex.h
+ * @brief Definição do índice persistente de arquivos DICOM (acervos locais e de rede).
+ * @details Guarda em um arquivo compacto as tags de identificação de todas as instâncias de
+ * uma pasta, junto com tamanho e data de modificação de cada arquivo. Ao reabrir a pasta,
+ * o navegador é preenchido imediatamente a partir do índice e a varredura só lê os
+ * arquivos novos ou alterados.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMARCHIVEINDEX_H
+#define DICOMARCHIVEINDEX_H
+
+#include <QHash>
+#include <QMultiHash>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "DicomManager.h"
+
+/**
+ * @class DicomArchiveIndex
+ * @brief Registro persistente (caminho -> instância) com consultas por paciente, data e modalidade.
+ *
+ * Arquivos não-DICOM também são registrados (isValid = false), para que não sejam abertos
+ * novamente a cada varredura.
+ *
+ * Formato do arquivo (QDataStream): magic 'SIDX', versão, tabela de strings únicas e os
+ * registros, cujos campos textuais são índices na tabela. UIDs de estudo e série, nomes e
+ * datas se repetem em milhares de instâncias e são gravados uma única vez.
+ *
+ * Consultas usam índices secundários (Patient ID, modalidade e datas ordenadas), montados
+ * sob demanda após alterações; com eles, uma consulta em centenas de milhares de registros
+ * custa milissegundos.
+ */
+class DicomArchiveIndex {
+public:
+    /**
+     * @struct Query
+     * @brief Critérios de consulta (campos vazios são ignorados).
+     */
+    struct Query {
+        QString patientID;  ///< Patient ID exato
+        QString dateFrom;   ///< Study Date inicial (YYYYMMDD, inclusiva)
+        QString dateTo;     ///< Study Date final (YYYYMMDD, inclusiva)
+        QString modality;   ///< Modalidade exata (ex.: MG, CT)
+    };
+
+    /**
+     * @brief Caminho do arquivo de índice de uma pasta (diretório de dados da aplicação).
+     * @param directory Pasta raiz indexada.
+     */
+    static QString indexFileFor(const QString &directory);
+
+    /**
+     * @brief Carrega o índice de um arquivo (substitui o conteúdo atual).
+     * @return false se o arquivo não existir ou for de outra versão (índice fica vazio).
+     */
+    bool load(const QString &file);
+
+    /**
+     * @brief Grava o índice de forma atômica (arquivo temporário + renomeação).
+     */
+    bool save(const QString &file) const;
+
+    /**
+     * @brief Início de uma varredura: passa a registrar quais caminhos ainda existem.
+     */
+    void beginScan();
+
+    /**
+     * @brief Registra (ou atualiza) arquivos recebidos da varredura.
+     */
+    void update(const QVector<DicomInstanceInfo> &instances);
+
+    /**
+     * @brief Fim de uma varredura completa: remove os arquivos que não foram encontrados.
+     * @return Quantidade de registros removidos.
+     */
+    int endScan();
+
+    /// Registros por caminho (para DicomScanner::scan).
+    QHash<QString, DicomInstanceInfo> snapshot() const;
+
+    /// Todas as instâncias válidas.
+    QVector<DicomInstanceInfo> instances() const;
+
+    /**
+     * @brief Consulta instâncias válidas por Patient ID, intervalo de datas e modalidade.
+     */
+    QVector<DicomInstanceInfo> query(const Query &query) const;
+
+    /// Quantidade de registros (incluindo arquivos não-DICOM).
+    int size() const { return m_records.size(); }
+
+private:
+    /// Remonta os índices secundários se houve alteração desde a última consulta.
+    void ensureLookups() const;
+
+    QVector<DicomInstanceInfo> m_records;  ///< Registros (um por arquivo)
+    QHash<QString, int> m_byPath;          ///< Caminho -> posição em m_records
+    QSet<QString> m_seen;                  ///< Caminhos vistos na varredura atual
+
+    mutable bool m_lookupsValid = false;                ///< Índices secundários atualizados
+    mutable QMultiHash<QString, int> m_byPatient;       ///< Patient ID -> registros
+    mutable QMultiHash<QString, int> m_byModality;      ///< Modalidade -> registros
+    mutable QVector<QPair<QString, int>> m_byDate;      ///< (Study Date, registro) ordenados
+};
+
+#endif // DICOMARCHIVEINDEX_H
@@ -0,0 +1,252 @@
+/**
+ * @file DicomBrowser.cpp
+ * @brief Implementação do navegador de pastas DICOM.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomBrowser.h"
+
+#include <QHeaderView>
+#include <QSet>
+
+#include <algorithm>
+
+static const int kPathRole = Qt::UserRole; ///< Caminho do arquivo (itens de instância)
+
+/**
+ * @class BrowserItem
+ * @brief Item da árvore ordenado por uma chave própria (data ISO, números com zeros à
+ * esquerda), e não pelo texto exibido.
+ * @details A chave fica em um QString do item: comparar não passa por QVariant.
+ */
+class BrowserItem : public QTreeWidgetItem {
+public:
+    explicit BrowserItem(const QString &key) : m_key(key) {}
+
+    const QString &key() const { return m_key; }
+
+    bool operator<(const QTreeWidgetItem &other) const override {
+        return m_key < static_cast<const BrowserItem &>(other).m_key;
+    }
+
+private:
+    QString m_key;
+};
+
+/// Chave de ordenação de um item da árvore (todos são BrowserItem).
+static const QString &sortKey(const QTreeWidgetItem *item) {
+    return static_cast<const BrowserItem *>(item)->key();
+}
+
+/**
+ * @brief Insere os itens na posição ordenada entre os filhos de 'parent'.
+ * @details Os itens são ordenados entre si e, se todos vierem depois do último filho (o
+ * caso comum: pastas varridas em ordem), acrescentados de uma vez. Senão, cada um é
+ * inserido por busca binária, começando da posição do anterior. Nenhum ramo é reordenado
+ * por inteiro, então o custo de um lote não cresce com o tamanho da série.
+ */
+static void insertSorted(QTreeWidgetItem *parent, QList<QTreeWidgetItem *> items) {
+    std::stable_sort(items.begin(), items.end(), [](const QTreeWidgetItem *a, const QTreeWidgetItem *b) {
+        return sortKey(a) < sortKey(b);
+    });
+
+    const int count = parent->childCount();
+    if (count == 0 || !(sortKey(items.first()) < sortKey(parent->child(count - 1)))) {
+        parent->addChildren(items);
+        return;
+    }
+
+    int low = 0;
+    for (QTreeWidgetItem *item : items) {
+        int high = parent->childCount();
+        while (low < high) {
+            const int middle = low + (high - low) / 2;
+            if (sortKey(item) < sortKey(parent->child(middle))) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        parent->insertChild(low, item);
+        ++low;
+    }
+}
+
+/// Data DICOM (YYYYMMDD) no formato do overlay (DD/MM/YYYY).
+static QString displayDate(const QString &date) {
+    if (date.length() != 8) {
+        return date.isEmpty() ? "Sem data" : date;
+    }
+    return date.mid(6, 2) + "/" + date.mid(4, 2) + "/" + date.left(4);
+}
+
+/// Número com zeros à esquerda, para que a ordenação textual siga a numérica.
+static QString paddedNumber(int number) {
+    return QString("%1").arg(number, 10, 10, QChar('0'));
+}
+
+/// Chave de um nó do índice até a profundidade indicada (0 = paciente, 1 = estudo, 2 = série).
+static QString nodeKey(const DicomIndex::Location &location, int depth) {
+    switch (depth) {
+    case 0:  return QString("%1").arg(location.patient);
+    case 1:  return QString("%1/%2").arg(location.patient).arg(location.study);
+    default: return QString("%1/%2/%3").arg(location.patient).arg(location.study).arg(location.series);
+    }
+}
+
+/**
+ * @brief Construtor. Configura as colunas (descrição e quantidade de imagens).
+ */
+DicomBrowser::DicomBrowser(QWidget *parent)
+    : QTreeWidget(parent) {
+    setColumnCount(2);
+    setHeaderLabels({"Paciente / Estudo / Série", "Imagens"});
+    header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    header()->setStretchLastSection(false);
+    setUniformRowHeights(true); // Permite ao Qt calcular a rolagem sem medir cada item
+
+    connect(this, &QTreeWidget::itemActivated, this, &DicomBrowser::onItemActivated);
+}
+
+/**
+ * @brief Esvazia a árvore e o índice.
+ */
+void DicomBrowser::clearIndex() {
+    clear();
+    m_items.clear();
+    m_index.clear();
+}
+
+/**
+ * @brief Cria (ou reutiliza) o item de um nó do índice.
+ * @details Os pais são criados recursivamente; o texto e a chave de ordenação vêm dos
+ * dados descritivos do nó (primeira instância que o criou). Itens novos ainda não entram
+ * na árvore: ficam em 'added', sob o pai, para a inserção ordenada no fim do lote.
+ */
+QTreeWidgetItem *DicomBrowser::nodeItem(const DicomIndex::Location &location, int depth, PendingChildren &added) {
+    const QString key = nodeKey(location, depth);
+    auto it = m_items.constFind(key);
+    if (it != m_items.constEnd()) {
+        return it.value();
+    }
+
+    const DicomPatientNode &patient = m_index.patients().at(location.patient);
+    QTreeWidgetItem *item = nullptr;
+    QTreeWidgetItem *parent = nullptr;
+
+    if (depth == 0) {
+        const QString name = patient.name.isEmpty() ? "Sem nome" : patient.name;
+        item = new BrowserItem(name + "|" + patient.id);
+        item->setText(0, QString("%1 (%2)").arg(name, patient.id.isEmpty() ? "sem ID" : patient.id));
+        parent = invisibleRootItem();
+    } else if (depth == 1) {
+        const DicomStudyNode &study = patient.studies.at(location.study);
+        item = new BrowserItem(study.date + "|" + study.uid);
+        item->setText(0, QString("%1 - %2").arg(displayDate(study.date),
+                                                study.description.isEmpty() ? "Estudo" : study.description));
+        item->setToolTip(0, study.uid);
+        parent = nodeItem(location, 0, added);
+    } else {
+        const DicomSeriesNode &series = patient.studies.at(location.study).series.at(location.series);
+        item = new BrowserItem(paddedNumber(series.number) + "|" + series.uid);
+        item->setText(0, QString("Série %1 - %2 %3").arg(series.number).arg(series.modality, series.description));
+        item->setToolTip(0, series.uid);
+        parent = nodeItem(location, 1, added);
+    }
+
+    added[parent].append(item);
+    m_items.insert(key, item);
+    return item;
+}
+
+/**
+ * @brief Atualiza a quantidade de imagens abaixo de um nó.
+ */
+void DicomBrowser::updateCount(QTreeWidgetItem *item, int depth, const DicomIndex::Location &location) {
+    const DicomPatientNode &patient = m_index.patients().at(location.patient);
+    int count = 0;
+
+    if (depth == 2) {
+        count = patient.studies.at(location.study).series.at(location.series).instances.size();
+    } else {
+        for (int s = 0; s < patient.studies.size(); ++s) {
+            if (depth == 1 && s != location.study) {
+                continue;
+            }
+            for (const DicomSeriesNode &series : patient.studies.at(s).series) {
+                count += series.instances.size();
+            }
+        }
+    }
+    item->setText(1, QString::number(count));
+}
+
+/**
+ * @brief Acrescenta um lote à árvore.
+ * @details As atualizações de tela ficam suspensas durante o lote. Os itens novos são
+ * agrupados por pai e inseridos nas posições ordenadas (insertSorted), sem reordenar os
+ * ramos existentes; só os ramos que os receberam têm a contagem recalculada.
+ */
+void DicomBrowser::addInstances(const QVector<DicomInstanceInfo> &instances) {
+    setUpdatesEnabled(false);
+
+    QHash<QTreeWidgetItem *, QPair<int, DicomIndex::Location>> touched; // Item -> (profundidade, nó)
+    PendingChildren added;                                              // Pai -> itens novos
+
+    for (const DicomInstanceInfo &info : instances) {
+        DicomIndex::Location location;
+        if (!m_index.add(info, &location)) {
+            continue; // Inválida ou repetida
+        }
+
+        QTreeWidgetItem *item = new BrowserItem(paddedNumber(info.instanceNumber) + "|" + info.sopInstanceUID);
+        item->setText(0, QString("Imagem %1").arg(info.instanceNumber));
+        item->setData(0, kPathRole, info.path);
+        item->setToolTip(0, info.path);
+        added[nodeItem(location, 2, added)].append(item);
+
+        for (int depth = 0; depth <= 2; ++depth) {
+            touched.insert(nodeItem(location, depth, added), qMakePair(depth, location));
+        }
+    }
+
+    for (auto it = added.constBegin(); it != added.constEnd(); ++it) {
+        insertSorted(it.key(), it.value());
+    }
+    for (auto it = touched.constBegin(); it != touched.constEnd(); ++it) {
+        updateCount(it.key(), it.value().first, it.value().second);
+    }
+
+    setUpdatesEnabled(true);
+}
+
+/**
+ * @brief Abre a instância ativada ou, para uma série, todas as suas instâncias como volume.
+ * @details Série com uma única instância é aberta como arquivo comum.
+ */
+void DicomBrowser::onItemActivated(QTreeWidgetItem *item, int column) {
+    Q_UNUSED(column);
+
+    QString path = item->data(0, kPathRole).toString();
+    if (path.isEmpty() && item->childCount() > 1) {
+        QStringList paths;
+        for (int i = 0; i < item->childCount(); ++i) {
+            const QString child = item->child(i)->data(0, kPathRole).toString();
+            if (!child.isEmpty()) {
+                paths.append(child);
+            }
+        }
+        if (paths.size() > 1) {
+            emit seriesActivated(paths);
+            return;
+        }
+    }
+    if (path.isEmpty() && item->childCount() > 0) {
+        path = item->child(0)->data(0, kPathRole).toString(); // Série: primeira imagem
+    }
+    if (!path.isEmpty()) {
+        emit instanceActivated(path);
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file DicomBrowser.h
+ * @brief Definição do navegador de pastas (árvore Paciente -> Estudo -> Série -> Instância).
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMBROWSER_H
+#define DICOMBROWSER_H
+
+#include <QHash>
+#include <QTreeWidget>
+#include <QVector>
+
+#include "DicomIndex.h"
+
+/**
+ * @class DicomBrowser
+ * @brief Árvore de navegação preenchida incrementalmente a partir dos lotes do DicomScanner.
+ *
+ * Mantém o DicomIndex e um item da árvore para cada nó do índice. Cada lote recebido cria
+ * apenas os itens novos e os insere direto nas posições ordenadas (busca binária), sem
+ * reordenar ramos inteiros, de modo que a árvore continua responsiva durante a varredura
+ * de dezenas de milhares de arquivos.
+ * Ativar (duplo clique / Enter) uma instância emite instanceActivated; uma série com mais
+ * de uma instância emite seriesActivated (empilhamento em volume).
+ */
+class DicomBrowser : public QTreeWidget {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Construtor.
+     * @param parent Widget pai.
+     */
+    explicit DicomBrowser(QWidget *parent = nullptr);
+
+    /**
+     * @brief Remove todos os itens e esvazia o índice (ex.: antes de uma nova varredura).
+     */
+    void clearIndex();
+
+    /**
+     * @brief Acrescenta um lote de instâncias ao índice e à árvore.
+     * @param instances Instâncias lidas pelo DicomScanner.
+     */
+    void addInstances(const QVector<DicomInstanceInfo> &instances);
+
+    /// Índice em memória com todas as instâncias recebidas.
+    const DicomIndex &index() const { return m_index; }
+
+signals:
+    /// O usuário escolheu um arquivo para abrir.
+    void instanceActivated(const QString &path);
+
+    /// O usuário escolheu uma série para abrir como volume (arquivos de todas as instâncias).
+    void seriesActivated(const QStringList &paths);
+
+private slots:
+    void onItemActivated(QTreeWidgetItem *item, int column);
+
+private:
+    /// Itens criados em um lote, agrupados pelo pai, ainda fora da árvore.
+    using PendingChildren = QHash<QTreeWidgetItem *, QList<QTreeWidgetItem *>>;
+
+    /// Item da árvore de um nó do índice (criado na primeira referência, registrado em 'added').
+    QTreeWidgetItem *nodeItem(const DicomIndex::Location &location, int depth, PendingChildren &added);
+
+    /// Atualiza a contagem de imagens exibida em um item de paciente/estudo/série.
+    void updateCount(QTreeWidgetItem *item, int depth, const DicomIndex::Location &location);
+
+    DicomIndex m_index;                          ///< Hierarquia completa
+    QHash<QString, QTreeWidgetItem *> m_items;   ///< Chave do nó -> item da árvore
+};
+
+#endif // DICOMBROWSER_H
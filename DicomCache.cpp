@@ -0,0 +1,159 @@
+/**
+ * @file DicomCache.cpp
+ * @brief Implementação do cache LRU de imagens DICOM decodificadas.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomCache.h"
+#include "DicomLog.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+/**
+ * @brief Construtor privado: começa vazio, com o orçamento padrão.
+ */
+DicomCache::DicomCache() {
+    m_stats.budget = kDefaultBudget;
+}
+
+/**
+ * @brief Instância única, criada no primeiro uso (inicialização segura entre threads no C++11).
+ */
+DicomCache &DicomCache::instance() {
+    static DicomCache cache;
+    return cache;
+}
+
+/**
+ * @brief Monta a chave a partir dos atributos do arquivo no disco.
+ * @details Usa apenas o sistema de arquivos (stat), sem abrir o arquivo: a busca no cache
+ * custa microssegundos. Tamanho e data de modificação invalidam a entrada se o arquivo mudar.
+ */
+QString DicomCache::keyFor(const QString &path) {
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return QString();
+    }
+    return QString("%1|%2|%3")
+        .arg(info.absoluteFilePath())
+        .arg(info.size())
+        .arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+/**
+ * @brief Soma a memória própria do resultado.
+ * @details pyramid[0] compartilha o buffer de 'pixels', então a pirâmide já cobre os pixels
+ * nativos; sem pirâmide (imagens coloridas), conta-se a imagem em 8 bits.
+ */
+qint64 DicomCache::costOf(const DicomLoadResult &result) {
+    qint64 cost = result.image.sizeInBytes();
+    if (result.pyramid.isEmpty()) {
+        cost += result.pixels.isNull() ? 0 : result.pixels.byteSize();
+    }
+    for (const DicomPixelData &level : result.pyramid) {
+        cost += level.byteSize();
+    }
+    return cost;
+}
+
+/**
+ * @brief Busca um resultado; em caso de acerto, move a entrada para a frente da lista.
+ */
+bool DicomCache::find(const QString &key, DicomLoadResult &result) {
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_index.constFind(key);
+    if (key.isEmpty() || it == m_index.constEnd()) {
+        ++m_stats.misses;
+        return false;
+    }
+
+    // splice só reordena os nós: os iteradores guardados no índice continuam válidos
+    m_entries.splice(m_entries.begin(), m_entries, it.value());
+    result = m_entries.front().result;
+    ++m_stats.hits;
+    return true;
+}
+
+/**
+ * @brief Consulta sem efeitos colaterais (não conta acerto/falha nem reordena a lista).
+ */
+bool DicomCache::contains(const QString &key) const {
+    QMutexLocker locker(&m_mutex);
+    return !key.isEmpty() && m_index.contains(key);
+}
+
+/**
+ * @brief Insere um resultado na frente da lista e aplica o orçamento.
+ */
+void DicomCache::insert(const QString &key, const DicomLoadResult &result) {
+    if (key.isEmpty() || result.canceled || !result.isValid()) {
+        return;
+    }
+
+    const qint64 cost = costOf(result);
+
+    QMutexLocker locker(&m_mutex);
+    if (cost > m_stats.budget) {
+        return; // Nunca caberia: guardá-lo só descartaria todo o resto
+    }
+
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_stats.bytes -= it.value()->cost;
+        m_entries.erase(it.value());
+        m_index.erase(it);
+    }
+
+    m_entries.push_front(Entry{key, result, cost});
+    m_index.insert(key, m_entries.begin());
+    m_stats.bytes += cost;
+
+    evictToBudget();
+}
+
+/**
+ * @brief Altera o orçamento e descarta o excedente imediatamente.
+ */
+void DicomCache::setBudget(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_stats.budget = qMax<qint64>(0, bytes);
+    evictToBudget();
+}
+
+/**
+ * @brief Remove todas as entradas.
+ */
+void DicomCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_entries.clear();
+    m_index.clear();
+    m_stats.bytes = 0;
+}
+
+/**
+ * @brief Cópia dos contadores, com o número de entradas atualizado.
+ */
+DicomCache::Stats DicomCache::stats() const {
+    QMutexLocker locker(&m_mutex);
+    Stats copy = m_stats;
+    copy.entries = int(m_entries.size());
+    return copy;
+}
+
+/**
+ * @brief Remove as entradas menos usadas recentemente (fim da lista) até caber no orçamento.
+ */
+void DicomCache::evictToBudget() {
+    while (m_stats.bytes > m_stats.budget && !m_entries.empty()) {
+        const Entry &last = m_entries.back();
+        qCDebug(dicomPerf) << "DicomCache: descartando" << last.result.path << "-" << last.cost / (1024 * 1024) << "MB";
+        m_stats.bytes -= last.cost;
+        m_index.remove(last.key);
+        m_entries.pop_back();
+        ++m_stats.evictions;
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * @file DicomCache.h
+ * @brief Definição do cache em memória de imagens DICOM já decodificadas.
+ * @details Reabrir um dos últimos arquivos visualizados não passa novamente pelo disco nem
+ * pelo codec: o DicomLoadResult completo (pixels nativos, pirâmide e metadados) é reutilizado.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMCACHE_H
+#define DICOMCACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+#include <list>
+
+#include "DicomManager.h"
+
+/**
+ * @class DicomCache
+ * @brief Cache LRU (menos usado recentemente) de resultados decodificados, limitado em bytes.
+ *
+ * Único para todo o processo (instance()) e seguro para uso a partir de várias threads.
+ * A chave combina caminho, tamanho e data de modificação do arquivo, então um arquivo
+ * regravado no disco nunca devolve pixels antigos. Quando a soma dos tamanhos ultrapassa
+ * o orçamento, as entradas menos usadas recentemente são descartadas.
+ *
+ * Como os buffers de pixels são compartilhados (std::shared_ptr), manter um resultado no
+ * cache não duplica a memória da imagem exibida.
+ */
+class DicomCache {
+public:
+    /**
+     * @struct Stats
+     * @brief Contadores para dimensionar o orçamento de memória.
+     */
+    struct Stats {
+        quint64 hits = 0;       ///< Buscas atendidas pelo cache
+        quint64 misses = 0;     ///< Buscas que exigiram decodificação
+        quint64 evictions = 0;  ///< Entradas descartadas por falta de espaço
+        int entries = 0;        ///< Entradas atualmente em cache
+        qint64 bytes = 0;       ///< Memória ocupada pelas entradas
+        qint64 budget = 0;      ///< Limite de memória configurado
+    };
+
+    static const qint64 kDefaultBudget = qint64(2048) * 1024 * 1024; ///< Orçamento padrão (2 GB)
+
+    /**
+     * @brief Retorna a instância única do processo.
+     */
+    static DicomCache &instance();
+
+    /**
+     * @brief Monta a chave de cache de um arquivo (caminho + tamanho + data de modificação).
+     * @param path O caminho do arquivo .dcm.
+     * @return QString Chave, ou string vazia se o arquivo não existir.
+     */
+    static QString keyFor(const QString &path);
+
+    /**
+     * @brief Busca um resultado e o marca como usado mais recentemente.
+     * @param key Chave obtida com keyFor().
+     * @param result Destino (inalterado em caso de ausência).
+     * @return true se o resultado estava em cache.
+     */
+    bool find(const QString &key, DicomLoadResult &result);
+
+    /**
+     * @brief Indica se a chave está em cache, sem alterar a ordem LRU nem os contadores.
+     * @details Usado pela pré-carga para não decodificar novamente o que já está em memória.
+     */
+    bool contains(const QString &key) const;
+
+    /**
+     * @brief Insere (ou substitui) um resultado, descartando os menos usados se necessário.
+     * @details Resultados inválidos, cancelados ou maiores que o orçamento não são guardados.
+     * @param key Chave obtida com keyFor().
+     * @param result Resultado completo de DicomManager::loadDicomFile.
+     */
+    void insert(const QString &key, const DicomLoadResult &result);
+
+    /**
+     * @brief Altera o orçamento de memória (descarta entradas se o novo limite for menor).
+     * @param bytes Limite em bytes (0 desativa o cache).
+     */
+    void setBudget(qint64 bytes);
+
+    /**
+     * @brief Remove todas as entradas (os contadores são mantidos).
+     */
+    void clear();
+
+    /**
+     * @brief Retorna uma cópia dos contadores atuais.
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Memória ocupada por um resultado (pirâmide + imagem em 8 bits).
+     */
+    static qint64 costOf(const DicomLoadResult &result);
+
+private:
+    DicomCache();
+    DicomCache(const DicomCache &) = delete;
+    DicomCache &operator=(const DicomCache &) = delete;
+
+    /// Entrada da lista LRU (a frente é a mais recente).
+    struct Entry {
+        QString key;
+        DicomLoadResult result;
+        qint64 cost = 0;
+    };
+    using EntryList = std::list<Entry>;
+
+    /// Descarta entradas do fim da lista até caber no orçamento. Requer m_mutex travado.
+    void evictToBudget();
+
+    mutable QMutex m_mutex;                       ///< Protege todos os membros abaixo
+    EntryList m_entries;                          ///< Ordem de uso (LRU)
+    QHash<QString, EntryList::iterator> m_index;  ///< Chave -> posição na lista
+    Stats m_stats;                                ///< Contadores e ocupação
+};
+
+#endif // DICOMCACHE_H
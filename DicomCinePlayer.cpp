@@ -0,0 +1,321 @@
+/**
+ * @file DicomCinePlayer.cpp
+ * @brief Implementação do reprodutor cine de objetos multi-frame.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomCinePlayer.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+/**
+ * @brief Construtor. Registra os tipos do sinal enfileirado e configura o relógio.
+ * @details O token das decodificações começa como filho de m_lifetime já cancelado;
+ * cada setSource() cria um filho novo.
+ */
+DicomCinePlayer::DicomCinePlayer(QObject *parent)
+    : QObject(parent),
+      m_token(m_lifetime.child()) {
+    qRegisterMetaType<DicomPixelData>("DicomPixelData");
+    qRegisterMetaType<QVector<DicomPixelData>>("QVector<DicomPixelData>");
+    qRegisterMetaType<QVector<QImage>>("QVector<QImage>");
+
+    m_token.cancel();
+    m_timer.setTimerType(Qt::PreciseTimer);
+
+    connect(&m_timer, &QTimer::timeout, this, &DicomCinePlayer::onTick);
+    connect(this, &DicomCinePlayer::jobFinished, this, &DicomCinePlayer::onJobFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destrutor. As tarefas referenciam 'this': descarta as pendentes e aguarda as ativas.
+ */
+DicomCinePlayer::~DicomCinePlayer() {
+    m_lifetime.cancel();
+    m_lifetime.waitForIdle();
+}
+
+/**
+ * @brief Define o objeto reproduzido.
+ * @details A capacidade do buffer circular é a quantidade de frames que cabe em
+ * kRingBudget, entre kMinRingFrames e kMaxRingFrames, e nunca maior que frameCount.
+ * O frame 0 (já decodificado pelo carregamento normal) entra no buffer, e a decodificação
+ * dos seguintes começa em seguida, antes mesmo do play(). Objetos sem pixels nativos
+ * (coloridos) são reproduzidos em 8 bits, como o frame 0 em DicomLoadResult::image.
+ */
+void DicomCinePlayer::setSource(const DicomLoadResult &loaded) {
+    clear();
+    if (loaded.frameCount <= 1 || !loaded.isValid()) {
+        return;
+    }
+
+    m_path = loaded.path;
+    m_source = std::make_shared<Source>();
+    m_source->path = loaded.path;
+    m_color = loaded.pixels.isNull();
+    m_frameCount = loaded.frameCount;
+    m_frameRate = loaded.frameRate > 0.0 ? loaded.frameRate : kDefaultFrameRate;
+
+    const qint64 frameBytes = m_color ? qint64(loaded.image.bytesPerLine()) * loaded.image.height()
+                                      : loaded.pixels.byteSize();
+    const qint64 fit = kRingBudget / std::max<qint64>(1, frameBytes);
+    const int capacity = int(qBound<qint64>(kMinRingFrames, fit, kMaxRingFrames));
+    m_ring = QVector<Slot>(std::min(capacity, m_frameCount));
+    m_ring[0].frame = 0;
+    m_ring[0].pixels = loaded.pixels;
+    m_ring[0].image = loaded.image;
+
+    m_token = m_lifetime.child();
+    requestAhead();
+}
+
+/**
+ * @brief Para a reprodução, cancela as decodificações e libera o buffer.
+ */
+void DicomCinePlayer::clear() {
+    if (isPlaying()) {
+        pause();
+    }
+    m_token.cancel();
+    ++m_generation;
+
+    m_path.clear();
+    m_source.reset(); // As tarefas em andamento mantêm a sua referência
+    m_color = false;
+    m_frameCount = 0;
+    m_ring.clear();
+    m_pending.clear();
+    m_inFlight = 0;
+    m_position = 0;
+    m_waiting = -1;
+    m_stats = Stats();
+}
+
+/**
+ * @brief Inicia a reprodução: zera os contadores e ancora o relógio no frame atual.
+ * @details O QTimer acorda a interface quatro vezes por frame (entre 1 e 15 ms): o frame
+ * devido é exibido no máximo um quarto de período depois do seu horário.
+ */
+void DicomCinePlayer::play() {
+    if (!isActive() || isPlaying()) {
+        return;
+    }
+    m_stats = Stats();
+    reanchor();
+    m_timer.start(qBound(1, int(1000.0 / m_frameRate / 4.0), 15));
+    emit playingChanged(true);
+    requestAhead();
+}
+
+void DicomCinePlayer::pause() {
+    if (!isPlaying()) {
+        return;
+    }
+    m_timer.stop();
+    emit playingChanged(false);
+}
+
+/**
+ * @brief Avança ou recua frames, pausando a reprodução.
+ * @details Recuar leva a posição para trás da janela do buffer; a posição é levada para
+ * o mesmo frame em uma volta não negativa e o frame é pedido se não estiver no buffer.
+ */
+void DicomCinePlayer::step(int delta) {
+    if (!isActive() || delta == 0) {
+        return;
+    }
+    pause();
+
+    qint64 target = windowStart() + delta;
+    if (target < 0) {
+        target += qint64(m_frameCount) * ((-target) / m_frameCount + 1);
+    }
+    seek(target);
+}
+
+int DicomCinePlayer::currentFrame() const {
+    return isActive() ? int(m_position % m_frameCount) : 0;
+}
+
+/**
+ * @brief Slot da posição, se ainda contiver exatamente o frame dessa posição.
+ */
+const DicomCinePlayer::Slot *DicomCinePlayer::buffered(qint64 position) const {
+    if (m_ring.isEmpty()) {
+        return nullptr;
+    }
+    const Slot &slot = m_ring.at(int(position % m_ring.size()));
+    return (slot.frame == int(position % m_frameCount)) ? &slot : nullptr;
+}
+
+/**
+ * @brief Abre o arquivo na primeira chamada; as tarefas seguintes recebem a mesma fonte.
+ * @details A abertura (mapeamento, Header e fragmentos) fica fora da thread da interface,
+ * na primeira tarefa; tarefas que chegam durante ela esperam pelo mutex.
+ */
+std::shared_ptr<const DicomFrameSource> DicomCinePlayer::Source::open() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!frames) {
+        frames = DicomManager::openFrameSource(path);
+    }
+    return frames;
+}
+
+void DicomCinePlayer::present(qint64 position) {
+    const Slot *slot = buffered(position);
+    if (slot == nullptr) {
+        return;
+    }
+    m_position = position;
+    m_waiting = -1;
+    ++m_stats.presented;
+    emit frameChanged(int(position % m_frameCount), slot->pixels, slot->image);
+    requestAhead();
+}
+
+void DicomCinePlayer::seek(qint64 position) {
+    if (buffered(position) != nullptr) {
+        present(position);
+        return;
+    }
+    m_waiting = position;
+    requestAhead();
+}
+
+void DicomCinePlayer::reanchor() {
+    m_anchorPosition = windowStart();
+    m_clock.start();
+}
+
+/**
+ * @brief Pede os frames da janela que ainda não estão no buffer nem em andamento.
+ * @details Percorre a janela a partir do início, então os blocos são pedidos na ordem de
+ * exibição. Um bloco nunca atravessa o fim do objeto (o loadFrames é de um intervalo
+ * contíguo) nem um frame já disponível.
+ */
+void DicomCinePlayer::requestAhead() {
+    if (!isActive()) {
+        return;
+    }
+
+    const int maxInFlight = DicomScheduler::instance().workerCount();
+    const qint64 start = windowStart();
+    const qint64 end = start + m_ring.size();
+
+    for (qint64 position = start; position < end && m_inFlight < maxInFlight; ++position) {
+        if (buffered(position) != nullptr || m_pending.contains(position)) {
+            continue;
+        }
+
+        const int frame = int(position % m_frameCount);
+        const int limit = int(std::min<qint64>({kChunkFrames, m_frameCount - frame, end - position}));
+        int count = 0;
+        while (count < limit && buffered(position + count) == nullptr && !m_pending.contains(position + count)) {
+            m_pending.insert(position + count);
+            ++count;
+        }
+
+        const std::shared_ptr<Source> source = m_source;
+        const bool color = m_color;
+        const quint64 generation = m_generation;
+        const DicomScheduler::CancellationToken token = m_token;
+        DicomScheduler::instance().submit(DicomScheduler::Priority::Interactive,
+                                          [this, source, color, frame, count, position, generation, token]() {
+            const std::shared_ptr<const DicomFrameSource> opened = source->open();
+            const DicomProgressCallback proceed = [token](int) { return !token.isCanceled(); };
+            QVector<DicomPixelData> frames;
+            QVector<QImage> images;
+            if (color) {
+                images = DicomManager::loadColorFrames(*opened, frame, count, proceed);
+            } else {
+                frames = DicomManager::loadFrames(*opened, frame, count, proceed);
+            }
+            emit jobFinished(generation, position, count, frames, images);
+        }, m_token);
+
+        ++m_inFlight;
+        position += count - 1;
+    }
+}
+
+/**
+ * @brief Relógio da reprodução: exibe o frame devido, contando descartes e atrasos.
+ * @details Etapas:
+ * 1. Enquanto um frame atrasado é aguardado, nada muda (o atraso já foi contado).
+ * 2. O frame devido é calculado pelo tempo desde a âncora; se nenhum novo frame venceu, retorna.
+ * 3. Frames vencidos entre o exibido e o devido são descartados (contados como tal).
+ * 4. O frame devido é exibido se estiver no buffer; senão conta um atraso e passa a aguardá-lo.
+ */
+void DicomCinePlayer::onTick() {
+    // [1] Aguardando decodificação
+    if (m_waiting >= 0) {
+        return;
+    }
+
+    // [2] Frame devido pelo relógio
+    const qint64 due = m_anchorPosition + qint64(double(m_clock.nsecsElapsed()) * m_frameRate / 1e9);
+    if (due <= m_position) {
+        return;
+    }
+
+    // [3] Interface atrasada: frames vencidos são pulados
+    if (due > m_position + 1) {
+        m_stats.dropped += int(due - m_position - 1);
+    }
+
+    // [4] Exibição ou espera
+    if (buffered(due) != nullptr) {
+        present(due);
+    } else {
+        ++m_stats.late;
+        seek(due);
+    }
+}
+
+/**
+ * @brief Recebe um bloco decodificado e o guarda no buffer.
+ * @details Frames cuja posição já saiu da janela são descartados. Se o frame aguardado
+ * chegou, é exibido e, durante a reprodução, o relógio é reancorado nele (os frames
+ * seguintes mantêm o intervalo normal em vez de vencerem todos de uma vez).
+ * Uma falha de decodificação pausa a reprodução.
+ */
+void DicomCinePlayer::onJobFinished(quint64 generation, qint64 position, int count, const QVector<DicomPixelData> &frames,
+                                    const QVector<QImage> &images) {
+    if (generation != m_generation) {
+        return; // Objeto substituído
+    }
+    --m_inFlight;
+
+    const int received = m_color ? images.size() : frames.size();
+    const qint64 start = windowStart();
+    for (int i = 0; i < count; ++i) {
+        const qint64 target = position + i;
+        m_pending.remove(target);
+        if (i < received && target >= start && target < start + m_ring.size()) {
+            Slot &slot = m_ring[int(target % m_ring.size())];
+            slot.frame = int(target % m_frameCount);
+            slot.pixels = m_color ? DicomPixelData() : frames.at(i);
+            slot.image = m_color ? images.at(i) : QImage();
+        }
+    }
+
+    if (received < count) {
+        qDebug() << "Cine: falha ao decodificar os frames" << position % m_frameCount << "a"
+                 << position % m_frameCount + count - 1 << "-" << m_path;
+        m_waiting = -1;
+        pause();
+        return;
+    }
+
+    if (m_waiting >= 0 && buffered(m_waiting) != nullptr) {
+        present(m_waiting);
+        if (isPlaying()) {
+            reanchor();
+        }
+        return; // present() já pediu os próximos
+    }
+    requestAhead();
+}
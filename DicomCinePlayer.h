@@ -0,0 +1,187 @@
+/**
+ * @file DicomCinePlayer.h
+ * @brief Definição do reprodutor cine de objetos multi-frame (ultrassom, XA, tomossíntese).
+ * @details Os frames são decodificados à frente da exibição, no DicomScheduler, para um
+ * buffer circular; a thread da interface apenas troca o frame exibido no ritmo do relógio.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMCINEPLAYER_H
+#define DICOMCINEPLAYER_H
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+#include <mutex>
+
+#include "DicomManager.h"
+#include "DicomScheduler.h"
+
+/**
+ * @class DicomCinePlayer
+ * @brief Reprodução (play/pause) dos frames de um objeto multi-frame na taxa de aquisição.
+ *
+ * Posições de reprodução crescem sem limite (o frame é posição % frameCount, então a
+ * repetição em laço não tem caso especial). O buffer circular guarda os frames das
+ * posições [atual, atual + capacidade), com a capacidade limitada por kRingBudget e por
+ * frameCount: objetos pequenos ficam inteiros no buffer e, em laço, não são decodificados
+ * de novo. Tarefas Interactive decodificam blocos de kChunkFrames frames com
+ * DicomManager::loadFrames (ou loadColorFrames, para objetos coloridos) e os entregam por
+ * sinal enfileirado. O arquivo é aberto uma única vez por objeto (openFrameSource), pela
+ * primeira tarefa; as demais reutilizam mapeamento, Header e tabela de fragmentos. No
+ * máximo workerCount() blocos ficam em andamento, pedidos na ordem em que serão exibidos.
+ *
+ * A exibição é guiada por um relógio monotônico (QElapsedTimer): o QTimer (PreciseTimer)
+ * apenas acorda a thread da interface algumas vezes por frame, e o frame devido é
+ * calculado pelo tempo decorrido desde a âncora, sem acumular atraso. Dois contadores
+ * medem a fluidez:
+ * - descartados: frames cujo horário passou sem a thread da interface conseguir exibi-los
+ *   (a reprodução salta direto para o frame devido);
+ * - atrasados: frames que ainda não estavam decodificados no seu horário (a reprodução
+ *   espera por eles e o relógio é reancorado quando chegam).
+ */
+class DicomCinePlayer : public QObject {
+    Q_OBJECT
+
+public:
+    static const int kChunkFrames = 4;                        ///< Frames por tarefa de decodificação
+    static const int kMinRingFrames = 4;                      ///< Capacidade mínima do buffer circular
+    static const int kMaxRingFrames = 64;                     ///< Capacidade máxima do buffer circular
+    static const qint64 kRingBudget = 256LL * 1024 * 1024;   ///< Memória do buffer circular (bytes)
+    static constexpr double kDefaultFrameRate = 10.0;         ///< Sem Frame Time / Cine Rate no arquivo
+
+    /**
+     * @struct Stats
+     * @brief Contadores da reprodução atual (zerados a cada play()).
+     */
+    struct Stats {
+        int presented = 0; ///< Frames exibidos
+        int dropped = 0;   ///< Frames pulados (interface atrasada)
+        int late = 0;      ///< Frames que não estavam decodificados no seu horário
+    };
+
+    /**
+     * @brief Construtor.
+     * @param parent Objeto pai.
+     */
+    explicit DicomCinePlayer(QObject *parent = nullptr);
+
+    /**
+     * @brief Destrutor. Descarta as decodificações pendentes e aguarda as em execução.
+     */
+    ~DicomCinePlayer() override;
+
+    /**
+     * @brief Define o objeto reproduzido, parado no primeiro frame.
+     * @param loaded Carregamento normal do objeto: caminho, Number of Frames (com 1 ou menos
+     * o reprodutor fica inativo), taxa (0 = kDefaultFrameRate) e o frame 0 já decodificado,
+     * em pixels nativos ou, para objetos coloridos, em 8 bits (DicomLoadResult::image).
+     */
+    void setSource(const DicomLoadResult &loaded);
+
+    /// Para a reprodução e esquece o objeto atual.
+    void clear();
+
+    /// Inicia a reprodução a partir do frame atual.
+    void play();
+
+    /// Pausa no frame atual.
+    void pause();
+
+    /// Alterna entre play() e pause().
+    void toggle() { isPlaying() ? pause() : play(); }
+
+    /**
+     * @brief Avança ou recua frames (com a reprodução pausada).
+     * @param delta Frames a avançar (negativo recua); o frame dá a volta nas extremidades.
+     */
+    void step(int delta);
+
+    bool isActive() const { return m_frameCount > 1; }         ///< Há objeto multi-frame
+    bool isColor() const { return m_color; }                   ///< Frames em 8 bits (objeto colorido)
+    bool isPlaying() const { return m_timer.isActive(); }      ///< Reprodução em andamento
+    int currentFrame() const;                                  ///< Frame exibido (0 = primeiro)
+    int frameCount() const { return m_frameCount; }            ///< Number of Frames do objeto
+    double frameRate() const { return m_frameRate; }           ///< Frames por segundo
+    Stats stats() const { return m_stats; }                    ///< Contadores da reprodução
+
+signals:
+    /// Novo frame a exibir (também emitido ao parar em um frame por step()). Só um dos dois
+    /// é não nulo: 'pixels' (nativos) ou 'image' (8 bits, objetos coloridos).
+    void frameChanged(int frame, const DicomPixelData &pixels, const QImage &image);
+
+    /// Reprodução iniciada ou pausada.
+    void playingChanged(bool playing);
+
+    // --- Sinal interno (threads de trabalho -> thread da interface) ---
+    void jobFinished(quint64 generation, qint64 position, int count, const QVector<DicomPixelData> &frames,
+                     const QVector<QImage> &images);
+
+private slots:
+    void onTick();
+    void onJobFinished(quint64 generation, qint64 position, int count, const QVector<DicomPixelData> &frames,
+                       const QVector<QImage> &images);
+
+private:
+    /// Posição do buffer circular.
+    struct Slot {
+        int frame = -1;         ///< Frame guardado (-1 = vazio)
+        DicomPixelData pixels;  ///< Frame decodificado (pixels nativos)
+        QImage image;           ///< Frame decodificado (8 bits, objetos coloridos)
+    };
+
+    /// Arquivo do objeto, aberto uma única vez pela primeira tarefa e compartilhado pelas demais.
+    struct Source {
+        QString path;                                    ///< Arquivo reproduzido
+        std::mutex mutex;                                ///< Protege 'frames'
+        std::shared_ptr<const DicomFrameSource> frames;  ///< Nulo até a primeira tarefa
+
+        /// Fonte aberta (abre na primeira chamada).
+        std::shared_ptr<const DicomFrameSource> open();
+    };
+
+    /// Slot da posição, se estiver no buffer (nulo caso contrário).
+    const Slot *buffered(qint64 position) const;
+
+    /// Exibe a posição (já no buffer) e avança a janela de decodificação.
+    void present(qint64 position);
+
+    /// Vai para uma posição: exibe se estiver no buffer, senão espera a decodificação.
+    void seek(qint64 position);
+
+    /// Reinicia o relógio com a posição atual no instante presente.
+    void reanchor();
+
+    /// Início da janela do buffer: a posição aguardada ou, sem espera, a exibida.
+    qint64 windowStart() const { return m_waiting >= 0 ? m_waiting : m_position; }
+
+    /// Enfileira blocos ainda não pedidos da janela [atual, atual + capacidade).
+    void requestAhead();
+
+    QString m_path;                                  ///< Arquivo reproduzido
+    std::shared_ptr<Source> m_source;                ///< Arquivo aberto (compartilhado com as tarefas)
+    bool m_color = false;                            ///< Frames em 8 bits (loadColorFrames)
+    int m_frameCount = 0;                            ///< Number of Frames
+    double m_frameRate = kDefaultFrameRate;          ///< Frames por segundo
+    QVector<Slot> m_ring;                            ///< Buffer circular (índice = posição % tamanho)
+    QSet<qint64> m_pending;                          ///< Posições com decodificação em andamento
+    int m_inFlight = 0;                              ///< Blocos em andamento
+    qint64 m_position = 0;                           ///< Posição exibida
+    qint64 m_waiting = -1;                           ///< Posição aguardando decodificação (-1 = nenhuma)
+    qint64 m_anchorPosition = 0;                     ///< Posição no instante da âncora
+    QElapsedTimer m_clock;                           ///< Relógio monotônico desde a âncora
+    QTimer m_timer;                                  ///< Acorda a interface durante a reprodução
+    Stats m_stats;                                   ///< Contadores da reprodução
+    quint64 m_generation = 0;                        ///< Incrementado a cada setSource/clear
+    DicomScheduler::CancellationToken m_lifetime;    ///< Pai dos tokens (cancelado no destrutor)
+    DicomScheduler::CancellationToken m_token;       ///< Decodificações do objeto atual
+};
+
+#endif // DICOMCINEPLAYER_H
@@ -0,0 +1,231 @@
+/**
+ * @file DicomDiskCache.cpp
+ * @brief Implementação do cache persistente de pixels DICOM (gravação e mapeamento em memória).
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomDiskCache.h"
+#include "DicomScheduler.h"
+#include "DicomLog.h"
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <memory>
+
+static const quint32 kMagic = 0x58495053;  ///< 'SPIX' (lido em little endian)
+static const quint32 kVersion = 1;         ///< Versão do formato
+static const qint64 kAlignment = 64;       ///< Alinhamento da área de dados e de cada nível
+static const qint64 kPreludeSize = 3 * sizeof(quint32); ///< magic + versão + tamanho do cabeçalho
+
+/// Diretório do cache (vazio = desativado). Definido uma única vez na inicialização.
+static QString s_directory;
+
+/// Arredonda um deslocamento para o próximo múltiplo de kAlignment.
+static qint64 alignUp(qint64 offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/**
+ * @brief Define o diretório e garante que ele exista.
+ */
+void DicomDiskCache::setDirectory(const QString &directory) {
+    s_directory = directory;
+    if (!s_directory.isEmpty() && !QDir().mkpath(s_directory)) {
+        qDebug() << "Cache em disco desativado (diretório inacessível):" << directory;
+        s_directory.clear();
+    }
+}
+
+/**
+ * @brief Indica se há um diretório de cache configurado.
+ */
+bool DicomDiskCache::isEnabled() {
+    return !s_directory.isEmpty();
+}
+
+/**
+ * @brief Nome do arquivo de cache: SHA-1 do caminho absoluto do .dcm + extensão .pix.
+ */
+QString DicomDiskCache::cacheFileFor(const QString &path) {
+    const QByteArray hash = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(),
+                                                     QCryptographicHash::Sha1);
+    return QDir(s_directory).filePath(QString::fromLatin1(hash.toHex()) + ".pix");
+}
+
+/**
+ * @brief Mapeia uma entrada válida do cache.
+ * @details Etapas:
+ * 1. Lê o prelúdio e o cabeçalho (poucos KB) e confere tamanho, data e SOPInstanceUID.
+ * 2. Mapeia a área de dados inteira com QFile::map (nenhum pixel é lido neste momento:
+ *    as páginas são carregadas pelo sistema operacional quando acessadas).
+ * 3. Cada nível da pirâmide recebe um std::shared_ptr que aponta para dentro do
+ *    mapeamento e o mantém vivo (construtor de aliasing).
+ */
+bool DicomDiskCache::load(const QString &path, const QString &sopInstanceUid, DicomLoadResult &result) {
+    if (!isEnabled()) {
+        return false;
+    }
+
+    const QFileInfo source(path);
+    auto file = std::make_shared<QFile>(cacheFileFor(path));
+    if (!source.exists() || !file->open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    // [1] Prelúdio + cabeçalho
+    QDataStream prelude(file.get());
+    prelude.setByteOrder(QDataStream::LittleEndian);
+    quint32 magic = 0, version = 0, headerSize = 0;
+    prelude >> magic >> version >> headerSize;
+    if (magic != kMagic || version != kVersion || headerSize == 0) {
+        return false;
+    }
+
+    QDataStream header(file->read(headerSize));
+    header.setVersion(QDataStream::Qt_5_6);
+
+    qint64 sourceSize = 0, sourceModified = 0;
+    QString storedUid;
+    header >> sourceSize >> sourceModified >> storedUid;
+    if (sourceSize != source.size() ||
+        sourceModified != source.lastModified().toMSecsSinceEpoch() ||
+        storedUid != sopInstanceUid) {
+        qCDebug(dicomPerf) << "Cache em disco desatualizado:" << path;
+        return false;
+    }
+
+    DicomMetadata metadata;
+    header >> metadata.patientName >> metadata.patientID >> metadata.studyDate
+           >> metadata.modality >> metadata.institution >> metadata.dimensions;
+    metadata.isValid = true;
+
+    quint32 levelCount = 0;
+    header >> levelCount;
+
+    QVector<DicomPixelData> levels;
+    QVector<qint64> offsets;
+    qint64 dataSize = 0;
+    for (quint32 i = 0; i < levelCount && header.status() == QDataStream::Ok; ++i) {
+        DicomPixelData level;
+        qint64 offset = 0;
+        header >> level.width >> level.height >> level.valueOffset
+               >> level.minStored >> level.maxStored
+               >> level.windowCenter >> level.windowWidth
+               >> level.sigmoid >> level.inverted >> offset;
+        if (level.width <= 0 || level.height <= 0 || offset < 0 || offset % kAlignment != 0) {
+            return false; // Cabeçalho corrompido
+        }
+        levels.append(level);
+        offsets.append(offset);
+        dataSize = std::max(dataSize, offset + level.byteSize());
+    }
+    if (header.status() != QDataStream::Ok || levels.isEmpty()) {
+        return false;
+    }
+
+    // [2] Mapeamento da área de dados
+    const qint64 dataStart = alignUp(kPreludeSize + headerSize);
+    if (file->size() < dataStart + dataSize) {
+        return false; // Arquivo truncado
+    }
+    uchar *mapped = file->map(dataStart, dataSize);
+    if (mapped == nullptr) {
+        return false;
+    }
+    // O deleter guarda o QFile: o mapeamento vive enquanto algum nível o referenciar
+    std::shared_ptr<uchar> mapping(mapped, [file](uchar *address) { file->unmap(address); });
+
+    // [3] Níveis apontando para o mapeamento (sem cópia)
+    for (int i = 0; i < levels.size(); ++i) {
+        levels[i].pixels = std::shared_ptr<const quint16>(
+            mapping, reinterpret_cast<const quint16 *>(mapped + offsets[i]));
+    }
+
+    result.pixels = levels.first();
+    result.pyramid = levels;
+    result.metadata = metadata;
+    return true;
+}
+
+/**
+ * @brief Grava uma entrada no formato descrito em DicomDiskCache.h.
+ * @details O cabeçalho é montado antes em memória para que o tamanho (e, portanto, o
+ * início alinhado da área de dados) seja conhecido. QSaveFile grava em um arquivo
+ * temporário e só o renomeia no commit(): um leitor nunca vê um arquivo pela metade.
+ */
+bool DicomDiskCache::store(const QString &path, const QString &sopInstanceUid, const DicomLoadResult &result) {
+    if (!isEnabled() || result.pyramid.isEmpty()) {
+        return false;
+    }
+
+    const QFileInfo source(path);
+    const DicomMetadata &meta = result.metadata;
+
+    // Cabeçalho em memória (deslocamentos relativos ao início da área de dados)
+    QByteArray headerBytes;
+    {
+        QDataStream header(&headerBytes, QIODevice::WriteOnly);
+        header.setVersion(QDataStream::Qt_5_6);
+        header << qint64(source.size()) << qint64(source.lastModified().toMSecsSinceEpoch()) << sopInstanceUid;
+        header << meta.patientName << meta.patientID << meta.studyDate
+               << meta.modality << meta.institution << meta.dimensions;
+        header << quint32(result.pyramid.size());
+
+        qint64 offset = 0;
+        for (const DicomPixelData &level : result.pyramid) {
+            header << level.width << level.height << level.valueOffset
+                   << level.minStored << level.maxStored
+                   << level.windowCenter << level.windowWidth
+                   << level.sigmoid << level.inverted << offset;
+            offset = alignUp(offset + level.byteSize());
+        }
+    }
+
+    QSaveFile file(cacheFileFor(path));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    QDataStream prelude(&file);
+    prelude.setByteOrder(QDataStream::LittleEndian);
+    prelude << kMagic << kVersion << quint32(headerBytes.size());
+    file.write(headerBytes);
+
+    // Área de dados: cada nível começa em um múltiplo de kAlignment
+    const QByteArray padding(int(kAlignment), '\0');
+    qint64 position = kPreludeSize + headerBytes.size();
+    for (const DicomPixelData &level : result.pyramid) {
+        const qint64 aligned = alignUp(position);
+        file.write(padding.constData(), aligned - position);
+        file.write(reinterpret_cast<const char *>(level.pixels.get()), level.byteSize());
+        position = aligned + level.byteSize();
+    }
+
+    if (!file.commit()) {
+        qDebug() << "Falha ao gravar cache em disco:" << file.fileName() << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Grava a entrada fora do caminho do carregamento (prioridade Background).
+ */
+void DicomDiskCache::storeInBackground(const QString &path, const QString &sopInstanceUid, const DicomLoadResult &result) {
+    if (!isEnabled() || result.pyramid.isEmpty()) {
+        return;
+    }
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Background, [path, sopInstanceUid, result]() {
+        store(path, sopInstanceUid, result);
+    });
+}
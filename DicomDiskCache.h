@@ -0,0 +1,79 @@
+/**
+ * @file DicomDiskCache.h
+ * @brief Definição do cache persistente (em disco) de pixels DICOM decodificados.
+ * @details Guarda os pixels em profundidade nativa (todos os níveis da pirâmide) e os
+ * metadados do overlay em um arquivo binário próprio. Reabrir o mesmo exame em outro dia
+ * mapeia esse arquivo na memória (mmap) em vez de passar novamente pelo codec.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMDISKCACHE_H
+#define DICOMDISKCACHE_H
+
+#include <QString>
+
+#include "DicomManager.h"
+
+/**
+ * @class DicomDiskCache
+ * @brief Classe utilitária estática para gravar e mapear pixels decodificados em disco.
+ *
+ * Formato do arquivo (autodescritivo, ordem de bytes da máquina):
+ * - Prelúdio: magic 'SPIX', versão e tamanho do cabeçalho (3 x quint32).
+ * - Cabeçalho (QDataStream): tamanho, data de modificação e SOPInstanceUID do .dcm de
+ *   origem, metadados do overlay e, para cada nível da pirâmide, dimensões, faixa,
+ *   janela inicial e deslocamento dos pixels na área de dados.
+ * - Área de dados: os níveis em quint16, cada um alinhado em 64 bytes.
+ *
+ * Uma entrada só é usada se tamanho, data de modificação e SOPInstanceUID do arquivo de
+ * origem forem os mesmos da gravação. O cache fica desativado até setDirectory() ser chamado.
+ */
+class DicomDiskCache {
+public:
+    /**
+     * @brief Define o diretório do cache (vazio desativa). Chamar na inicialização.
+     * @param directory Diretório onde os arquivos .pix são gravados (criado se não existir).
+     */
+    static void setDirectory(const QString &directory);
+
+    /**
+     * @brief Indica se o cache em disco está ativo.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Mapeia os pixels de um arquivo previamente gravado, se ainda for válido.
+     * @details Os pixels ficam apontando para o arquivo mapeado; o mapeamento é desfeito
+     * quando a última cópia do DicomPixelData deixa de existir.
+     * @param path Caminho do .dcm de origem.
+     * @param sopInstanceUid SOPInstanceUID lido do Header do arquivo de origem.
+     * @param result Destino (pixels, pirâmide e metadados); inalterado em caso de ausência.
+     * @return true se a entrada existia e era válida.
+     */
+    static bool load(const QString &path, const QString &sopInstanceUid, DicomLoadResult &result);
+
+    /**
+     * @brief Grava os pixels nativos e metadados de um resultado recém-decodificado.
+     * @details A gravação é atômica (arquivo temporário + renomeação). Imagens sem pixels
+     * nativos (coloridas) não são gravadas.
+     * @param path Caminho do .dcm de origem.
+     * @param sopInstanceUid SOPInstanceUID do arquivo de origem.
+     * @param result Resultado completo de DicomManager::loadDicomFile.
+     * @return true se o arquivo foi gravado.
+     */
+    static bool store(const QString &path, const QString &sopInstanceUid, const DicomLoadResult &result);
+
+    /**
+     * @brief Agenda store() em uma tarefa Background do DicomScheduler e retorna na hora.
+     * @details O resultado é copiado (os pixels são compartilhados, sem cópia), então quem
+     * chama pode entregá-lo sem esperar a gravação de todos os níveis da pirâmide.
+     */
+    static void storeInBackground(const QString &path, const QString &sopInstanceUid, const DicomLoadResult &result);
+
+private:
+    /// Caminho do arquivo de cache correspondente a um .dcm (hash do caminho absoluto).
+    static QString cacheFileFor(const QString &path);
+};
+
+#endif // DICOMDISKCACHE_H
@@ -0,0 +1,193 @@
+/**
+ * @file DicomImageItem.cpp
+ * @brief Implementação do item gráfico com pirâmide de resolução, blocos e janelamento.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomImageItem.h"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <cmath>
+
+/**
+ * @brief Chave única de um bloco no cache: nível (16 bits) + linha (24 bits) + coluna (24 bits).
+ */
+static quint64 tileKey(int level, int tx, int ty) {
+    return (quint64(level) << 48) | (quint64(ty) << 24) | quint64(tx);
+}
+
+/**
+ * @brief Construtor. Começa com a janela inicial sugerida pelo arquivo.
+ * @details A flag ItemUsesExtendedStyleOption faz o Qt preencher option->exposedRect,
+ * que delimita os blocos a processar em cada pintura.
+ * @param pyramid Níveis da pirâmide (não pode ser vazio).
+ * @param parent Item pai.
+ */
+DicomImageItem::DicomImageItem(const QVector<DicomPixelData> &pyramid, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_levels(pyramid),
+      m_tiles(kTileCacheBytes) {
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+
+    if (!m_levels.isEmpty()) {
+        m_center = m_levels.first().windowCenter;
+        m_width = m_levels.first().windowWidth;
+    }
+}
+
+/**
+ * @brief Altera a janela. Os blocos visíveis são renderizados novamente na próxima pintura.
+ */
+void DicomImageItem::setWindowLevel(double center, double width) {
+    m_center = center;
+    m_width = width;
+    m_tiles.clear();
+    update();
+}
+
+/**
+ * @brief Troca os pixels. Se o tamanho mudar, a cena é avisada antes (boundingRect).
+ */
+void DicomImageItem::setPyramid(const QVector<DicomPixelData> &pyramid) {
+    if (pyramid.isEmpty()) {
+        return;
+    }
+    const DicomPixelData &base = pyramid.first();
+    if (m_levels.isEmpty() || base.width != m_levels.first().width || base.height != m_levels.first().height) {
+        prepareGeometryChange();
+    }
+    m_levels = pyramid;
+    m_tiles.clear();
+    update();
+}
+
+/**
+ * @brief Retângulo do item: tamanho original da imagem, centralizado na origem.
+ */
+QRectF DicomImageItem::boundingRect() const {
+    if (m_levels.isEmpty()) {
+        return QRectF();
+    }
+    const DicomPixelData &base = m_levels.first();
+    return QRectF(-base.width / 2.0, -base.height / 2.0, base.width, base.height);
+}
+
+/**
+ * @brief Escolhe o nível mais reduzido que ainda tem pelo menos um pixel por pixel de tela.
+ * @details Com zoom de 0,3x, por exemplo, o nível 1 (0,5x) é usado: 2,2x menos pixels
+ * que o original, sem perda visível de detalhe.
+ */
+int DicomImageItem::levelForDetail(qreal levelOfDetail) const {
+    if (levelOfDetail <= 0.0 || levelOfDetail >= 1.0) {
+        return 0;
+    }
+    const int level = int(std::floor(std::log2(1.0 / levelOfDetail)));
+    return qBound(0, level, m_levels.size() - 1);
+}
+
+/**
+ * @brief Retorna um bloco renderizado com a janela atual.
+ * @details Blocos da borda podem ser menores que kTileSize. O custo no cache é o tamanho
+ * em bytes da imagem, então o limite kTileCacheBytes vale independentemente do nível.
+ */
+const QImage *DicomImageItem::tile(int level, int tx, int ty) {
+    const quint64 key = tileKey(level, tx, ty);
+    if (QImage *cached = m_tiles.object(key)) {
+        return cached;
+    }
+
+    const QRect region(tx * kTileSize, ty * kTileSize, kTileSize, kTileSize);
+    QImage *image = new QImage(DicomManager::renderWindow(m_levels[level], m_center, m_width, region));
+    if (image->isNull()) {
+        delete image;
+        return nullptr;
+    }
+
+    const int cost = int(image->sizeInBytes());
+    m_tiles.insert(key, image, cost);
+    return m_tiles.object(key);
+}
+
+/**
+ * @brief Desenha os blocos visíveis do nível da pirâmide adequado ao zoom atual.
+ * @details Etapas:
+ * 1. Calcula o nível de detalhe a partir da transformação do painter (zoom da view).
+ * 2. Converte a área exposta para coordenadas de pixel do nível e determina os blocos.
+ * 3. Obtém cada bloco do cache (ou o renderiza) e o desenha direto, sem imagem intermediária.
+ *    Com zoom e pan (sem rotação nem espelhamento), as bordas dos blocos são arredondadas
+ *    para pixels do dispositivo pela mesma função, então blocos vizinhos se encostam sem
+ *    frestas nem sobreposição na interpolação.
+ * A suavização só é usada ao reduzir; ao ampliar, os pixels são mostrados sem interpolação.
+ */
+void DicomImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+
+    if (m_levels.isEmpty()) {
+        return;
+    }
+
+    const QRectF bounds = boundingRect();
+    const QRectF exposed = option->exposedRect.intersected(bounds);
+    if (exposed.isEmpty()) {
+        return;
+    }
+
+    // [1] Nível de detalhe (pixels de tela por pixel da imagem)
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const int level = levelForDetail(lod);
+    const DicomPixelData &pixels = m_levels[level];
+    const qreal factor = qreal(1 << level);
+
+    // [2] Área exposta em pixels do nível -> intervalo de blocos
+    const QRect levelArea = QRectF((exposed.left() - bounds.left()) / factor,
+                                   (exposed.top() - bounds.top()) / factor,
+                                   exposed.width() / factor,
+                                   exposed.height() / factor)
+                                .toAlignedRect()
+                                .intersected(QRect(0, 0, pixels.width, pixels.height));
+    if (levelArea.isEmpty()) {
+        return;
+    }
+
+    const int tx0 = levelArea.left() / kTileSize;
+    const int ty0 = levelArea.top() / kTileSize;
+    const int tx1 = levelArea.right() / kTileSize;
+    const int ty1 = levelArea.bottom() / kTileSize;
+
+    // [3] Blocos visíveis direto no dispositivo
+    const QTransform transform = painter->worldTransform();
+    const bool aligned = transform.type() <= QTransform::TxScale && transform.m11() > 0.0 && transform.m22() > 0.0;
+    // Borda (coluna/linha do nível) em coordenadas do item e, alinhada, em pixels do dispositivo
+    auto edgeX = [&](int x) -> qreal {
+        const qreal itemX = bounds.left() + x * factor;
+        return aligned ? qreal(qRound(transform.m11() * itemX + transform.dx())) : itemX;
+    };
+    auto edgeY = [&](int y) -> qreal {
+        const qreal itemY = bounds.top() + y * factor;
+        return aligned ? qreal(qRound(transform.m22() * itemY + transform.dy())) : itemY;
+    };
+
+    painter->save();
+    painter->setClipRect(bounds, Qt::IntersectClip);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, lod < 1.0);
+    if (aligned) {
+        painter->setWorldTransform(QTransform()); // O recorte já foi mapeado para o dispositivo
+    }
+    for (int ty = ty0; ty <= ty1; ++ty) {
+        for (int tx = tx0; tx <= tx1; ++tx) {
+            const QImage *block = tile(level, tx, ty);
+            if (block == nullptr) {
+                continue;
+            }
+            const int left = tx * kTileSize;
+            const int top = ty * kTileSize;
+            const QRectF target(QPointF(edgeX(left), edgeY(top)),
+                                QPointF(edgeX(left + block->width()), edgeY(top + block->height())));
+            painter->drawImage(target, *block);
+        }
+    }
+    painter->restore();
+}
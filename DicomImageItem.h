@@ -0,0 +1,81 @@
+/**
+ * @file DicomImageItem.h
+ * @brief Definição do item gráfico que exibe uma imagem DICOM por blocos (tiles).
+ * @details Substitui o QGraphicsPixmapItem de resolução completa: o item escolhe o nível da
+ * pirâmide mais próximo do zoom atual e renderiza apenas os blocos visíveis desse nível.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMIMAGEITEM_H
+#define DICOMIMAGEITEM_H
+
+#include <QCache>
+#include <QGraphicsItem>
+#include <QImage>
+#include <QVector>
+
+#include "DicomManager.h"
+
+/**
+ * @class DicomImageItem
+ * @brief QGraphicsItem que desenha pixels nativos com Window/Level, nível de detalhe e blocos.
+ *
+ * O item ocupa, em coordenadas de cena, o tamanho da imagem original centralizado na origem
+ * (mesma convenção do setOffset(-w/2, -h/2) usado anteriormente). Ao desenhar:
+ * - escolhe o nível da pirâmide com resolução suficiente para os pixels de tela;
+ * - divide esse nível em blocos de kTileSize x kTileSize e processa só os que intersectam a
+ *   área exposta;
+ * - mantém os blocos já renderizados em um cache LRU limitado em bytes, de modo que
+ *   regiões fora da tela são descartadas quando a memória é necessária.
+ */
+class DicomImageItem : public QGraphicsItem {
+public:
+    static const int kTileSize = 256;                    ///< Lado do bloco (pixels do nível)
+    static const int kTileCacheBytes = 64 * 1024 * 1024; ///< Limite do cache de blocos
+
+    /**
+     * @brief Construtor.
+     * @param pyramid Níveis da pirâmide (DicomManager::buildPyramid); o nível 0 define o tamanho.
+     * @param parent Item pai.
+     */
+    explicit DicomImageItem(const QVector<DicomPixelData> &pyramid, QGraphicsItem *parent = nullptr);
+
+    /**
+     * @brief Altera a janela e descarta os blocos renderizados com a janela anterior.
+     * @param center Window Center em valores de modalidade.
+     * @param width Window Width em valores de modalidade.
+     */
+    void setWindowLevel(double center, double width);
+
+    /**
+     * @brief Troca os pixels exibidos mantendo a janela atual (ex.: próximo frame do cine).
+     * @param pyramid Novos níveis (não pode ser vazio).
+     */
+    void setPyramid(const QVector<DicomPixelData> &pyramid);
+
+    /// Pixels em resolução completa (nível 0).
+    const DicomPixelData &basePixels() const { return m_levels.first(); }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    /**
+     * @brief Escolhe o nível da pirâmide para uma escala de exibição.
+     * @param levelOfDetail Pixels de tela por pixel da imagem original.
+     */
+    int levelForDetail(qreal levelOfDetail) const;
+
+    /**
+     * @brief Retorna o bloco (level, tx, ty) renderizado, gerando-o se não estiver em cache.
+     */
+    const QImage *tile(int level, int tx, int ty);
+
+    QVector<DicomPixelData> m_levels;  ///< Pirâmide em profundidade nativa
+    QCache<quint64, QImage> m_tiles;   ///< Blocos em 8 bits (LRU, custo = bytes)
+    double m_center = 0.0;             ///< Window Center atual
+    double m_width = 1.0;              ///< Window Width atual
+};
+
+#endif // DICOMIMAGEITEM_H
@@ -0,0 +1,79 @@
+/**
+ * @file DicomIndex.cpp
+ * @brief Implementação do índice em memória Paciente -> Estudo -> Série -> Instância.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomIndex.h"
+
+/**
+ * @brief Insere uma instância na hierarquia.
+ * @details Cada nível é localizado pelo QHash de UID; se não existir, é criado no fim do
+ * vetor com os dados descritivos da primeira instância que o referencia.
+ */
+bool DicomIndex::add(const DicomInstanceInfo &info, Location *location) {
+    if (!info.isValid || m_sopInstanceUids.contains(info.sopInstanceUID)) {
+        return false;
+    }
+    m_sopInstanceUids.insert(info.sopInstanceUID);
+
+    Location where;
+
+    // Paciente
+    auto patientIt = m_patientIndex.constFind(info.patientID);
+    if (patientIt == m_patientIndex.constEnd()) {
+        DicomPatientNode patient;
+        patient.id = info.patientID;
+        patient.name = info.patientName;
+        m_patients.append(patient);
+        patientIt = m_patientIndex.insert(info.patientID, m_patients.size() - 1);
+    }
+    where.patient = patientIt.value();
+    DicomPatientNode &patient = m_patients[where.patient];
+
+    // Estudo
+    auto studyIt = patient.studyIndex.constFind(info.studyInstanceUID);
+    if (studyIt == patient.studyIndex.constEnd()) {
+        DicomStudyNode study;
+        study.uid = info.studyInstanceUID;
+        study.date = info.studyDate;
+        study.description = info.studyDescription;
+        patient.studies.append(study);
+        studyIt = patient.studyIndex.insert(info.studyInstanceUID, patient.studies.size() - 1);
+    }
+    where.study = studyIt.value();
+    DicomStudyNode &study = patient.studies[where.study];
+
+    // Série
+    auto seriesIt = study.seriesIndex.constFind(info.seriesInstanceUID);
+    if (seriesIt == study.seriesIndex.constEnd()) {
+        DicomSeriesNode series;
+        series.uid = info.seriesInstanceUID;
+        series.description = info.seriesDescription;
+        series.modality = info.modality;
+        series.number = info.seriesNumber;
+        study.series.append(series);
+        seriesIt = study.seriesIndex.insert(info.seriesInstanceUID, study.series.size() - 1);
+    }
+    where.series = seriesIt.value();
+    DicomSeriesNode &series = study.series[where.series];
+
+    // Instância
+    series.instances.append(info);
+    where.instance = series.instances.size() - 1;
+
+    if (location != nullptr) {
+        *location = where;
+    }
+    return true;
+}
+
+/**
+ * @brief Esvazia o índice.
+ */
+void DicomIndex::clear() {
+    m_patients.clear();
+    m_patientIndex.clear();
+    m_sopInstanceUids.clear();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file DicomIndex.h
+ * @brief Definição do índice em memória Paciente -> Estudo -> Série -> Instância.
+ * @details Alimentado pelo DicomScanner à medida que os Headers são lidos; serve de base
+ * para o navegador de pastas (DicomBrowser).
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMINDEX_H
+#define DICOMINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "DicomManager.h"
+
+/**
+ * @struct DicomSeriesNode
+ * @brief Série: instâncias com o mesmo Series Instance UID.
+ */
+struct DicomSeriesNode {
+    QString uid;                           ///< Series Instance UID
+    QString description;                   ///< Series Description
+    QString modality;                      ///< Modalidade
+    int number = 0;                        ///< Series Number
+    QVector<DicomInstanceInfo> instances;  ///< Instâncias (ordem de chegada)
+};
+
+/**
+ * @struct DicomStudyNode
+ * @brief Estudo: séries com o mesmo Study Instance UID.
+ */
+struct DicomStudyNode {
+    QString uid;                       ///< Study Instance UID
+    QString date;                      ///< Study Date (YYYYMMDD)
+    QString description;               ///< Study Description
+    QVector<DicomSeriesNode> series;   ///< Séries do estudo
+    QHash<QString, int> seriesIndex;   ///< Series Instance UID -> posição em 'series'
+};
+
+/**
+ * @struct DicomPatientNode
+ * @brief Paciente: estudos com o mesmo Patient ID.
+ */
+struct DicomPatientNode {
+    QString id;                        ///< Patient ID
+    QString name;                      ///< Nome do paciente
+    QVector<DicomStudyNode> studies;   ///< Estudos do paciente
+    QHash<QString, int> studyIndex;    ///< Study Instance UID -> posição em 'studies'
+};
+
+/**
+ * @class DicomIndex
+ * @brief Hierarquia Paciente -> Estudo -> Série -> Instância montada incrementalmente.
+ *
+ * Cada nível é um vetor com um QHash de UID -> posição, de modo que inserir uma instância
+ * custa O(1) e as posições dos nós nunca mudam (apenas crescem), permitindo que a interface
+ * guarde referências por posição. Instâncias repetidas (mesmo SOP Instance UID, por
+ * exemplo cópias do mesmo arquivo em pastas diferentes) são ignoradas.
+ */
+class DicomIndex {
+public:
+    /**
+     * @struct Location
+     * @brief Posição de uma instância inserida na hierarquia.
+     */
+    struct Location {
+        int patient = -1;  ///< Posição em patients()
+        int study = -1;    ///< Posição em DicomPatientNode::studies
+        int series = -1;   ///< Posição em DicomStudyNode::series
+        int instance = -1; ///< Posição em DicomSeriesNode::instances
+    };
+
+    /**
+     * @brief Insere uma instância, criando paciente/estudo/série se necessário.
+     * @param info Tags da instância (isValid deve ser true).
+     * @param location Destino opcional com a posição da instância.
+     * @return false se a instância for inválida ou já estiver no índice.
+     */
+    bool add(const DicomInstanceInfo &info, Location *location = nullptr);
+
+    /// Remove todos os nós.
+    void clear();
+
+    /// Pacientes indexados.
+    const QVector<DicomPatientNode> &patients() const { return m_patients; }
+
+    /// Total de instâncias indexadas.
+    int instanceCount() const { return m_sopInstanceUids.size(); }
+
+private:
+    QVector<DicomPatientNode> m_patients;  ///< Pacientes (ordem de chegada)
+    QHash<QString, int> m_patientIndex;    ///< Patient ID -> posição em m_patients
+    QSet<QString> m_sopInstanceUids;       ///< Instâncias já indexadas
+};
+
+#endif // DICOMINDEX_H
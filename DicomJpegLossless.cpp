@@ -0,0 +1,433 @@
+/**
+ * @file DicomJpegLossless.cpp
+ * @brief Implementação do decodificador JPEG Lossless (Processo 14, seleção de preditor 1).
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomJpegLossless.h"
+#include "DicomScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+const char *const DicomJpegLossless::kTransferSyntax = "1.2.840.10008.1.2.4.70";
+
+/// Intervalos de restart por tarefa: poucos por núcleo, para dividir a carga sem tarefas minúsculas.
+static const int kBatchesPerWorker = 4;
+
+static const int kLookupSize = 1 << DicomJpegLossless::kLookupBits;
+
+/**
+ * @struct LookupEntry
+ * @brief Resultado da consulta rápida de Huffman para os próximos kLookupBits bits.
+ */
+struct LookupEntry {
+    qint32 diff = 0;      ///< Diferença pronta (válida se total > 0)
+    quint8 total = 0;     ///< Bits do código + bits extras; 0 = ler a categoria em separado
+    quint8 length = 0;    ///< Bits do código; 0 = código mais longo que a consulta
+    quint8 category = 0;  ///< SSSS (bits extras da diferença)
+};
+
+/**
+ * @struct HuffmanTable
+ * @brief Tabela de Huffman de diferenças (classe 0) pronta para a decodificação.
+ */
+struct HuffmanTable {
+    bool defined = false;
+    std::vector<LookupEntry> lookup;  ///< kLookupSize entradas
+    int maxCode[18];                  ///< Maior código de cada comprimento (-1 = nenhum)
+    int minCode[17];                  ///< Menor código de cada comprimento
+    int valuePointer[17];             ///< Índice em values do primeiro código de cada comprimento
+    quint8 values[256];               ///< Categorias em ordem de código
+};
+
+/**
+ * @struct ScanInfo
+ * @brief Parâmetros do frame e da varredura lidos dos marcadores.
+ */
+struct ScanInfo {
+    int precision = 0;            ///< P (bits por amostra)
+    int rows = 0;                 ///< Y
+    int columns = 0;              ///< X
+    int component = -1;           ///< Identificador do único componente
+    int predictor = 0;            ///< Ss
+    int pointTransform = 0;       ///< Al (Pt)
+    int restartInterval = 0;      ///< Ri (amostras; 0 = sem restart)
+    const HuffmanTable *table = nullptr;
+    const uchar *entropy = nullptr; ///< Início dos dados codificados
+};
+
+/**
+ * @brief Diferença com sinal a partir dos bits extras (F.2.2.1, EXTEND).
+ */
+static inline int extend(int value, int category) {
+    return value < (1 << (category - 1)) ? value - (1 << category) + 1 : value;
+}
+
+/**
+ * @brief Monta a tabela a partir de BITS (quantidade por comprimento) e HUFFVAL (Anexo C).
+ * @return false se os códigos não couberem nos comprimentos ou houver categoria inválida.
+ */
+static bool buildTable(const quint8 *counts, const quint8 *symbols, int symbolCount, HuffmanTable &table) {
+    table.lookup.assign(size_t(kLookupSize), LookupEntry());
+    std::memcpy(table.values, symbols, size_t(symbolCount));
+
+    int code = 0;
+    int index = 0;
+    for (int length = 1; length <= 16; ++length) {
+        table.valuePointer[length] = index;
+        table.minCode[length] = code;
+        for (int i = 0; i < counts[length - 1]; ++i, ++index, ++code) {
+            const int category = symbols[index];
+            if (category > 16 || code >= (1 << length)) {
+                return false;
+            }
+            if (length > DicomJpegLossless::kLookupBits) {
+                continue;
+            }
+
+            // Todas as entradas que começam com este código
+            const int freeBits = DicomJpegLossless::kLookupBits - length;
+            const int first = code << freeBits;
+            for (int entry = first; entry < first + (1 << freeBits); ++entry) {
+                LookupEntry &e = table.lookup[size_t(entry)];
+                e.length = quint8(length);
+                e.category = quint8(category);
+                if (category == 0 || category == 16) {
+                    e.total = quint8(length);           // Sem bits extras
+                    e.diff = (category == 16) ? 32768 : 0;
+                } else if (length + category <= DicomJpegLossless::kLookupBits) {
+                    const int extra = (entry >> (freeBits - category)) & ((1 << category) - 1);
+                    e.total = quint8(length + category);
+                    e.diff = extend(extra, category);
+                }
+            }
+        }
+        table.maxCode[length] = counts[length - 1] ? code - 1 : -1;
+        code <<= 1;
+    }
+    table.maxCode[17] = 0x7FFFFFFF;
+    table.defined = true;
+    return true;
+}
+
+/**
+ * @struct BitReader
+ * @brief Leitura de bits de um intervalo (MSB primeiro), removendo o byte 0x00 após 0xFF.
+ * @details Um marcador (0xFF seguido de outro byte) encerra os dados: dali em diante entram
+ * zeros, e padding conta quantos bytes foram inventados para detectar fluxos truncados.
+ */
+struct BitReader {
+    const uchar *pos;
+    const uchar *end;
+    quint64 buffer = 0; ///< Bits alinhados à esquerda
+    int bits = 0;       ///< Bits válidos em buffer
+    int padding = 0;    ///< Bytes zero acrescentados após o fim
+
+    BitReader(const uchar *begin, const uchar *stop) : pos(begin), end(stop) {}
+
+    void refill() {
+        while (bits <= 56) {
+            quint64 byte = 0;
+            if (pos < end) {
+                byte = *pos++;
+                if (byte == 0xFF) {
+                    if (pos < end && *pos == 0x00) {
+                        ++pos; // Byte de enchimento
+                    } else {
+                        pos = end; // Marcador: fim dos dados
+                        byte = 0;
+                        ++padding;
+                    }
+                }
+            } else {
+                ++padding;
+            }
+            buffer |= byte << (56 - bits);
+            bits += 8;
+        }
+    }
+
+    int peek(int count) const { return int(buffer >> (64 - count)); }
+    void skip(int count) { buffer <<= count; bits -= count; }
+
+    /// Bits além dos dados reais foram consumidos.
+    bool overrun() const { return padding * 8 - bits > 0; }
+};
+
+/**
+ * @brief Próxima diferença (F.2.2.1 / F.2.2.3) pela tabela de consulta.
+ * @return false se o código não existir na tabela.
+ */
+static inline bool decodeDiff(BitReader &reader, const HuffmanTable &table, int &diff) {
+    if (reader.bits < 32) {
+        reader.refill(); // Código (até 16 bits) + bits extras (até 15)
+    }
+    const LookupEntry &entry = table.lookup[size_t(reader.peek(DicomJpegLossless::kLookupBits))];
+    if (entry.total != 0) {
+        reader.skip(entry.total);
+        diff = entry.diff;
+        return true;
+    }
+
+    int category = entry.category;
+    if (entry.length != 0) {
+        reader.skip(entry.length);
+    } else {
+        // Código longo: procedimento canônico a partir de kLookupBits + 1 bits
+        int length = DicomJpegLossless::kLookupBits + 1;
+        int code = reader.peek(length);
+        while (length <= 16 && code > table.maxCode[length]) {
+            ++length;
+            code = reader.peek(length);
+        }
+        if (length > 16) {
+            return false;
+        }
+        category = table.values[table.valuePointer[length] + code - table.minCode[length]];
+        reader.skip(length);
+    }
+
+    if (category == 0) {
+        diff = 0;
+    } else if (category == 16) {
+        diff = 32768;
+    } else {
+        diff = extend(reader.peek(category), category);
+        reader.skip(category);
+    }
+    return true;
+}
+
+/**
+ * @brief Decodifica as linhas [firstRow, firstRow + rowCount) de um intervalo de restart.
+ * @details Preditor 1 (H.1.2.1): a primeira amostra do intervalo parte de 2^(P - Pt - 1),
+ * o resto da primeira linha da amostra à esquerda; nas linhas seguintes, a primeira coluna
+ * parte da amostra acima e as demais da esquerda. A reconstrução é módulo 2^16 e a
+ * amostra de saída é deslocada de Pt bits.
+ */
+static bool decodeRows(const uchar *begin, const uchar *end, const ScanInfo &scan,
+                       int firstRow, int rowCount, quint16 *output) {
+    BitReader reader(begin, end);
+    const HuffmanTable &table = *scan.table;
+    const int columns = scan.columns;
+    const int shift = scan.pointTransform;
+
+    int above = 1 << (scan.precision - shift - 1); // Predição da primeira coluna
+    quint16 *row = output + qint64(firstRow) * columns;
+    for (int r = 0; r < rowCount; ++r, row += columns) {
+        int diff = 0;
+        if (!decodeDiff(reader, table, diff)) {
+            return false;
+        }
+        int left = (above + diff) & 0xFFFF;
+        above = left;
+        row[0] = quint16(left << shift);
+
+        for (int x = 1; x < columns; ++x) {
+            if (!decodeDiff(reader, table, diff)) {
+                return false;
+            }
+            left = (left + diff) & 0xFFFF;
+            row[x] = quint16(left << shift);
+        }
+    }
+    return !reader.overrun();
+}
+
+/**
+ * @brief Lê os marcadores até o início dos dados codificados (SOS).
+ * @return false se a estrutura não for a suportada.
+ */
+static bool parseHeader(const uchar *stream, size_t length, HuffmanTable tables[4], ScanInfo &scan) {
+    if (length < 4 || stream[0] != 0xFF || stream[1] != 0xD8) {
+        return false; // Sem SOI
+    }
+
+    const uchar *pos = stream + 2;
+    const uchar *end = stream + length;
+    while (pos + 4 <= end) {
+        if (*pos != 0xFF) {
+            return false;
+        }
+        while (pos < end && *pos == 0xFF) {
+            ++pos; // Bytes de preenchimento antes do marcador
+        }
+        if (pos + 3 > end) {
+            return false;
+        }
+        const int marker = *pos++;
+        const int size = (pos[0] << 8) | pos[1];
+        const uchar *segment = pos + 2;
+        if (size < 2 || segment + (size - 2) > end) {
+            return false;
+        }
+
+        switch (marker) {
+            case 0xC3: // SOF3: lossless, Huffman, sequencial
+                if (size != 11 || segment[5] != 1) {
+                    return false; // Um componente
+                }
+                scan.precision = segment[0];
+                scan.rows = (segment[1] << 8) | segment[2];
+                scan.columns = (segment[3] << 8) | segment[4];
+                scan.component = segment[6];
+                break;
+
+            case 0xC0: case 0xC1: case 0xC2: case 0xC5: case 0xC6: case 0xC7:
+            case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                return false; // Outros processos (DCT, hierárquico, aritmético)
+
+            case 0xC4: { // DHT: uma ou mais tabelas
+                const uchar *table = segment;
+                const uchar *stop = segment + (size - 2);
+                while (table + 17 <= stop) {
+                    const int tableClass = table[0] >> 4;
+                    const int id = table[0] & 0x0F;
+                    int symbols = 0;
+                    for (int i = 1; i <= 16; ++i) {
+                        symbols += table[i];
+                    }
+                    if (tableClass != 0 || id > 3 || symbols > 256 || table + 17 + symbols > stop ||
+                        !buildTable(table + 1, table + 17, symbols, tables[id])) {
+                        return false;
+                    }
+                    table += 17 + symbols;
+                }
+                break;
+            }
+
+            case 0xDD: // DRI
+                if (size != 4) {
+                    return false;
+                }
+                scan.restartInterval = (segment[0] << 8) | segment[1];
+                break;
+
+            case 0xDA: { // SOS: um componente, preditor e transformação de ponto
+                if (size != 8 || segment[0] != 1 || segment[1] != scan.component || scan.component < 0) {
+                    return false;
+                }
+                const int id = segment[2] >> 4;
+                scan.predictor = segment[3];
+                scan.pointTransform = segment[5] & 0x0F;
+                if (id > 3 || !tables[id].defined) {
+                    return false;
+                }
+                scan.table = &tables[id];
+                scan.entropy = segment + (size - 2);
+                return true;
+            }
+
+            case 0xD8: case 0xD9: case 0xDC: // SOI, EOI ou DNL fora de lugar
+                return false;
+
+            default: // APPn, COM, DQT...: ignorados
+                break;
+        }
+        pos = segment + (size - 2);
+    }
+    return false;
+}
+
+bool DicomJpegLossless::supports(const QByteArray &transferSyntax) {
+    return transferSyntax == kTransferSyntax;
+}
+
+/**
+ * @brief Decodifica um frame.
+ * @details Etapas:
+ * 1. Marcadores: SOF3, tabelas de Huffman, DRI e SOS, validados contra o subconjunto.
+ * 2. Intervalos: os dados codificados são divididos nos marcadores RSTn (numeração
+ *    conferida); com Ri múltiplo de uma linha, cada intervalo cobre linhas inteiras.
+ * 3. Os intervalos são agrupados em lotes decodificados em paralelo (a thread chamadora
+ *    participa, então a chamada pode vir de uma tarefa do escalonador); com parallel =
+ *    false, em sequência na thread chamadora.
+ */
+bool DicomJpegLossless::decode(const uchar *stream, size_t length, int columns, int rows, quint16 *output,
+                               bool parallel) {
+    // [1] Marcadores
+    HuffmanTable tables[4];
+    ScanInfo scan;
+    if (stream == nullptr || output == nullptr || !parseHeader(stream, length, tables, scan)) {
+        return false;
+    }
+    if (scan.predictor != 1 || scan.precision < 2 || scan.precision > 16 || scan.pointTransform >= scan.precision ||
+        scan.columns != columns || scan.rows != rows || columns <= 0 || rows <= 0) {
+        return false;
+    }
+    int rowsPerInterval = rows;
+    if (scan.restartInterval > 0) {
+        if (scan.restartInterval % columns != 0) {
+            return false; // Restart no meio da linha
+        }
+        rowsPerInterval = scan.restartInterval / columns;
+    }
+    const int intervals = (rows + rowsPerInterval - 1) / rowsPerInterval;
+
+    // [2] Limites de cada intervalo
+    const uchar *end = stream + length;
+    std::vector<const uchar *> starts{scan.entropy};
+    std::vector<const uchar *> stops;
+    const uchar *pos = scan.entropy;
+    while (pos + 1 < end) {
+        pos = static_cast<const uchar *>(std::memchr(pos, 0xFF, size_t(end - pos - 1)));
+        if (pos == nullptr) {
+            break;
+        }
+        const int next = pos[1];
+        if (next == 0x00 || next == 0xFF) {
+            pos += (next == 0x00) ? 2 : 1; // Enchimento
+            continue;
+        }
+        if (next >= 0xD0 && next <= 0xD7) {
+            if (next != 0xD0 + int((starts.size() - 1) % 8) || int(starts.size()) >= intervals) {
+                return false; // Numeração fora de ordem ou restarts demais
+            }
+            stops.push_back(pos);
+            starts.push_back(pos + 2);
+            pos += 2;
+            continue;
+        }
+        break; // EOI (ou outro marcador): fim da varredura
+    }
+    stops.push_back(pos != nullptr && pos + 1 < end ? pos : end);
+    if (int(starts.size()) != intervals) {
+        return false;
+    }
+
+    // [3] Lotes de intervalos em paralelo
+    auto decodeInterval = [&](int i) {
+        const int firstRow = i * rowsPerInterval;
+        return decodeRows(starts[size_t(i)], stops[size_t(i)], scan, firstRow,
+                          std::min(rowsPerInterval, rows - firstRow), output);
+    };
+    if (intervals == 1) {
+        return decodeInterval(0);
+    }
+    if (!parallel) {
+        for (int i = 0; i < intervals; ++i) {
+            if (!decodeInterval(i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    DicomScheduler &scheduler = DicomScheduler::instance();
+    const int batches = std::min(intervals, std::max(1, scheduler.workerCount()) * kBatchesPerWorker);
+    std::atomic_bool failed{false};
+    scheduler.parallelFor(batches, [&](int batch) {
+        const int first = int(qint64(intervals) * batch / batches);
+        const int last = int(qint64(intervals) * (batch + 1) / batches);
+        for (int i = first; i < last && !failed.load(); ++i) {
+            if (!decodeInterval(i)) {
+                failed.store(true);
+            }
+        }
+    });
+    return !failed.load();
+}
@@ -0,0 +1,70 @@
+/**
+ * @file DicomJpegLossless.h
+ * @brief Definição do decodificador JPEG Lossless (Processo 14, seleção de preditor 1).
+ * @details Caminho rápido para a sintaxe 1.2.840.10008.1.2.4.70, a mais comum em mamografia:
+ * decodificação de Huffman por tabela e reconstrução do preditor 1 escritas direto no
+ * plano de 16 bits de destino, com os intervalos de restart decodificados em paralelo.
+ * O que não for suportado fica com a DCMTK (dcmjpeg).
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMJPEGLOSSLESS_H
+#define DICOMJPEGLOSSLESS_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <cstddef>
+
+/**
+ * @class DicomJpegLossless
+ * @brief Decodificador JPEG Lossless SV1 (classe utilitária estática).
+ *
+ * Suporta o subconjunto usado pela sintaxe 1.2.840.10008.1.2.4.70: SOF3 com um componente,
+ * precisão de 2 a 16 bits, preditor 1 (amostra à esquerda; acima na primeira coluna),
+ * transformação de ponto qualquer e intervalos de restart múltiplos de uma linha.
+ *
+ * - Huffman: cada tabela vira uma tabela de consulta de kLookupBits bits; códigos curtos
+ *   cuja categoria (SSSS) também cabe na consulta já saem com a diferença pronta, sem
+ *   segunda leitura de bits. Códigos mais longos seguem o procedimento canônico (F.2.2.3).
+ * - Reconstrução: as amostras são escritas direto no buffer de destino (16 bits), e a
+ *   linha anterior é lida dele mesmo.
+ * - Restart: os marcadores RSTn são localizados antes da decodificação; cada intervalo
+ *   recomeça o preditor e é decodificado em uma tarefa do DicomScheduler.
+ *
+ * Qualquer outra estrutura (SOF diferente, vários componentes, outro preditor, DNL,
+ * restart no meio da linha, dados truncados) faz decode() retornar false, e quem chama
+ * recorre à DCMTK.
+ */
+class DicomJpegLossless {
+public:
+    static const int kLookupBits = 11; ///< Bits da tabela de consulta de Huffman
+
+    /// UID da sintaxe de transferência suportada (JPEG Lossless, Non-Hierarchical, First-Order Prediction).
+    static const char *const kTransferSyntax;
+
+    /**
+     * @brief Indica se a sintaxe de transferência é a suportada.
+     * @param transferSyntax UID lido do Meta Header (sem preenchimento, como em DicomMappedFile).
+     */
+    static bool supports(const QByteArray &transferSyntax);
+
+    /**
+     * @brief Decodifica um frame.
+     * @param stream Fluxo JPEG completo (SOI ... EOI), fragmentos já concatenados.
+     * @param length Tamanho do fluxo em bytes.
+     * @param columns Colunas esperadas (Columns do Header).
+     * @param rows Linhas esperadas (Rows do Header).
+     * @param output Destino: columns * rows amostras, exatamente como codificadas (sem
+     * máscara de Bits Stored nem extensão de sinal).
+     * @param parallel false decodifica os intervalos de restart em sequência, só na thread
+     * chamadora (medições comparáveis com decodificadores de uma thread).
+     * @return true se decodificado; false se o fluxo não for suportado ou estiver inconsistente
+     * (o conteúdo de output fica indefinido).
+     */
+    static bool decode(const uchar *stream, size_t length, int columns, int rows, quint16 *output,
+                       bool parallel = true);
+};
+
+#endif // DICOMJPEGLOSSLESS_H
@@ -0,0 +1,384 @@
+/**
+ * @file DicomLoader.cpp
+ * @brief Implementação do carregador assíncrono de arquivos DICOM.
+ * @details A decodificação roda no DicomScheduler; o progresso e o resultado voltam para a
+ * thread da interface através de sinais enfileirados.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomLoader.h"
+#include "DicomCache.h"
+#include "DicomLog.h"
+
+
+/**
+ * @brief Construtor. Registra os tipos usados nos sinais enfileirados.
+ * @details Os tokens da requisição e da pré-carga começam como filhos de m_lifetime já
+ * cancelados; cada load() e prefetch() cria um filho novo.
+ * @param parent Objeto pai (gerenciamento de memória do Qt).
+ */
+DicomLoader::DicomLoader(QObject *parent)
+    : QObject(parent),
+      m_cancelToken(m_lifetime.child()),
+      m_prefetchToken(m_lifetime.child()) {
+    qRegisterMetaType<DicomLoadResult>("DicomLoadResult");
+    qRegisterMetaType<DicomPreview>("DicomPreview");
+    qRegisterMetaType<DicomSeriesResult>("DicomSeriesResult");
+
+    m_cancelToken.cancel();
+    m_prefetchToken.cancel();
+
+    // Conexões explícitas como enfileiradas: o slot sempre roda na thread da interface
+    connect(this, &DicomLoader::jobProgress, this, &DicomLoader::onJobProgress, Qt::QueuedConnection);
+    connect(this, &DicomLoader::jobPreview, this, &DicomLoader::onJobPreview, Qt::QueuedConnection);
+    connect(this, &DicomLoader::jobFinished, this, &DicomLoader::onJobFinished, Qt::QueuedConnection);
+    connect(this, &DicomLoader::jobSeries, this, &DicomLoader::onJobSeries, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destrutor. Cancela todas as tarefas do carregador e aguarda as que estão em execução.
+ * @details As tarefas referenciam 'this'; as que ainda estão na fila são descartadas pelo
+ * escalonador, e o objeto só é destruído depois que nenhuma está executando.
+ */
+DicomLoader::~DicomLoader() {
+    m_lifetime.cancel();
+    m_lifetime.waitForIdle();
+}
+
+/**
+ * @brief Inicia o carregamento assíncrono de um arquivo.
+ * @details Etapas:
+ * 1. Cancela a requisição anterior (se houver) sem esperar por ela.
+ * 2. Cria um novo token de cancelamento e um novo identificador de requisição.
+ * 3. Se o arquivo já está sendo decodificado (pré-carga), a requisição se anexa a essa
+ *    decodificação: recebe o progresso e o resultado dela. Se a pré-carga ainda está na
+ *    fila, uma tarefa Visible é enfileirada para a mesma decodificação (quem começar
+ *    primeiro decodifica), o que a promove à frente das demais pré-cargas.
+ * 4. Consulta o DicomCache: se o arquivo (mesmo tamanho e data) já foi decodificado, o
+ *    resultado é entregue sem passar pelo escalonador, pelo mesmo sinal enfileirado.
+ * 5. Caso contrário, registra a decodificação e enfileira com prioridade Visible a leitura
+ *    da pré-visualização (só Header) seguida do DicomManager::loadDicomFile (runDecode).
+ * @param path O caminho completo para o arquivo .dcm.
+ */
+void DicomLoader::load(const QString &path) {
+    cancel();
+
+    const quint64 requestId = ++m_requestId;
+    const CancellationToken token = m_lifetime.child();
+    m_cancelToken = token;
+    m_activePath = path;
+
+    // [3] Decodificação do mesmo arquivo em andamento
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    std::shared_ptr<PendingDecode> pending = m_pending.value(path);
+    if (pending) {
+        bool started = false;
+        {
+            std::lock_guard<std::mutex> pendingLock(pending->mutex);
+            if (!pending->finished) {
+                pending->requestId = requestId;
+                pending->requestToken = token;
+                started = pending->started;
+            } else {
+                pending.reset(); // Concluída: o resultado já está no DicomCache
+            }
+        }
+        if (pending) {
+            if (!started) {
+                DicomScheduler::instance().submit(DicomScheduler::Priority::Visible, [this, path, pending]() {
+                    runDecode(path, pending);
+                }, token);
+            }
+            return;
+        }
+    }
+
+    // [4] Cache de imagens decodificadas
+    DicomLoadResult cached;
+    if (DicomCache::instance().find(DicomCache::keyFor(path), cached)) {
+        qCDebug(dicomPerf) << "Cache de imagens: acerto -" << path;
+        emit jobFinished(requestId, cached); // Enfileirado: chega depois do retorno de load()
+        return;
+    }
+
+    // [5] Nova decodificação
+    pending = std::make_shared<PendingDecode>();
+    pending->requestId = requestId;
+    pending->requestToken = token;
+    m_pending.insert(path, pending);
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Visible, [this, path, pending]() {
+        runDecode(path, pending);
+    }, token);
+}
+
+/**
+ * @brief Decodifica um arquivo para o DicomCache e entrega o resultado à requisição anexada.
+ * @details Etapas:
+ * 1. Assume a decodificação; se outra tarefa já a assumiu (ou ninguém mais espera por
+ *    ela), retorna sem fazer nada.
+ * 2. Com uma requisição já anexada, lê e entrega a pré-visualização (só Header).
+ * 3. Executa o DicomManager::loadDicomFile. O progresso vai para a requisição anexada no
+ *    momento, e o carregamento é abandonado quando ninguém mais espera o resultado. Se uma
+ *    pré-carga abandonada ganhou uma requisição nesse meio tempo, decodifica de novo.
+ * 4. Guarda o resultado no DicomCache antes de marcar a decodificação como concluída (um
+ *    load() que a encontre concluída acha o resultado no cache) e o entrega.
+ */
+void DicomLoader::runDecode(const QString &path, const std::shared_ptr<PendingDecode> &pending) {
+    // [1] Uma única decodificação por arquivo
+    quint64 requestId = 0;
+    CancellationToken token;
+    bool abandoned = false;
+    {
+        std::lock_guard<std::mutex> lock(pending->mutex);
+        if (pending->started) {
+            return;
+        }
+        pending->started = true;
+        abandoned = !pending->wanted();
+        pending->finished = abandoned;
+        requestId = pending->requestId;
+        token = pending->requestToken;
+    }
+    if (abandoned) {
+        releasePending(path, pending); // Fora de pending->mutex (ordem: mapa, depois entrada)
+        return;
+    }
+
+    // [2] Pré-visualização
+    if (requestId != 0) {
+        const DicomPreview preview = DicomManager::loadPreview(path);
+        if (preview.isValid() && !token.isCanceled()) {
+            emit jobPreview(requestId, preview);
+        }
+    }
+
+    // [3] Decodificação
+    const QString cacheKey = DicomCache::keyFor(path);
+    DicomLoadResult result;
+    for (;;) {
+        result = DicomManager::loadDicomFile(path, [this, pending](int percent) {
+            std::lock_guard<std::mutex> lock(pending->mutex);
+            if (!pending->wanted()) {
+                return false;
+            }
+            if (pending->requestId != 0 && !pending->requestToken.isCanceled()) {
+                emit jobProgress(pending->requestId, percent);
+            }
+            return true;
+        });
+
+        // [4] Cache, conclusão e entrega
+        DicomCache::instance().insert(cacheKey, result);
+        std::lock_guard<std::mutex> lock(pending->mutex);
+        if (!result.canceled || !pending->wanted()) {
+            pending->finished = true;
+            requestId = pending->requestId;
+            break;
+        }
+    }
+
+    releasePending(path, pending);
+    if (requestId != 0) {
+        emit jobFinished(requestId, result);
+    }
+}
+
+/**
+ * @brief Remove a decodificação do mapa; uma entrada mais nova do mesmo caminho é mantida.
+ */
+void DicomLoader::releasePending(const QString &path, const std::shared_ptr<PendingDecode> &pending) {
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    auto it = m_pending.find(path);
+    if (it != m_pending.end() && it.value() == pending) {
+        m_pending.erase(it);
+    }
+}
+
+/**
+ * @brief Inicia o empilhamento de uma série.
+ * @details Como em load(): cancela a requisição anterior, cria token e identificador novos
+ * e enfileira com prioridade Visible o DicomManager::loadSeries, que por sua vez divide a
+ * leitura dos Headers e a decodificação dos cortes entre todas as threads do escalonador.
+ */
+void DicomLoader::loadSeries(const QStringList &paths) {
+    cancel();
+    if (paths.isEmpty()) {
+        return;
+    }
+
+    const quint64 requestId = ++m_requestId;
+    const CancellationToken token = m_lifetime.child();
+    m_cancelToken = token;
+    m_activePath = paths.first();
+
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Visible, [this, paths, requestId, token]() {
+        const DicomSeriesResult result = DicomManager::loadSeries(paths, [this, requestId, token](int percent) {
+            if (token.isCanceled()) {
+                return false;
+            }
+            emit jobProgress(requestId, percent);
+            return true;
+        });
+        emit jobSeries(requestId, result);
+    }, token);
+}
+
+/**
+ * @brief Inicia a decodificação de todos os frames de um objeto em um volume.
+ * @details Como em loadSeries(); os metadados são lidos do Header depois do volume.
+ */
+void DicomLoader::loadVolume(const QString &path) {
+    cancel();
+
+    const quint64 requestId = ++m_requestId;
+    const CancellationToken token = m_lifetime.child();
+    m_cancelToken = token;
+    m_activePath = path;
+
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Visible, [this, path, requestId, token]() {
+        DicomSeriesResult result;
+        result.volume = DicomManager::loadVolume(path, [this, requestId, token](int percent) {
+            if (token.isCanceled()) {
+                return false;
+            }
+            emit jobProgress(requestId, percent);
+            return true;
+        });
+        result.canceled = token.isCanceled();
+        if (result.isValid()) {
+            result.paths.append(path);
+            result.metadata = DicomManager::extractMetadata(path); // Dimensões já incluem os frames
+        }
+        emit jobSeries(requestId, result);
+    }, token);
+}
+
+/**
+ * @brief Enfileira a decodificação de arquivos vizinhos direto no DicomCache.
+ * @details As tarefas entram com prioridade Prefetch, então um arquivo pedido pelo usuário
+ * passa à frente das pré-cargas que ainda não começaram, e as que já começaram nunca ocupam
+ * todas as threads. Etapas:
+ * 1. Cancela a pré-carga anterior e descarta do mapa as decodificações que ela deixou na
+ *    fila sem requisição anexada (o escalonador não vai executá-las).
+ * 2. Arquivos já em decodificação (pré-carga anterior ou requisição visível) passam a ser
+ *    pedidos também pela nova pré-carga, sem nova tarefa; os que estão em cache são ignorados.
+ * 3. Os demais ganham uma decodificação registrada e uma tarefa Prefetch (runDecode).
+ */
+void DicomLoader::prefetch(const QStringList &paths) {
+    m_prefetchToken.cancel();
+    const CancellationToken token = m_lifetime.child();
+    m_prefetchToken = token;
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    // [1] Pré-cargas anteriores que não chegaram a começar
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        std::lock_guard<std::mutex> pendingLock(it.value()->mutex);
+        if (!it.value()->started && !it.value()->wanted()) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const QString &path : paths) {
+        // [2] Já em decodificação ou em cache
+        const std::shared_ptr<PendingDecode> running = m_pending.value(path);
+        if (running) {
+            std::lock_guard<std::mutex> pendingLock(running->mutex);
+            running->prefetched = true;
+            running->prefetchToken = token;
+            continue;
+        }
+        if (DicomCache::instance().contains(DicomCache::keyFor(path))) {
+            continue;
+        }
+
+        // [3] Nova decodificação
+        const std::shared_ptr<PendingDecode> pending = std::make_shared<PendingDecode>();
+        pending->prefetched = true;
+        pending->prefetchToken = token;
+        m_pending.insert(path, pending);
+        DicomScheduler::instance().submit(DicomScheduler::Priority::Prefetch, [this, path, pending]() {
+            runDecode(path, pending);
+        }, token);
+    }
+}
+
+/**
+ * @brief Cancela a requisição ativa.
+ * @details O identificador é avançado para que o resultado tardio seja ignorado em onJobFinished.
+ */
+void DicomLoader::cancel() {
+    if (!isLoading()) {
+        return;
+    }
+
+    m_cancelToken.cancel();
+    ++m_requestId;
+
+    const QString path = m_activePath;
+    m_activePath.clear();
+    emit canceled(path);
+}
+
+/**
+ * @brief Repassa o progresso da thread de trabalho (apenas da requisição ativa).
+ */
+void DicomLoader::onJobProgress(quint64 requestId, int percent) {
+    if (requestId == m_requestId) {
+        emit progressChanged(percent);
+    }
+}
+
+/**
+ * @brief Repassa a pré-visualização (apenas da requisição ativa).
+ */
+void DicomLoader::onJobPreview(quint64 requestId, const DicomPreview &preview) {
+    if (requestId == m_requestId) {
+        emit previewReady(preview);
+    }
+}
+
+/**
+ * @brief Recebe o resultado da thread de trabalho e o publica para a interface.
+ * @details Resultados de requisições antigas (canceladas ou substituídas) são descartados.
+ */
+void DicomLoader::onJobFinished(quint64 requestId, const DicomLoadResult &result) {
+    if (requestId != m_requestId) {
+        qCDebug(dicomPerf) << "Resultado descartado (requisição cancelada):" << result.path;
+        return;
+    }
+
+    m_activePath.clear();
+
+    if (result.canceled) {
+        emit canceled(result.path);
+    } else if (!result.isValid()) {
+        emit failed(result.path);
+    } else {
+        emit loaded(result);
+    }
+}
+
+/**
+ * @brief Recebe o volume de uma série e o publica para a interface (apenas da requisição ativa).
+ */
+void DicomLoader::onJobSeries(quint64 requestId, const DicomSeriesResult &result) {
+    if (requestId != m_requestId) {
+        qCDebug(dicomPerf) << "Série descartada (requisição cancelada)";
+        return;
+    }
+
+    const QString path = m_activePath;
+    m_activePath.clear();
+
+    if (result.canceled) {
+        emit canceled(path);
+    } else if (!result.isValid()) {
+        emit failed(path);
+    } else {
+        emit seriesLoaded(result);
+    }
+}
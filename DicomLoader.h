@@ -0,0 +1,172 @@
+/**
+ * @file DicomLoader.h
+ * @brief Definição do carregador assíncrono de arquivos DICOM.
+ * @details Executa o DicomManager::loadDicomFile no DicomScheduler, mantendo a
+ * interface gráfica responsiva durante a descompressão de arquivos grandes.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMLOADER_H
+#define DICOMLOADER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <mutex>
+
+#include "DicomManager.h"
+#include "DicomScheduler.h"
+
+/**
+ * @class DicomLoader
+ * @brief Carrega arquivos DICOM fora da thread da interface, com progresso e cancelamento.
+ *
+ * Antes da decodificação completa, a pré-visualização embutida no arquivo (se houver) é
+ * entregue pelo sinal previewReady, reduzindo o tempo até o primeiro pixel na tela.
+ * Cada chamada a load() cria uma nova requisição e cancela a anterior: o usuário que abre
+ * um segundo arquivo não precisa esperar a decodificação do primeiro terminar.
+ * Os resultados são entregues à thread da interface por sinais enfileirados
+ * (Qt::QueuedConnection); resultados de requisições já canceladas são descartados.
+ *
+ * A imagem pedida roda com prioridade Visible e a pré-carga com Prefetch: vizinhos nunca
+ * atrasam o arquivo que o usuário abriu. Um arquivo nunca é decodificado duas vezes ao
+ * mesmo tempo: se load() pede um vizinho cuja pré-carga ainda está em andamento, a
+ * requisição se anexa a ela (e a promove a Visible se ainda não começou).
+ */
+class DicomLoader : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Construtor.
+     * @param parent Objeto pai (gerenciamento de memória do Qt).
+     */
+    explicit DicomLoader(QObject *parent = nullptr);
+
+    /**
+     * @brief Destrutor. Cancela as tarefas do carregador e aguarda as que estão em execução.
+     */
+    ~DicomLoader() override;
+
+    /**
+     * @brief Inicia o carregamento assíncrono de um arquivo, cancelando o anterior.
+     * @param path O caminho completo para o arquivo .dcm.
+     */
+    void load(const QString &path);
+
+    /**
+     * @brief Inicia o empilhamento assíncrono de uma série em um volume, cancelando o anterior.
+     * @details Mesma requisição única de load(): abrir um arquivo cancela a série e vice-versa.
+     * O resultado chega por seriesLoaded (não passa pelo DicomCache).
+     * @param paths Arquivos da série (qualquer ordem; DicomManager::loadSeries ordena).
+     */
+    void loadSeries(const QStringList &paths);
+
+    /**
+     * @brief Abre um objeto multi-frame (ex.: tomossíntese) inteiro como volume.
+     * @details Mesma requisição única de load(); o resultado chega por seriesLoaded, com o
+     * volume de DicomManager::loadVolume e um único caminho.
+     * @param path Arquivo multi-frame.
+     */
+    void loadVolume(const QString &path);
+
+    /**
+     * @brief Pré-carrega arquivos no DicomCache em segundo plano (baixa prioridade).
+     * @details Substitui a pré-carga anterior: tarefas ainda não concluídas são abandonadas.
+     * Arquivos que já estão em cache ou em decodificação são ignorados. Nenhum sinal é
+     * emitido; o benefício aparece quando load() encontra o arquivo no cache ou se anexa à
+     * decodificação em andamento.
+     * @param paths Arquivos a pré-carregar, em ordem de preferência.
+     */
+    void prefetch(const QStringList &paths);
+
+    /**
+     * @brief Cancela a requisição ativa (se houver).
+     * @details A DCMTK não permite interromper um codec no meio da descompressão: a thread
+     * de trabalho abandona o carregamento na próxima etapa e o resultado é descartado.
+     */
+    void cancel();
+
+    /**
+     * @brief Indica se existe uma requisição em andamento.
+     */
+    bool isLoading() const { return !m_activePath.isEmpty(); }
+
+signals:
+    /// Progresso (0-100) da requisição ativa.
+    void progressChanged(int percent);
+
+    /// Pré-visualização de baixa resolução da requisição ativa (antes de loaded).
+    void previewReady(const DicomPreview &preview);
+
+    /// Carregamento concluído com sucesso (imagem válida).
+    void loaded(const DicomLoadResult &result);
+
+    /// Série empilhada com sucesso (volume válido).
+    void seriesLoaded(const DicomSeriesResult &result);
+
+    /// Falha ao ler ou decodificar o arquivo.
+    void failed(const QString &path);
+
+    /// Requisição cancelada pelo usuário.
+    void canceled(const QString &path);
+
+    // --- Sinais internos (thread de trabalho -> thread da interface) ---
+    void jobProgress(quint64 requestId, int percent);
+    void jobPreview(quint64 requestId, const DicomPreview &preview);
+    void jobFinished(quint64 requestId, const DicomLoadResult &result);
+    void jobSeries(quint64 requestId, const DicomSeriesResult &result);
+
+private slots:
+    void onJobProgress(quint64 requestId, int percent);
+    void onJobPreview(quint64 requestId, const DicomPreview &preview);
+    void onJobFinished(quint64 requestId, const DicomLoadResult &result);
+    void onJobSeries(quint64 requestId, const DicomSeriesResult &result);
+
+private:
+    using CancellationToken = DicomScheduler::CancellationToken;
+
+    /**
+     * @struct PendingDecode
+     * @brief Decodificação de um arquivo em andamento, compartilhada por load() e prefetch().
+     * @details Campos protegidos por 'mutex'. O arquivo é decodificado enquanto alguém ainda
+     * espera por ele: a requisição visível anexada ou a pré-carga que o pediu.
+     */
+    struct PendingDecode {
+        std::mutex mutex;
+        bool started = false;             ///< Uma tarefa já assumiu a decodificação
+        bool finished = false;            ///< Resultado pronto (e já no DicomCache)
+        quint64 requestId = 0;            ///< Requisição visível anexada (0 = nenhuma)
+        CancellationToken requestToken;   ///< Token da requisição anexada
+        bool prefetched = false;          ///< Também pedido pela pré-carga
+        CancellationToken prefetchToken;  ///< Token da pré-carga que o pediu
+
+        /// Ainda há quem espere o resultado (chamar com 'mutex' travado).
+        bool wanted() const {
+            return (requestId != 0 && !requestToken.isCanceled()) || (prefetched && !prefetchToken.isCanceled());
+        }
+    };
+
+    /**
+     * @brief Decodifica o arquivo de 'pending' no DicomCache e entrega o resultado à requisição anexada.
+     * @details Chamado pelas tarefas Visible e Prefetch do mesmo arquivo; só a primeira decodifica.
+     */
+    void runDecode(const QString &path, const std::shared_ptr<PendingDecode> &pending);
+
+    /// Remove 'pending' do mapa de decodificações em andamento (se ainda for a entrada de 'path').
+    void releasePending(const QString &path, const std::shared_ptr<PendingDecode> &pending);
+
+    quint64 m_requestId = 0;                ///< Identificador da requisição ativa
+    QString m_activePath;                   ///< Arquivo em carregamento (vazio se ocioso)
+    CancellationToken m_lifetime;           ///< Pai de todos os tokens (cancelado no destrutor)
+    CancellationToken m_cancelToken;        ///< Token da requisição ativa
+    CancellationToken m_prefetchToken;      ///< Token da pré-carga atual
+    std::mutex m_pendingMutex;              ///< Protege m_pending (tarefas removem as concluídas)
+    QHash<QString, std::shared_ptr<PendingDecode>> m_pending; ///< Decodificações em andamento por caminho
+};
+
+#endif // DICOMLOADER_H
@@ -0,0 +1,11 @@
+/**
+ * @file DicomLog.cpp
+ * @brief Definição da categoria de log dos rastros de desempenho.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomLog.h"
+
+// Só avisos e acima por padrão: os rastros (qCDebug) não são emitidos sem QT_LOGGING_RULES
+Q_LOGGING_CATEGORY(dicomPerf, "dicom.perf", QtWarningMsg)
@@ -0,0 +1,17 @@
+/**
+ * @file DicomLog.h
+ * @brief Categoria de log dos rastros de desempenho (tempos, cache, pré-carga).
+ * @details Erros continuam em qDebug(); os rastros por operação ficam em dicomPerf, desligada
+ * por padrão. Para ligá-la: QT_LOGGING_RULES="dicom.perf.debug=true".
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMLOG_H
+#define DICOMLOG_H
+
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(dicomPerf)
+
+#endif // DICOMLOG_H
@@ -8,11 +8,17 @@
  */
 
 #include "DicomManager.h"
+#include "DicomDiskCache.h"
+#include "DicomJpegLossless.h"
+#include "DicomLog.h"
+#include "DicomMappedFile.h"
+#include "DicomScheduler.h"
 
 #define HAVE_CONFIG_H // Definição necessária para compilação da DCMTK em ambiente Windows
 
 #include <dcmtk/config/osconfig.h> 
 #include <dcmtk/dcmimgle/dcmimage.h>
+#include <dcmtk/dcmimgle/dipixel.h>  // Acesso aos pixels intermediários (pós Modality LUT)
 
 // Includes para leitura de Tags (Metadados)
 #include <dcmtk/dcmdata/dctk.h>      // Acesso genérico
@@ -20,6 +26,84 @@
 #include <dcmtk/dcmdata/dcdeftag.h>  // Definições das Tags (DCM_PatientName...)
 
 #include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // Intrínsecos SSE2 (kernel de janelamento)
+#endif
+
+/// Tamanho máximo (bytes) de um valor lido na extração de Header; valores maiores têm leitura adiada.
+static const Uint32 kHeaderMaxReadLength = 4096;
+
+/// Alinhamento (bytes) do bloco de um DicomVolume (linha de cache / registradores AVX-512).
+static const size_t kVoxelAlignment = 64;
+
+/// Abaixo desta quantidade de pixels as passadas por linhas rodam só na thread chamadora.
+static const qint64 kMinParallelPixels = 1 << 20;
+
+/**
+ * @brief Lê apenas o Header de um arquivo: para no PixelData e adia valores grandes.
+ * @param path O caminho absoluto ou relativo para o arquivo .dcm.
+ * @param fileformat Destino da leitura.
+ * @return OFCondition Status da DCMTK.
+ */
+static OFCondition loadHeader(const QString &path, DcmFileFormat &fileformat) {
+    return fileformat.loadFileUntilTag(path.toStdString().c_str(),
+                                       EXS_Unknown,
+                                       EGL_noChange,
+                                       kHeaderMaxReadLength,
+                                       ERM_autoDetect,
+                                       DCM_PixelData);
+}
+
+/**
+ * @brief Lê o arquivo inteiro, mas adia os valores grandes (PixelData) até serem acessados.
+ * @details Com a DicomImage em modo de acesso parcial (CIF_UsePartialAccessToPixelData),
+ * apenas os frames decodificados são lidos do disco.
+ */
+static OFCondition loadDeferred(const QString &path, DcmFileFormat &fileformat) {
+    return fileformat.loadFile(path.toStdString().c_str(), EXS_Unknown, EGL_noChange, kHeaderMaxReadLength);
+}
+
+/**
+ * @brief Number of Frames (0028,0008) do dataset; 1 se ausente.
+ */
+static int numberOfFrames(DcmDataset *dataset) {
+    Sint32 frames = 1;
+    dataset->findAndGetSint32(DCM_NumberOfFrames, frames);
+    return std::max<Sint32>(1, frames);
+}
+
+/**
+ * @brief Taxa de reprodução de um multi-frame, em frames por segundo.
+ * @details Frame Time (0018,1063, ms entre frames) é a taxa de aquisição; na falta dele,
+ * Cine Rate (0018,0040) e Recommended Display Frame Rate (0008,2144).
+ * @return 0 se o dataset não informa nenhuma das três.
+ */
+static double frameRate(DcmDataset *dataset) {
+    Float64 frameTime = 0.0;
+    if (dataset->findAndGetFloat64(DCM_FrameTime, frameTime).good() && frameTime > 0.0) {
+        return 1000.0 / frameTime;
+    }
+    Sint32 rate = 0;
+    if ((dataset->findAndGetSint32(DCM_CineRate, rate).good() && rate > 0) ||
+        (dataset->findAndGetSint32(DCM_RecommendedDisplayFrameRate, rate).good() && rate > 0)) {
+        return double(rate);
+    }
+    return 0.0;
+}
 
 /**
  * @brief Carrega um arquivo DICOM do disco e o converte para QImage.
@@ -27,15 +111,15 @@
  * 1. Carrega o arquivo usando a classe DicomImage da DCMTK.
  * 2. Verifica a integridade e o status do arquivo.
  * 3. Aplica o "Window Level/Width" (Contraste/Brilho) lendo as tags do arquivo ou calculando automaticamente.
- * 4. Renderiza os dados para 8 bits (Escala de Cinza).
- * 5. Converte o buffer de memória para o formato QImage do Qt.
+ * 4. Renderiza os dados para 8 bits (Escala de Cinza) diretamente no buffer da QImage.
+ * 5. Entrega o buffer à QImage, que passa a ser responsável por liberá-lo (sem cópia).
  * * @param path O caminho absoluto ou relativo para o arquivo .dcm.
- * @return QImage Uma imagem válida em formato Grayscale8 se o carregamento for bem-sucedido; 
+ * @return QImage Uma imagem válida em formato Grayscale8 (RGB888 se colorida) se o carregamento for bem-sucedido;
  * caso contrário, retorna uma QImage nula (QImage::isNull() == true).
  */
 QImage DicomManager::loadDicomImage(const QString &path) {
-    // Tenta carregar o arquivo DICOM. 
-    DicomImage *image = new DicomImage(path.toStdString().c_str());
+    // Tenta carregar o arquivo DICOM (multi-frame: apenas o primeiro frame é decodificado)
+    DicomImage *image = new DicomImage(path.toStdString().c_str(), CIF_UsePartialAccessToPixelData, 0, 1);
 
     // Verifica se a imagem foi carregada e se o status é 'Normal'
     if (image == nullptr || image->getStatus() != EIS_Normal) {
@@ -43,6 +127,58 @@ QImage DicomManager::loadDicomImage(const QString &path) {
         return QImage(); // Retorna imagem vazia indicando erro
     }
 
+    QImage result = renderImage(image);
+
+    delete image; // Libera a memória alocada pelo DCMTK
+    return result;
+}
+
+/**
+ * @brief Renderiza um frame da DicomImage em 8 bits com a janela já configurada nela.
+ * @details Aloca uma única vez o buffer final e pede à DCMTK que renderize os 8 bits
+ * diretamente nele; a QImage passa a ser dona do buffer (sem cópia). Imagens coloridas
+ * saem com as amostras intercaladas (R, G, B por pixel), o formato de RGB888.
+ * @param image Imagem DCMTK válida. A posse continua com o chamador.
+ * @param frame Frame da DicomImage (0 = primeiro frame carregado nela).
+ * @return QImage Imagem em Grayscale8 (ou RGB888 se colorida), ou QImage nula se a extração
+ * dos pixels falhar.
+ */
+static QImage outputImage(DicomImage *image, int frame = 0) {
+    const int width = image->getWidth();
+    const int height = image->getHeight();
+    const bool color = !image->isMonochrome();
+
+    // Aloca uma única vez o buffer final e pede à DCMTK que renderize os 8 bits diretamente nele
+    // (sobrecarga de getOutputData com buffer do chamador), sem buffer intermediário nem cópia.
+    const unsigned long size = image->getOutputDataSize(8);
+    if (size == 0) {
+        return QImage();
+    }
+    uchar *pixelData = new uchar[size];
+
+    if (image->getOutputData(pixelData, size, 8, static_cast<unsigned long>(frame))) {
+        // A QImage passa a ser dona do buffer: ele é liberado pela cleanup function quando a
+        // última cópia (QImage/QPixmap compartilhada) deixar de existir.
+        // O 4º parâmetro define o "bytesPerLine" (o buffer da DCMTK não tem padding),
+        // evitando falhas de segmentação se a linha da imagem não for múltiplo de 4 bytes.
+        return QImage(pixelData, width, height, color ? width * 3 : width,
+                      color ? QImage::Format_RGB888 : QImage::Format_Grayscale8,
+                      [](void *buffer) { delete[] static_cast<uchar *>(buffer); }, pixelData);
+    }
+
+    // Falha na extração dos pixels
+    delete[] pixelData;
+    return QImage();
+}
+
+/**
+ * @brief Aplica o janelamento inicial e renderiza a DicomImage em 8 bits.
+ * @details Etapas 3 a 5 do carregamento, compartilhadas por loadDicomImage e loadDicomFile.
+ * @param image Imagem DCMTK válida (status EIS_Normal). A posse continua com o chamador.
+ * @return QImage Imagem em Grayscale8 (RGB888 se colorida), ou QImage nula se a extração dos
+ * pixels falhar.
+ */
+QImage DicomManager::renderImage(DicomImage *image) {
     // --- Processamento de Contraste (Windowing) ---
     // Tenta aplicar o primeiro preset de janela (Window Center/Width) salvo no arquivo .
     // Isso garante que a visualização inicial seja a recomendada pelo radiologista/equipamento.
@@ -51,34 +187,16 @@ QImage DicomManager::loadDicomImage(const QString &path) {
         image->setMinMaxWindow();
     }
 
-    const int width = image->getWidth();
-    const int height = image->getHeight();
-    
-    // Extrai os dados de pixel renderizados em 8 bits (0-255).
-    uint8_t *pixelData = (uint8_t *)(image->getOutputData(8));
-
-    if (pixelData != nullptr) {
-        // Cria a QImage a partir do buffer bruto.
-        // width' como 4º parâmetro ajuda a definir o "bytesPerLine" ajudando a evitar 
-        // falhas de segmentação (crash) se a largura da imagem não for múltiplo de 4 bytes.
-        QImage result(pixelData, width, height, width, QImage::Format_Grayscale8);
-        
-        // Evita problemas de gerenciamento de memória fazendo uma cópia dos dados.
-        QImage finalImage = result.copy();
-        
-        delete image; // Libera a memória alocada pelo DCMTK
-        return finalImage;
-    }
-
-    // Limpeza em caso de falha na extração dos pixels
-    delete image;
-    return QImage();
+    return outputImage(image);
 }
 
 /**
  * @brief Extrai metadados textuais do arquivo DICOM (Overlay).
- * @details Utiliza DcmFileFormat para ler apenas o Header do arquivo.
- * Realiza conversão de encoding (Latin1) para suportar acentuação e formata a data.
+ * @details Utiliza DcmFileFormat::loadFileUntilTag para ler apenas o Header do arquivo:
+ * a leitura é interrompida ao encontrar o PixelData (7FE0,0010), que nunca é lido do disco.
+ * Valores grandes anteriores aos pixels (LUTs, blobs privados, ícones) também não são
+ * carregados: acima de kHeaderMaxReadLength eles ficam com leitura adiada (pulados no stream).
+ * Assim, o custo de I/O fica na ordem de kilobytes mesmo para mamografias de vários MB.
  * @param path O caminho absoluto ou relativo para o arquivo .dcm.
  * @return DicomMetadata Estrutura preenchida. Se falhar, retorna isValid = false.
  */
@@ -86,47 +204,1938 @@ DicomMetadata DicomManager::extractMetadata(const QString &path) {
     DicomMetadata data;
     DcmFileFormat fileformat;
 
-    // Carrega apenas a estrutura de dados (Header), sem carregar pixels (rápido)
-    if (fileformat.loadFile(path.toStdString().c_str()).good()) {
-        DcmDataset *dataset = fileformat.getDataset();
-        OFString tempVal;
+    // Carrega apenas o Header: para no PixelData e adia valores grandes (rápido)
+    OFCondition status = loadHeader(path, fileformat);
+    if (status.good()) {
+        data = readMetadata(fileformat.getDataset());
+    } else {
+        qDebug() << "Erro ao ler metadados do arquivo:" << path << status.text();
+        data.isValid = false;
+    }
 
-        // Lambda auxiliar para buscar tags com segurança e converter encoding
-        auto getTag = [&](const DcmTagKey &tag) -> QString {
-            if (dataset->findAndGetOFString(tag, tempVal).good()) {
-                return QString::fromLatin1(tempVal.c_str());
-            }
-            return "N/A";
-        };
+    return data;
+}
+
+/**
+ * @brief Lê as tags de identificação de uma instância a partir do Header.
+ * @details Usa a mesma leitura de extractMetadata (loadHeader): para no PixelData e adia
+ * valores maiores que kHeaderMaxReadLength, então o I/O por arquivo fica limitado a poucos KB.
+ * Arquivos que não são DICOM falham na leitura e retornam isValid = false.
+ * @param path O caminho absoluto ou relativo para o arquivo.
+ * @return DicomInstanceInfo Tags lidas (strings vazias para tags ausentes).
+ */
+DicomInstanceInfo DicomManager::extractInstanceInfo(const QString &path) {
+    DicomInstanceInfo info;
+    info.path = path;
+
+    DcmFileFormat fileformat;
+    if (loadHeader(path, fileformat).bad()) {
+        return info;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+
+    OFString tempVal;
+    auto getTag = [&](const DcmTagKey &tag) -> QString {
+        if (dataset->findAndGetOFString(tag, tempVal).good()) {
+            return QString::fromLatin1(tempVal.c_str()).trimmed();
+        }
+        return QString();
+    };
+
+    info.patientID         = getTag(DCM_PatientID);
+    info.patientName       = getTag(DCM_PatientName).replace("^", " ");
+    info.studyInstanceUID  = getTag(DCM_StudyInstanceUID);
+    info.studyDate         = getTag(DCM_StudyDate);
+    info.studyDescription  = getTag(DCM_StudyDescription);
+    info.seriesInstanceUID = getTag(DCM_SeriesInstanceUID);
+    info.seriesDescription = getTag(DCM_SeriesDescription);
+    info.sopInstanceUID    = getTag(DCM_SOPInstanceUID);
+    info.modality          = getTag(DCM_Modality);
+    info.seriesNumber      = getTag(DCM_SeriesNumber).toInt();
+    info.instanceNumber    = getTag(DCM_InstanceNumber).toInt();
+
+    info.isValid = !info.studyInstanceUID.isEmpty() &&
+                   !info.seriesInstanceUID.isEmpty() &&
+                   !info.sopInstanceUID.isEmpty();
+    return info;
+}
+
+/**
+ * @brief Lê a pré-visualização embutida (Icon Image Sequence) sem decodificar os pixels.
+ * @details Etapas:
+ * 1. Lê apenas o Header (loadFileUntilTag até o PixelData principal). O PixelData do ícone
+ *    fica dentro da sequência, antes dos pixels principais, e por isso é lido normalmente.
+ * 2. Preenche os metadados e as dimensões completas (Columns x Rows).
+ * 3. Constrói uma DicomImage sobre o item do ícone com a sintaxe de transferência do
+ *    arquivo: ícones encapsulados (ex.: JPEG Lossless) passam pelos codecs registrados,
+ *    mas só os seus poucos KB são descomprimidos.
+ * @param path O caminho absoluto ou relativo para o arquivo .dcm.
+ * @return DicomPreview Ícone e metadados; ícone nulo se o arquivo não tiver a sequência.
+ */
+DicomPreview DicomManager::loadPreview(const QString &path) {
+    DicomPreview preview;
+    preview.path = path;
+
+    // [1] Apenas o Header (mesma leitura rápida de extractMetadata)
+    DcmFileFormat fileformat;
+    OFCondition status = loadHeader(path, fileformat);
+    if (status.bad()) {
+        qDebug() << "Erro ao ler Header para pré-visualização:" << path << status.text();
+        return preview;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+
+    // [2] Metadados e dimensões da imagem completa
+    preview.metadata = readMetadata(dataset);
+    long cols = 0, rows = 0;
+    dataset->findAndGetLongInt(DCM_Columns, cols);
+    dataset->findAndGetLongInt(DCM_Rows, rows);
+    preview.fullSize = QSize(int(cols), int(rows));
+
+    // [3] Ícone embutido (opcional no padrão)
+    DcmItem *icon = nullptr;
+    if (dataset->findAndGetSequenceItem(DCM_IconImageSequence, icon, 0).bad() || icon == nullptr) {
+        return preview;
+    }
+
+    DicomImage image(icon, dataset->getOriginalXfer());
+    if (image.getStatus() != EIS_Normal) {
+        qDebug() << "Ícone inválido:" << DicomImage::getString(image.getStatus());
+        return preview;
+    }
+    preview.image = renderImage(&image);
+    return preview;
+}
+
+/**
+ * @brief Gera uma miniatura pelo caminho mais barato disponível.
+ * @details Etapas:
+ * 1. Ícone embutido (Icon Image Sequence): apenas o Header é lido e só o ícone é decodificado.
+ * 2. Sem ícone: decodifica só o primeiro frame (CIF_UsePartialAccessToPixelData, fcount = 1),
+ *    aplica a janela inicial e reduz com createScaledImage da DCMTK antes da conversão
+ *    para 8 bits, de modo que apenas a miniatura é renderizada.
+ * Em ambos os casos o resultado final é ajustado para caber em maxSize x maxSize.
+ * @param path O caminho absoluto ou relativo para o arquivo .dcm.
+ * @param maxSize Lado máximo da miniatura.
+ * @return QImage Miniatura em Grayscale8, ou nula se o arquivo não puder ser lido.
+ */
+QImage DicomManager::loadThumbnail(const QString &path, int maxSize) {
+    // [1] Ícone embutido
+    QImage thumbnail = loadPreview(path).image;
+
+    // [2] Primeiro frame reduzido pela DCMTK
+    if (thumbnail.isNull()) {
+        DicomImage image(path.toStdString().c_str(), CIF_UsePartialAccessToPixelData, 0, 1);
+        if (image.getStatus() != EIS_Normal || image.getWidth() == 0 || image.getHeight() == 0) {
+            return QImage();
+        }
+        if (!image.setWindow(0)) {
+            image.setMinMaxWindow();
+        }
+
+        const QSize size = QSize(int(image.getWidth()), int(image.getHeight()))
+                               .scaled(maxSize, maxSize, Qt::KeepAspectRatio);
+        std::unique_ptr<DicomImage> scaled(image.createScaledImage(static_cast<unsigned long>(size.width()),
+                                                                   static_cast<unsigned long>(size.height()),
+                                                                   1 /* interpolação */));
+        if (!scaled || scaled->getStatus() != EIS_Normal) {
+            return QImage();
+        }
+        thumbnail = outputImage(scaled.get());
+    }
+
+    if (thumbnail.width() > maxSize || thumbnail.height() > maxSize) {
+        thumbnail = thumbnail.scaled(maxSize, maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return thumbnail;
+}
+
+/**
+ * @brief Lê as tags do overlay a partir de um dataset já carregado em memória.
+ * @details Realiza conversão de encoding (Latin1) para suportar acentuação e formata a data.
+ * Não acessa o disco: pode ser usado tanto pelo caminho só-metadados quanto pelo carregamento completo.
+ * @param dataset Dataset DICOM já lido (não pode ser nulo).
+ * @return DicomMetadata Estrutura preenchida com isValid = true.
+ */
+DicomMetadata DicomManager::readMetadata(DcmDataset *dataset) {
+    DicomMetadata data;
+    OFString tempVal;
+
+    // Lambda auxiliar para buscar tags com segurança e converter encoding
+    auto getTag = [&](const DcmTagKey &tag) -> QString {
+        if (dataset->findAndGetOFString(tag, tempVal).good()) {
+            return QString::fromLatin1(tempVal.c_str());
+        }
+        return "N/A";
+    };
+
+    // Extração das Tags
+    data.patientName = getTag(DCM_PatientName);
+    data.patientID   = getTag(DCM_PatientID);
+    data.studyDate   = getTag(DCM_StudyDate);
+    data.modality    = getTag(DCM_Modality);
+    data.institution = getTag(DCM_InstitutionName);
+
+    // Trocar o separador '^' por espaço ' ' para ficar legível
+    data.patientName.replace("^", " "); 
+
+    // Formatação de Data (DICOM usa YYYYMMDD -> DD/MM/YYYY)
+    if (data.studyDate.length() == 8) {
+        data.studyDate = data.studyDate.mid(6, 2) + "/" + 
+                         data.studyDate.mid(4, 2) + "/" + 
+                         data.studyDate.left(4);
+    }
+
+    // Extração de Dimensões (Números inteiros)
+    long cols = 0, rows = 0;
+    dataset->findAndGetLongInt(DCM_Columns, cols);
+    dataset->findAndGetLongInt(DCM_Rows, rows);
+    data.dimensions = QString("%1 x %2 px").arg(cols).arg(rows);
+    const int frames = numberOfFrames(dataset);
+    if (frames > 1) {
+        data.dimensions += QString(" (%1 frames)").arg(frames);
+    }
+
+    data.isValid = true;
+    return data;
+}
+
+/**
+ * @brief Converte valores de modalidade para o armazenamento de 16 bits com deslocamento.
+ * @details Valores fora da faixa [offset, offset + 65535] são saturados.
+ * @param src Pixels intermediários da DCMTK (qualquer representação inteira).
+ * @param dst Destino (count valores).
+ * @param count Quantidade de pixels.
+ * @param offset Deslocamento subtraído de cada valor.
+ */
+template <typename T>
+static void convertToStored(const T *src, quint16 *dst, size_t count, qint64 offset) {
+    for (size_t i = 0; i < count; ++i) {
+        const qint64 value = qint64(src[i]) - offset;
+        dst[i] = quint16(value < 0 ? 0 : (value > 65535 ? 65535 : value));
+    }
+}
+
+/**
+ * @brief Converte os pixels intermediários da DCMTK (pós Modality LUT) de um frame.
+ * @param inter Pixels intermediários da DicomImage.
+ * @param first Índice do primeiro pixel do frame em 'inter'.
+ * @param dst Destino (count valores).
+ * @param count Quantidade de pixels.
+ * @param offset Deslocamento subtraído de cada valor.
+ * @return false se a representação não for inteira.
+ */
+static bool interToStored(const DiPixel *inter, size_t first, quint16 *dst, size_t count, qint64 offset) {
+    const void *src = inter->getData();
+    switch (inter->getRepresentation()) {
+        case EPR_Uint8:  convertToStored(static_cast<const Uint8 *>(src)  + first, dst, count, offset); return true;
+        case EPR_Sint8:  convertToStored(static_cast<const Sint8 *>(src)  + first, dst, count, offset); return true;
+        case EPR_Uint16: convertToStored(static_cast<const Uint16 *>(src) + first, dst, count, offset); return true;
+        case EPR_Sint16: convertToStored(static_cast<const Sint16 *>(src) + first, dst, count, offset); return true;
+        case EPR_Uint32: convertToStored(static_cast<const Uint32 *>(src) + first, dst, count, offset); return true;
+        case EPR_Sint32: convertToStored(static_cast<const Sint32 *>(src) + first, dst, count, offset); return true;
+        default: return false;
+    }
+}
+
+/**
+ * @brief Extrai os pixels nativos de um frame e a janela inicial da imagem.
+ * @details Etapas:
+ * 1. Obtém os dados intermediários da DCMTK (já com Rescale Slope/Intercept ou Modality LUT).
+ * 2. Calcula o deslocamento a partir do menor valor, para caber em 16 bits sem sinal.
+ * 3. Determina a janela inicial (preset do arquivo ou Min/Max) e a VOI LUT Function.
+ * @param image Imagem DCMTK válida (status EIS_Normal).
+ * Faixa e janela são as do conjunto de frames decodificados, iguais para todos eles.
+ * @param dataset Dataset de origem.
+ * @param frame Índice do frame entre os decodificados pela DicomImage.
+ * @return DicomPixelData Pixels nativos; nulo se a imagem não for monocromática.
+ */
+DicomPixelData DicomManager::extractPixelData(DicomImage *image, DcmDataset *dataset, int frame) {
+    DicomPixelData data;
+
+    const DiPixel *inter = image->isMonochrome() ? image->getInterData() : nullptr;
+    if (inter == nullptr || inter->getData() == nullptr) {
+        return data;
+    }
+
+    const int width = int(image->getWidth());
+    const int height = int(image->getHeight());
+    const size_t count = size_t(width) * size_t(height);
+    if (count == 0 || frame < 0 || inter->getCount() < count * size_t(frame + 1)) {
+        return data;
+    }
+
+    // [1] + [2] Faixa de valores de modalidade e deslocamento
+    double minValue = 0.0, maxValue = 0.0;
+    image->getMinMaxValues(minValue, maxValue);
+    const qint64 offset = qint64(std::floor(minValue));
+
+    quint16 *buffer = new quint16[count];
+    std::shared_ptr<const quint16> pixels(buffer, std::default_delete<quint16[]>());
+
+    if (!interToStored(inter, count * size_t(frame), buffer, count, offset)) {
+        return data;
+    }
+
+    data.width = width;
+    data.height = height;
+    data.valueOffset = int(offset);
+    data.minStored = 0;
+    data.maxStored = quint16(qBound<qint64>(0, qint64(std::ceil(maxValue)) - offset, 65535));
+    data.inverted = (image->getPhotometricInterpretation() == EPI_Monochrome1);
+    data.pixels = pixels;
+
+    // [3] Janela inicial: mesmo critério do pipeline em 8 bits (preset do arquivo ou Min/Max)
+    bool hasPreset = image->setWindow(0);
+    if (!hasPreset) {
+        image->setMinMaxWindow();
+    }
+    image->getWindow(data.windowCenter, data.windowWidth);
+
+    OFString function;
+    if (hasPreset && dataset->findAndGetOFString(DCM_VOILUTFunction, function).good()) {
+        data.sigmoid = (function == "SIGMOID");
+    }
+
+    return data;
+}
 
-        // Extração das Tags
-        data.patientName = getTag(DCM_PatientName);
-        data.patientID   = getTag(DCM_PatientID);
-        data.studyDate   = getTag(DCM_StudyDate);
-        data.modality    = getTag(DCM_Modality);
-        data.institution = getTag(DCM_InstitutionName);
+/**
+ * @brief Constrói a tabela (valor armazenado -> 8 bits) de uma janela VOI.
+ * @details Segue as fórmulas do padrão DICOM (PS3.3 C.11.2.1.2): LINEAR e SIGMOID.
+ * A tabela cobre os valores armazenados de 0 a pixels.maxStored, então a renderização é uma
+ * simples consulta por pixel e o custo de montá-la acompanha a profundidade real da imagem.
+ * @param pixels Pixels de referência (faixa, deslocamento, polaridade e função VOI).
+ * @param center Window Center em valores de modalidade.
+ * @param width Window Width em valores de modalidade.
+ * @param lut Destino com pixels.maxStored + 1 posições.
+ */
+static void buildWindowLut(const DicomPixelData &pixels, double center, double width, uchar *lut) {
+    width = std::max(width, 1.0);
 
-        // Trocar o separador '^' por espaço ' ' para ficar legível
-        data.patientName.replace("^", " "); 
+    for (int stored = 0; stored <= int(pixels.maxStored); ++stored) {
+        const double x = double(stored) + pixels.valueOffset;
+        double y;
 
-        // Formatação de Data (DICOM usa YYYYMMDD -> DD/MM/YYYY)
-        if (data.studyDate.length() == 8) {
-            data.studyDate = data.studyDate.mid(6, 2) + "/" + 
-                             data.studyDate.mid(4, 2) + "/" + 
-                             data.studyDate.left(4);
+        if (pixels.sigmoid) {
+            y = 255.0 / (1.0 + std::exp(-4.0 * (x - center) / width));
+        } else if (width <= 1.0) {
+            y = (x > center - 0.5) ? 255.0 : 0.0;
+        } else if (x <= center - 0.5 - (width - 1.0) / 2.0) {
+            y = 0.0;
+        } else if (x > center - 0.5 + (width - 1.0) / 2.0) {
+            y = 255.0;
+        } else {
+            y = ((x - (center - 0.5)) / (width - 1.0) + 0.5) * 255.0;
         }
 
-        // Extração de Dimensões (Números inteiros)
-        long cols = 0, rows = 0;
-        dataset->findAndGetLongInt(DCM_Columns, cols);
-        dataset->findAndGetLongInt(DCM_Rows, rows);
-        data.dimensions = QString("%1 x %2 px").arg(cols).arg(rows);
+        const uchar value = uchar(std::lround(std::min(255.0, std::max(0.0, y))));
+        lut[stored] = pixels.inverted ? uchar(255 - value) : value;
+    }
+}
+
+/**
+ * @struct LinearRamp
+ * @brief Janela LINEAR expressa no domínio armazenado: y = clamp(scale * valor + bias, 0, 255).
+ * @details A fórmula DICOM (PS3.3 C.11.2.1.2) é contínua nos limites da janela, então a
+ * saturação em [0, 255] reproduz exatamente os trechos "abaixo" e "acima" da janela.
+ */
+struct LinearRamp {
+    float scale; ///< Inclinação (já inclui a inversão de MONOCHROME1)
+    float bias;  ///< Termo constante (já inclui o +0,5 de arredondamento)
+};
+
+/**
+ * @brief Calcula os coeficientes da rampa linear para uma janela.
+ */
+static LinearRamp linearRamp(const DicomPixelData &pixels, double center, double width) {
+    const double scale = 255.0 / (width - 1.0);
+    double bias = ((pixels.valueOffset - (center - 0.5)) / (width - 1.0) + 0.5) * 255.0;
 
-        data.isValid = true;
+    LinearRamp ramp;
+    if (pixels.inverted) {
+        ramp.scale = float(-scale);
+        ramp.bias = float(255.0 - bias + 0.5);
     } else {
-        qDebug() << "Erro ao ler metadados do arquivo:" << path;
-        data.isValid = false;
+        ramp.scale = float(scale);
+        ramp.bias = float(bias + 0.5);
+    }
+    return ramp;
+}
+
+/**
+ * @brief Aplica a rampa linear a uma linha de pixels (kernel vetorizado).
+ * @details Com SSE2 (padrão em x86-64) processa 16 pixels por iteração: expande 16 -> 32 bits,
+ * converte para float, aplica multiplicação/soma, satura e empacota de volta para 8 bits.
+ * O restante da linha (e outras arquiteturas) usa a mesma aritmética em modo escalar.
+ */
+static void applyLinearRamp(const quint16 *src, uchar *dst, int count, const LinearRamp &ramp) {
+    int x = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128 scale = _mm_set1_ps(ramp.scale);
+    const __m128 bias = _mm_set1_ps(ramp.bias);
+    const __m128 lower = _mm_setzero_ps();
+    const __m128 upper = _mm_set1_ps(255.0f);
+    const __m128i zero = _mm_setzero_si128();
+
+    // Converte 4 inteiros de 32 bits em 4 saídas já saturadas em [0, 255]
+    auto ramp4 = [&](__m128i values) -> __m128i {
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(values), scale), bias);
+        y = _mm_min_ps(_mm_max_ps(y, lower), upper);
+        return _mm_cvttps_epi32(y);
+    };
+
+    for (; x + 16 <= count; x += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 8));
+
+        const __m128i lo = _mm_packs_epi32(ramp4(_mm_unpacklo_epi16(a, zero)), ramp4(_mm_unpackhi_epi16(a, zero)));
+        const __m128i hi = _mm_packs_epi32(ramp4(_mm_unpacklo_epi16(b, zero)), ramp4(_mm_unpackhi_epi16(b, zero)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; x < count; ++x) {
+        const float y = std::min(255.0f, std::max(0.0f, float(src[x]) * ramp.scale + ramp.bias));
+        dst[x] = uchar(y);
+    }
+}
+
+/**
+ * @brief Gera a visualização em 8 bits para uma janela arbitrária (imagem inteira).
+ * @param pixels Pixels em profundidade nativa.
+ * @param center Window Center em valores de modalidade.
+ * @param width Window Width em valores de modalidade.
+ * @return QImage Imagem em Grayscale8, ou nula se não houver pixels.
+ */
+QImage DicomManager::renderWindow(const DicomPixelData &pixels, double center, double width) {
+    return renderWindow(pixels, center, width, QRect(0, 0, pixels.width, pixels.height));
+}
+
+/**
+ * @brief Gera a visualização em 8 bits de uma região, para uma janela arbitrária.
+ * @details A QImage é alocada uma única vez e preenchida linha a linha (respeitando o
+ * bytesPerLine com padding do Qt), sem buffers intermediários. Janelas LINEAR usam o kernel
+ * vetorizado applyLinearRamp; SIGMOID (e janelas degeneradas) usam a tabela de consulta.
+ * Regiões grandes têm as linhas divididas entre os núcleos, mantendo o custo de um frame
+ * de 13 MP em poucos milissegundos; regiões pequenas (blocos) rodam na thread chamadora.
+ * @param pixels Pixels em profundidade nativa.
+ * @param center Window Center em valores de modalidade.
+ * @param width Window Width em valores de modalidade.
+ * @param region Região em coordenadas de pixel (recortada aos limites da imagem).
+ * @return QImage Imagem em Grayscale8 do tamanho da região, ou nula se não houver pixels.
+ */
+QImage DicomManager::renderWindow(const DicomPixelData &pixels, double center, double width, const QRect &region) {
+    const QRect area = region.intersected(QRect(0, 0, pixels.width, pixels.height));
+    if (pixels.isNull() || area.isEmpty()) {
+        return QImage();
+    }
+
+    QImage result(area.width(), area.height(), QImage::Format_Grayscale8);
+    if (result.isNull()) {
+        return result; // Falha de alocação
+    }
+
+    const bool useRamp = !pixels.sigmoid && width > 1.0;
+    const LinearRamp ramp = useRamp ? linearRamp(pixels, center, width) : LinearRamp{0.0f, 0.0f};
+    std::vector<uchar> lut;
+    if (!useRamp) {
+        lut.resize(size_t(pixels.maxStored) + 1);
+        buildWindowLut(pixels, center, width, lut.data());
+    }
+
+    // bits() uma única vez: scanLine() não constante faz detach() e não pode rodar em paralelo
+    uchar *bits = result.bits();
+    const qint64 bytesPerLine = result.bytesPerLine();
+    const qint64 pixelCount = qint64(area.width()) * area.height();
+    DicomScheduler::instance().parallelForRows(area.height(), pixelCount, kMinParallelPixels, [&](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            const quint16 *src = pixels.scanLine(area.top() + y) + area.left();
+            uchar *dst = bits + y * bytesPerLine;
+            if (useRamp) {
+                applyLinearRamp(src, dst, area.width(), ramp);
+            } else {
+                for (int x = 0; x < area.width(); ++x) {
+                    dst[x] = lut[std::min(src[x], pixels.maxStored)];
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+/**
+ * @brief Reduz um nível da pirâmide pela metade (média de blocos 2x2).
+ * @details Em dimensões ímpares a última coluna/linha é replicada, então nenhum pixel é descartado.
+ * @param src Nível de origem.
+ * @return DicomPixelData Nível com ((largura + 1) / 2) x ((altura + 1) / 2) pixels.
+ */
+static DicomPixelData downsample2x(const DicomPixelData &src) {
+    DicomPixelData dst = src; // Herda deslocamento, janela inicial e polaridade
+    dst.width = (src.width + 1) / 2;
+    dst.height = (src.height + 1) / 2;
+
+    quint16 *buffer = new quint16[size_t(dst.width) * size_t(dst.height)];
+    dst.pixels = std::shared_ptr<const quint16>(buffer, std::default_delete<quint16[]>());
+
+    const qint64 pixelCount = qint64(src.width) * src.height;
+    DicomScheduler::instance().parallelForRows(dst.height, pixelCount, kMinParallelPixels, [&](int firstRow, int lastRow) {
+        for (int y = firstRow; y < lastRow; ++y) {
+            const quint16 *row0 = src.scanLine(2 * y);
+            const quint16 *row1 = src.scanLine(std::min(2 * y + 1, src.height - 1));
+            quint16 *out = buffer + size_t(y) * size_t(dst.width);
+
+            for (int x = 0; x < dst.width; ++x) {
+                const int x0 = 2 * x;
+                const int x1 = std::min(x0 + 1, src.width - 1);
+                out[x] = quint16((quint32(row0[x0]) + row0[x1] + row1[x0] + row1[x1] + 2) >> 2);
+            }
+        }
+    });
+
+    return dst;
+}
+
+/**
+ * @brief Constrói a pirâmide de resolução (mipmap) a partir dos pixels nativos.
+ * @details O nível 0 é o próprio 'base' (mesmo buffer). Os demais são reduções sucessivas
+ * de 2x, guardadas em profundidade nativa para que o janelamento continue valendo em todos.
+ * @param base Pixels em resolução completa.
+ * @param minSize Maior lado a partir do qual a redução para.
+ * @return QVector<DicomPixelData> Níveis da pirâmide (vazio se base for nulo).
+ */
+QVector<DicomPixelData> DicomManager::buildPyramid(const DicomPixelData &base, int minSize) {
+    QVector<DicomPixelData> levels;
+    if (base.isNull()) {
+        return levels;
+    }
+
+    levels.append(base);
+    while (std::max(levels.last().width, levels.last().height) > minSize) {
+        levels.append(downsample2x(levels.last()));
+    }
+    return levels;
+}
+
+/**
+ * @brief Pixels de um frame usados diretamente no mapeamento do arquivo (sem cópia).
+ * @details Só vale quando os valores armazenados já estão no formato de DicomPixelData:
+ * monocromático, 16 bits sem sinal, sem Modality LUT e com Rescale Slope 1. O Rescale
+ * Intercept vira o valueOffset. Os pixels são percorridos uma vez (em paralelo) para obter
+ * a faixa, o que também carrega as páginas do frame; nada é alocado nem copiado.
+ * Bits acima de Bits Stored (ex.: overlays embutidos) exigiriam máscara: nesse caso, e em
+ * qualquer outro não suportado, retorna nulo e o chamador segue pelo caminho da DCMTK.
+ * @param file Arquivo mapeado (PixelData localizado).
+ * @param dataset Header lido de 'file'.
+ * @param frame Índice do frame (0 = primeiro).
+ * @return DicomPixelData Pixels apontando para o mapeamento, ou nulo se não suportado.
+ */
+static DicomPixelData mappedPixelData(const DicomMappedFile &file, DcmDataset *dataset, int frame) {
+    DicomPixelData data;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (!file.isNative()) {
+        return data;
+    }
+
+    Uint16 samples = 1, rows = 0, columns = 0, bitsAllocated = 0, bitsStored = 0, representation = 0;
+    Sint32 frames = 1;
+    Float64 slope = 1.0, intercept = 0.0;
+    OFString photometric;
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samples);
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, representation);
+    dataset->findAndGetSint32(DCM_NumberOfFrames, frames);
+    dataset->findAndGetFloat64(DCM_RescaleSlope, slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, intercept);
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+    if (dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad()) {
+        bitsStored = bitsAllocated;
+    }
+
+    const bool monochrome = (photometric == "MONOCHROME1" || photometric == "MONOCHROME2");
+    if (!monochrome || samples != 1 || bitsAllocated != 16 || representation != 0 ||
+        bitsStored == 0 || bitsStored > 16 || rows == 0 || columns == 0 ||
+        slope != 1.0 || intercept != std::floor(intercept) || std::fabs(intercept) > 65536.0 ||
+        dataset->tagExists(DCM_ModalityLUTSequence) || frame < 0 || frame >= std::max<Sint32>(1, frames)) {
+        return data;
+    }
+
+    const qint64 frameBytes = qint64(rows) * columns * 2;
+    if (file.pixelLength() < (frame + 1) * frameBytes) {
+        return data; // PixelData truncado
+    }
+    const quint16 *first = reinterpret_cast<const quint16 *>(file.pixelData() + frame * frameBytes);
+    if ((quintptr(first) & 1) != 0) {
+        return data;
     }
 
+    // [1] Faixa armazenada (uma passada em paralelo; carrega as páginas do frame)
+    quint16 minStored = 65535, maxStored = 0;
+    std::mutex rangeMutex;
+    const qint64 pixelCount = qint64(rows) * columns;
+    DicomScheduler::instance().parallelForRows(rows, pixelCount, kMinParallelPixels, [&](int firstRow, int lastRow) {
+        quint16 bandMin = 65535, bandMax = 0;
+        const quint16 *src = first + qint64(firstRow) * columns;
+        const quint16 *end = first + qint64(lastRow) * columns;
+        for (; src < end; ++src) {
+            bandMin = std::min(bandMin, *src);
+            bandMax = std::max(bandMax, *src);
+        }
+        std::lock_guard<std::mutex> lock(rangeMutex);
+        minStored = std::min(minStored, bandMin);
+        maxStored = std::max(maxStored, bandMax);
+    });
+    if (maxStored > (1u << bitsStored) - 1u) {
+        return data; // Bits acima de Bits Stored
+    }
+
+    data.width = columns;
+    data.height = rows;
+    data.valueOffset = int(intercept);
+    data.minStored = minStored;
+    data.maxStored = maxStored;
+    data.inverted = (photometric == "MONOCHROME1");
+    data.pixels = std::shared_ptr<const quint16>(file.data(), first); // Mantém o mapeamento vivo
+
+    // [2] Janela inicial: mesmo critério de extractPixelData (preset do arquivo ou Min/Max)
+    Float64 center = 0.0, width = 0.0;
+    const bool hasPreset = dataset->findAndGetFloat64(DCM_WindowCenter, center).good() &&
+                           dataset->findAndGetFloat64(DCM_WindowWidth, width).good() && width >= 1.0;
+    if (hasPreset) {
+        data.windowCenter = center;
+        data.windowWidth = width;
+        OFString function;
+        if (dataset->findAndGetOFString(DCM_VOILUTFunction, function).good()) {
+            data.sigmoid = (function == "SIGMOID");
+        }
+    } else {
+        data.windowCenter = (double(minStored) + maxStored + 1.0) / 2.0 + data.valueOffset;
+        data.windowWidth = double(maxStored) - minStored + 1.0;
+    }
+#else
+    Q_UNUSED(file)
+    Q_UNUSED(dataset)
+    Q_UNUSED(frame)
+#endif
     return data;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Aloca o bloco de um volume, alinhado a kVoxelAlignment.
+ * @return Ponteiro nulo se não houver memória.
+ */
+static std::shared_ptr<quint16> allocateVoxels(qint64 count) {
+    if (count <= 0) {
+        return std::shared_ptr<quint16>();
+    }
+    void *memory = ::operator new[](size_t(count) * sizeof(quint16), std::align_val_t(kVoxelAlignment), std::nothrow);
+    if (memory == nullptr) {
+        return std::shared_ptr<quint16>();
+    }
+    return std::shared_ptr<quint16>(static_cast<quint16 *>(memory), [](quint16 *voxels) {
+        ::operator delete[](voxels, std::align_val_t(kVoxelAlignment));
+    });
+}
+
+/**
+ * @brief Menor e maior valor de um bloco de pixels.
+ */
+static void storedRange(const quint16 *pixels, qint64 count, quint16 &minStored, quint16 &maxStored) {
+    minStored = 65535;
+    maxStored = 0;
+    for (const quint16 *end = pixels + count; pixels < end; ++pixels) {
+        minStored = std::min(minStored, *pixels);
+        maxStored = std::max(maxStored, *pixels);
+    }
+}
+
+/**
+ * @brief Menor valor de modalidade que o dataset pode produzir (deslocamento comum de um volume).
+ * @details Calculado só pelo Header (Bits Stored, Pixel Representation, Rescale
+ * Slope/Intercept), então todos os planos podem ser convertidos sem conhecer os demais.
+ * Com Modality LUT a saída já é sem sinal: 0.
+ */
+static qint64 lowestModalityValue(DcmDataset *dataset) {
+    if (dataset->tagExists(DCM_ModalityLUTSequence)) {
+        return 0;
+    }
+    Uint16 bitsAllocated = 16, bitsStored = 0, representation = 0;
+    Float64 slope = 1.0, intercept = 0.0;
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->findAndGetUint16(DCM_PixelRepresentation, representation);
+    dataset->findAndGetFloat64(DCM_RescaleSlope, slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, intercept);
+    if (dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad() || bitsStored == 0 || bitsStored > 32) {
+        bitsStored = std::min<Uint16>(bitsAllocated, 32);
+    }
+    const double lowest = representation ? -std::ldexp(1.0, bitsStored - 1) : 0.0;
+    const double highest = representation ? std::ldexp(1.0, bitsStored - 1) - 1.0 : std::ldexp(1.0, bitsStored) - 1.0;
+    return qint64(std::floor(std::min(intercept + slope * lowest, intercept + slope * highest)));
+}
+
+/**
+ * @brief Espaçamento dos voxels: Pixel Spacing (linhas \ colunas) e, entre planos, Spacing
+ * Between Slices ou Slice Thickness. Valores ausentes ficam em 1 mm.
+ */
+static void volumeSpacing(DcmDataset *dataset, DicomVolume &volume) {
+    Float64 rowSpacing = 0.0, columnSpacing = 0.0, between = 0.0;
+    if (dataset->findAndGetFloat64(DCM_PixelSpacing, rowSpacing, 0).good() &&
+        dataset->findAndGetFloat64(DCM_PixelSpacing, columnSpacing, 1).good() && rowSpacing > 0.0 && columnSpacing > 0.0) {
+        volume.spacingX = columnSpacing;
+        volume.spacingY = rowSpacing;
+    }
+    if ((dataset->findAndGetFloat64(DCM_SpacingBetweenSlices, between).good() && between > 0.0) ||
+        (dataset->findAndGetFloat64(DCM_SliceThickness, between).good() && between > 0.0)) {
+        volume.spacingZ = between;
+    }
+}
+
+/**
+ * @brief Janela inicial de um volume: preset do arquivo ou Min/Max (mesmo critério dos frames).
+ * @param dataset Header com o preset (nulo = Min/Max).
+ */
+static void initialWindow(DcmDataset *dataset, DicomVolume &volume) {
+    Float64 center = 0.0, width = 0.0;
+    const bool hasPreset = dataset != nullptr &&
+                           dataset->findAndGetFloat64(DCM_WindowCenter, center).good() &&
+                           dataset->findAndGetFloat64(DCM_WindowWidth, width).good() && width >= 1.0;
+    if (hasPreset) {
+        volume.windowCenter = center;
+        volume.windowWidth = width;
+        OFString function;
+        if (dataset->findAndGetOFString(DCM_VOILUTFunction, function).good()) {
+            volume.sigmoid = (function == "SIGMOID");
+        }
+    } else {
+        volume.windowCenter = (double(volume.minStored) + volume.maxStored + 1.0) / 2.0 + volume.valueOffset;
+        volume.windowWidth = double(volume.maxStored) - volume.minStored + 1.0;
+    }
+}
+
+/**
+ * @brief Fluxo comprimido de um frame.
+ * @details Com um único fragmento (o caso comum), aponta direto para o mapeamento; com
+ * vários, os fragmentos são concatenados em 'storage'.
+ * @param length Saída: tamanho do fluxo em bytes.
+ */
+static const uchar *frameStream(const uchar *mapping, const QVector<DicomMappedFile::Fragment> &fragments,
+                                std::vector<uchar> &storage, size_t &length) {
+    if (fragments.size() == 1) {
+        length = size_t(fragments.first().length);
+        return mapping + fragments.first().offset;
+    }
+    storage.clear();
+    for (const DicomMappedFile::Fragment &fragment : fragments) {
+        storage.insert(storage.end(), mapping + fragment.offset, mapping + fragment.offset + fragment.length);
+    }
+    length = storage.size();
+    return storage.data();
+}
+
+/**
+ * @brief Transforma uma cópia do Header no dataset de um único frame: Number of Frames = 1
+ * e um PixelData só com os fragmentos do frame, lidos do mapeamento.
+ * @details Os codecs da DCMTK trabalham sobre datasets independentes, sem estado comum.
+ * @return PixelData inserido (pertence a frameSet).
+ */
+static DcmPixelData *attachFrame(DcmDataset *frameSet, const uchar *mapping,
+                                 const QVector<DicomMappedFile::Fragment> &fragments, E_TransferSyntax xfer) {
+    frameSet->putAndInsertString(DCM_NumberOfFrames, "1");
+
+    DcmPixelSequence *sequence = new DcmPixelSequence(DcmTag(DCM_PixelSequenceTag));
+    sequence->insert(new DcmPixelItem(DcmTag(DCM_Item, EVR_OB))); // Basic Offset Table vazia
+    for (const DicomMappedFile::Fragment &fragment : fragments) {
+        DcmPixelItem *item = new DcmPixelItem(DcmTag(DCM_Item, EVR_OB));
+        item->putUint8Array(mapping + fragment.offset, Uint32(fragment.length));
+        sequence->insert(item);
+    }
+    DcmPixelData *pixelData = new DcmPixelData(DCM_PixelData);
+    pixelData->putOriginalRepresentation(xfer, nullptr, sequence);
+    frameSet->insert(pixelData, true);
+    return pixelData;
+}
+
+/**
+ * @brief Transforma uma cópia do Header no dataset de um único frame sem compressão
+ * (Number of Frames = 1), com os bytes do frame copiados do mapeamento.
+ * @details Usado para objetos coloridos, que a DicomImage renderiza em 8 bits; os
+ * monocromáticos são usados direto no mapeamento (mappedPixelData).
+ * @return false se Bits Allocated não for 8 ou 16 ou se o frame não couber no PixelData.
+ */
+static bool attachNativeFrame(DcmDataset *frameSet, const DicomMappedFile &file, int frame) {
+    Uint16 samples = 1, rows = 0, columns = 0, bitsAllocated = 0;
+    frameSet->findAndGetUint16(DCM_SamplesPerPixel, samples);
+    frameSet->findAndGetUint16(DCM_Rows, rows);
+    frameSet->findAndGetUint16(DCM_Columns, columns);
+    frameSet->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+
+    const qint64 frameBytes = qint64(rows) * columns * samples * bitsAllocated / 8;
+    if ((bitsAllocated != 8 && bitsAllocated != 16) || frameBytes == 0 || frame < 0 ||
+        (frame + 1) * frameBytes > file.pixelLength()) {
+        return false;
+    }
+
+    frameSet->putAndInsertString(DCM_NumberOfFrames, "1");
+    const uchar *bytes = file.pixelData() + frame * frameBytes;
+    if (bitsAllocated == 8) {
+        return frameSet->putAndInsertUint8Array(DCM_PixelData, bytes, Uint32(frameBytes)).good();
+    }
+    return frameSet->putAndInsertUint16Array(DCM_PixelData, reinterpret_cast<const Uint16 *>(bytes),
+                                             Uint32(frameBytes / 2)).good();
+}
+
+/**
+ * @struct SampleLayout
+ * @brief Como as amostras decodificadas viram valores armazenados (decodificador JPEG Lossless próprio).
+ */
+struct SampleLayout {
+    bool supported = false; ///< Amostra -> valor de modalidade sem Modality LUT nem escala
+    int bitsStored = 16;    ///< Bits Stored (High Bit = Bits Stored - 1)
+    bool isSigned = false;  ///< Pixel Representation = 1
+    qint64 intercept = 0;   ///< Rescale Intercept inteiro (Rescale Slope = 1)
+};
+
+/**
+ * @brief Lê do Header se as amostras podem ser convertidas sem a DCMTK.
+ * @details O mesmo que a DicomImage faria: bits acima de Bits Stored descartados, extensão
+ * de sinal e Rescale Intercept. Modality LUT, Rescale Slope diferente de 1, intercept
+ * fracionário ou High Bit deslocado ficam com a DCMTK.
+ */
+static SampleLayout sampleLayout(DcmDataset *dataset) {
+    SampleLayout layout;
+    Uint16 bitsAllocated = 0, bitsStored = 0, highBit = 0, representation = 0;
+    Float64 slope = 1.0, intercept = 0.0;
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    if (dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad()) {
+        bitsStored = bitsAllocated;
+    }
+    if (dataset->findAndGetUint16(DCM_HighBit, highBit).bad()) {
+        highBit = Uint16(bitsStored - 1);
+    }
+    dataset->findAndGetUint16(DCM_PixelRepresentation, representation);
+    dataset->findAndGetFloat64(DCM_RescaleSlope, slope);
+    dataset->findAndGetFloat64(DCM_RescaleIntercept, intercept);
+
+    layout.supported = !dataset->tagExists(DCM_ModalityLUTSequence) && bitsAllocated <= 16 && bitsStored >= 1 &&
+                       bitsStored <= 16 && highBit == bitsStored - 1 && slope == 1.0 && intercept == std::floor(intercept);
+    layout.bitsStored = bitsStored;
+    layout.isSigned = (representation != 0);
+    layout.intercept = qint64(intercept);
+    return layout;
+}
+
+/**
+ * @brief Converte, no próprio plano, amostras decodificadas em valores armazenados com deslocamento.
+ * @details valor = amostra (Bits Stored, com sinal se for o caso) + intercept; armazenado =
+ * valor - offset, saturado em [0, 65535]. Sem sinal, máscara completa e deslocamento nulo
+ * (o caso de mamografia), nada muda.
+ */
+static void samplesToStored(quint16 *pixels, qint64 count, const SampleLayout &layout, qint64 offset) {
+    const int mask = (1 << layout.bitsStored) - 1;
+    const int signBit = layout.isSigned ? (1 << (layout.bitsStored - 1)) : (1 << 16);
+    const qint64 shift = layout.intercept - offset;
+    if (!layout.isSigned && layout.bitsStored == 16 && shift == 0) {
+        return;
+    }
+    for (qint64 i = 0; i < count; ++i) {
+        int sample = pixels[i] & mask;
+        if (sample & signBit) {
+            sample -= (1 << layout.bitsStored);
+        }
+        const qint64 value = sample + shift;
+        pixels[i] = quint16(value < 0 ? 0 : (value > 65535 ? 65535 : value));
+    }
+}
+
+/**
+ * @struct DicomFrameSource
+ * @brief Arquivo aberto uma única vez para vários pedidos de frames (ex.: blocos do cine).
+ * @details Guarda o mapeamento, o Header lido dele e a divisão dos fragmentos por frame.
+ * A DCMTK não permite leituras concorrentes de um mesmo dataset (a busca de tags altera o
+ * estado das listas), então cada pedido trabalha sobre a sua cópia do Header (copyHeader).
+ */
+struct DicomFrameSource {
+    QString path;                  ///< Arquivo de origem
+    DicomMappedFile mapped;        ///< Mapeamento do arquivo
+    bool hasHeader = false;        ///< Header lido do mapeamento (sem ele, só a DCMTK lê o arquivo)
+    int frameCount = 0;            ///< Number of Frames
+    QVector<QVector<DicomMappedFile::Fragment>> fragments; ///< Fragmentos de cada frame (encapsulado)
+    mutable DcmFileFormat header;  ///< Header lido do mapeamento (compartilhado: acesso sob 'mutex')
+    mutable std::mutex mutex;      ///< Protege 'header' quando a fonte é compartilhada
+
+    /// Mapeia o arquivo e lê Header e fragmentos; false se o arquivo só puder ser lido pela DCMTK.
+    bool open(const QString &filePath);
+
+    /// Cópia do Header para uso exclusivo de um pedido.
+    std::unique_ptr<DcmDataset> copyHeader() const;
+};
+
+bool DicomFrameSource::open(const QString &filePath) {
+    path = filePath;
+    hasHeader = mapped.open(filePath) && mapped.readHeader(header);
+    if (!hasHeader) {
+        return false;
+    }
+    frameCount = numberOfFrames(header.getDataset());
+    if (mapped.isEncapsulated() && !mapped.frameFragments(frameCount, fragments)) {
+        fragments.clear(); // Divisão indeterminada: os frames seguem pela DCMTK
+    }
+    return true;
+}
+
+std::unique_ptr<DcmDataset> DicomFrameSource::copyHeader() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::unique_ptr<DcmDataset>(new DcmDataset(*header.getDataset()));
+}
+
+/**
+ * @brief Abre o arquivo uma única vez para pedidos repetidos de frames.
+ */
+std::shared_ptr<const DicomFrameSource> DicomManager::openFrameSource(const QString &path) {
+    const std::shared_ptr<DicomFrameSource> source = std::make_shared<DicomFrameSource>();
+    source->open(path);
+    return source;
+}
+
+/**
+ * @struct FrameTarget
+ * @brief Planos de um bloco já alocado pelo chamador, destino dos frames decodificados.
+ */
+struct FrameTarget {
+    std::shared_ptr<quint16> voxels;  ///< Bloco de destino
+    qint64 firstPlane = 0;            ///< Plano do primeiro frame; os seguintes vêm em sequência
+    qint64 valueOffset = 0;           ///< Deslocamento comum do bloco (usado no lugar do do objeto)
+};
+
+/**
+ * @brief Descomprime em paralelo os frames [firstFrame, firstFrame + count) de um PixelData
+ * encapsulado, direto em um bloco contíguo pré-alocado (ou nos planos indicados em 'target').
+ * @details Etapas:
+ * 1. Usa a divisão dos fragmentos entre os frames feita na abertura (DicomFrameSource) e
+ *    fixa um deslocamento comum (lowestModalityValue), então cada frame é convertido sem
+ *    esperar os outros.
+ * 2. JPEG Lossless SV1 (DicomJpegLossless) com amostras conversíveis (sampleLayout): o frame
+ *    é decodificado direto no seu plano e convertido ali mesmo. Se o fluxo não for suportado,
+ *    o frame segue para a DCMTK.
+ * 3. Demais frames, em uma tarefa do escalonador (parallelFor), ganham um dataset próprio
+ *    (attachFrame); a DicomImage do frame é convertida para o plano correspondente do bloco.
+ * 4. A faixa armazenada do frame é combinada com a dos demais.
+ * O progresso é reportado (e o cancelamento verificado) apenas na thread chamadora, que
+ * também decodifica frames; as outras só observam o pedido de cancelamento.
+ * @param source Arquivo aberto com PixelData encapsulado.
+ * @param dataset Header de 'source' de uso exclusivo desta chamada (copyHeader ou fonte local).
+ * @param canceled Saída: true se o callback pediu o cancelamento.
+ * @param target Destino fornecido pelo chamador (nulo = bloco alocado aqui, com o
+ *        deslocamento do próprio objeto). Os planos devem ter as dimensões do Header.
+ * @return DicomVolume Volume com os frames pedidos (sobre os planos de 'target', se houver);
+ * nulo se não suportado (colorido, tabela de fragmentos inconsistente, falha do codec) ou cancelado.
+ */
+static DicomVolume decodeEncapsulated(const DicomFrameSource &source, DcmDataset *dataset, int firstFrame, int count,
+                                      const DicomProgressCallback &progress, bool &canceled,
+                                      const FrameTarget *target = nullptr) {
+    DicomVolume volume;
+    canceled = false;
+
+    Uint16 samples = 1, rows = 0, columns = 0, bitsAllocated = 0, bitsStored = 0;
+    OFString photometric;
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samples);
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+    if (dataset->findAndGetUint16(DCM_BitsStored, bitsStored).bad()) {
+        bitsStored = bitsAllocated;
+    }
+
+    const DicomMappedFile &file = source.mapped;
+    const QVector<QVector<DicomMappedFile::Fragment>> &fragments = source.fragments;
+    const bool monochrome = (photometric == "MONOCHROME1" || photometric == "MONOCHROME2");
+    const int frameTotal = numberOfFrames(dataset);
+    if (!file.isEncapsulated() || !monochrome || samples != 1 || rows == 0 || columns == 0 ||
+        bitsStored == 0 || bitsStored > 16 || firstFrame < 0 || count <= 0 || firstFrame + count > frameTotal) {
+        return volume;
+    }
+
+    // [1] Fragmentos por frame (divididos na abertura) e deslocamento comum
+    if (fragments.size() != frameTotal) {
+        return volume;
+    }
+
+    const qint64 offset = target != nullptr ? target->valueOffset : lowestModalityValue(dataset);
+
+    const qint64 sliceSize = qint64(rows) * columns;
+    std::shared_ptr<quint16> voxels;
+    if (target != nullptr) {
+        voxels = std::shared_ptr<quint16>(target->voxels, target->voxels.get() + sliceSize * target->firstPlane);
+    } else {
+        voxels = allocateVoxels(sliceSize * count);
+        if (!voxels) {
+            qDebug() << "Memória insuficiente para o volume:" << sliceSize * count * 2 / (1024 * 1024) << "MB";
+            return volume;
+        }
+    }
+
+    const E_TransferSyntax xfer = DcmXfer(file.transferSyntax().constData()).getXfer();
+    const uchar *mapping = file.data().get();
+    const std::thread::id caller = std::this_thread::get_id();
+    const SampleLayout layout = sampleLayout(dataset);
+    const bool lossless = layout.supported && DicomJpegLossless::supports(file.transferSyntax());
+
+    std::mutex mutex; // Cópia do Header e faixa combinada
+    quint16 minStored = 65535, maxStored = 0;
+    std::atomic_int done{0};
+    std::atomic_bool failed{false};
+    std::atomic_bool stop{false};
+
+    DicomScheduler::instance().parallelFor(count, [&](int i) {
+        if (failed.load() || stop.load()) {
+            return;
+        }
+
+        quint16 *plane = voxels.get() + sliceSize * i;
+        const QVector<DicomMappedFile::Fragment> &frameFragments = fragments.at(firstFrame + i);
+
+        // [2] JPEG Lossless SV1: decodificador próprio direto no plano
+        bool decoded = false;
+        if (lossless) {
+            std::vector<uchar> storage;
+            size_t length = 0;
+            const uchar *stream = frameStream(mapping, frameFragments, storage, length);
+            decoded = DicomJpegLossless::decode(stream, length, columns, rows, plane);
+            if (decoded) {
+                samplesToStored(plane, sliceSize, layout, offset);
+            }
+        }
+
+        // [3] DCMTK: dataset do frame (Header + PixelData só com os fragmentos deste frame)
+        if (!decoded) {
+            std::unique_ptr<DcmDataset> frameSet;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                frameSet.reset(new DcmDataset(*dataset));
+            }
+            attachFrame(frameSet.get(), mapping, frameFragments, xfer);
+
+            DicomImage image(frameSet.get(), xfer, 0, 0, 1);
+            const DiPixel *inter = (image.getStatus() == EIS_Normal && image.isMonochrome()) ? image.getInterData() : nullptr;
+            if (inter == nullptr || inter->getData() == nullptr || image.getWidth() != columns ||
+                image.getHeight() != rows || inter->getCount() < size_t(sliceSize)) {
+                failed.store(true);
+                return;
+            }
+
+            if (!interToStored(inter, 0, plane, size_t(sliceSize), offset)) {
+                failed.store(true);
+                return;
+            }
+        }
+
+        // [4] Faixa armazenada
+        quint16 planeMin = 65535, planeMax = 0;
+        storedRange(plane, sliceSize, planeMin, planeMax);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            minStored = std::min(minStored, planeMin);
+            maxStored = std::max(maxStored, planeMax);
+        }
+
+        const int finished = done.fetch_add(1) + 1;
+        if (progress && std::this_thread::get_id() == caller && !progress(finished * 100 / count)) {
+            stop.store(true);
+        }
+    });
+
+    if (stop.load()) {
+        canceled = true;
+        return volume;
+    }
+    if (failed.load()) {
+        return volume;
+    }
+
+    volume.width = columns;
+    volume.height = rows;
+    volume.depth = count;
+    volume.valueOffset = int(offset);
+    volume.minStored = minStored;
+    volume.maxStored = maxStored;
+    volume.inverted = (photometric == "MONOCHROME1");
+    volume.voxels = voxels;
+    initialWindow(dataset, volume);
+    volumeSpacing(dataset, volume);
+    return volume;
+}
+
+/**
+ * @brief Carrega pixels e metadados a partir de uma única leitura do arquivo.
+ * @details O fluxo é:
+ * 0a. Arquivos sem compressão (Explicit VR Little Endian, 16 bits): o arquivo é mapeado, o
+ *     Header é lido do mapeamento e os pixels do primeiro frame são usados no próprio
+ *     mapeamento (DicomMappedFile), sem alocação nem cópia proporcional ao arquivo.
+ * 0b. Se o cache em disco estiver ativo e tiver uma entrada válida (tamanho, data e
+ *     SOPInstanceUID iguais), mapeia os pixels já decodificados e retorna sem usar o codec.
+ * 0c. JPEG Lossless SV1 (mamografia): o primeiro frame é decodificado do mapeamento pelo
+ *     decodificador próprio (decodeEncapsulated), com a DCMTK como reserva.
+ * 1. Lê e interpreta o arquivo uma única vez com DcmFileFormat (PixelData adiado).
+ * 2. Preenche o DicomMetadata a partir do dataset em memória.
+ * 3. Constrói a DicomImage sobre o mesmo dataset, com acesso parcial ao PixelData: só o
+ *    primeiro frame é lido e descomprimido (JPEG, JPEG-LS, RLE), a etapa mais cara do processo.
+ * 4. Copia os pixels em profundidade nativa (pós Modality LUT), preservando a faixa dinâmica
+ *    para o janelamento, e constrói a pirâmide de resolução usada na exibição. Com o cache
+ *    em disco ativo, a gravação é agendada em segundo plano (não atrasa a entrega).
+ * Entre as etapas o callback de progresso é consultado; se retornar false, o carregamento
+ * é abandonado. O tempo total vai para a categoria de log dicomPerf (desligada por padrão).
+ * @param path O caminho absoluto ou relativo para o arquivo .dcm.
+ * @param progress Callback opcional de progresso/cancelamento (pode ser vazio).
+ * @return DicomLoadResult Imagem e metadados; a imagem é nula em caso de falha ou cancelamento.
+ */
+DicomLoadResult DicomManager::loadDicomFile(const QString &path, const DicomProgressCallback &progress) {
+    DicomLoadResult result;
+    result.path = path;
+    QElapsedTimer timer;
+    timer.start();
+
+    // Reporta o progresso e indica se o carregamento deve continuar
+    auto proceed = [&](int percent) -> bool {
+        if (progress && !progress(percent)) {
+            result.canceled = true;
+            return false;
+        }
+        return true;
+    };
+
+    if (!proceed(0)) return result;
+
+    // [0a] Sem compressão: Header e pixels direto do mapeamento do arquivo.
+    // A fonte é local (não compartilhada): o Header é usado sem cópia.
+    DicomFrameSource source;
+    if (source.open(path) && source.mapped.isNative()) {
+        DcmDataset *dataset = source.header.getDataset();
+        result.pixels = mappedPixelData(source.mapped, dataset, 0);
+        if (!result.pixels.isNull()) {
+            result.metadata = readMetadata(dataset);
+            result.frameCount = source.frameCount;
+            result.frameRate = frameRate(dataset);
+            result.pyramid = buildPyramid(result.pixels);
+            if (progress) progress(100);
+            qCDebug(dicomPerf) << "loadDicomFile (mapeado, sem cópia):" << timer.elapsed() << "ms -" << path;
+            return result;
+        }
+    }
+
+    // [0b] Cache em disco: só o Header é lido (SOPInstanceUID) e os pixels são mapeados
+    QString sopInstanceUid;
+    if (DicomDiskCache::isEnabled()) {
+        DcmFileFormat header;
+        OFString uid;
+        if (loadHeader(path, header).good()) {
+            if (header.getDataset()->findAndGetOFString(DCM_SOPInstanceUID, uid).good()) {
+                sopInstanceUid = QString::fromLatin1(uid.c_str());
+            }
+            result.frameCount = numberOfFrames(header.getDataset());
+            result.frameRate = frameRate(header.getDataset());
+        }
+        if (DicomDiskCache::load(path, sopInstanceUid, result)) {
+            if (progress) progress(100);
+            qCDebug(dicomPerf) << "loadDicomFile (cache em disco):" << timer.elapsed() << "ms -" << path;
+            return result;
+        }
+    }
+
+    // [0c] JPEG Lossless SV1: primeiro frame pelo decodificador próprio, direto do mapeamento
+    if (source.hasHeader && source.mapped.isEncapsulated() && DicomJpegLossless::supports(source.mapped.transferSyntax())) {
+        DcmDataset *dataset = source.header.getDataset();
+        bool canceled = false;
+        const DicomVolume volume = decodeEncapsulated(source, dataset, 0, 1, progress, canceled);
+        if (canceled) {
+            result.canceled = true;
+            return result;
+        }
+        if (!volume.isNull()) {
+            result.pixels = volume.frame(0);
+            result.metadata = readMetadata(dataset);
+            result.frameCount = source.frameCount;
+            result.frameRate = frameRate(dataset);
+            result.pyramid = buildPyramid(result.pixels);
+            DicomDiskCache::storeInBackground(path, sopInstanceUid, result);
+            if (progress) progress(100);
+            qCDebug(dicomPerf) << "loadDicomFile (JPEG Lossless):" << timer.elapsed() << "ms -" << path;
+            return result;
+        }
+    }
+
+    // [1] Leitura única do arquivo. Valores grandes (PixelData) têm a leitura adiada:
+    // a DicomImage lê do disco apenas os frames que decodificar.
+    DcmFileFormat fileformat;
+    if (loadDeferred(path, fileformat).bad()) {
+        qDebug() << "Erro ao ler arquivo DICOM:" << path;
+        return result;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+    result.frameCount = numberOfFrames(dataset);
+    result.frameRate = frameRate(dataset);
+    if (!proceed(25)) return result;
+
+    // [2] Metadados do overlay a partir do dataset já carregado
+    result.metadata = readMetadata(dataset);
+    if (!proceed(30)) return result;
+
+    // [3] DicomImage construída sobre o mesmo dataset, só com o primeiro frame (acesso parcial).
+    // O dataset pertence ao 'fileformat', que vive até o fim desta função.
+    DicomImage image(&fileformat, dataset->getOriginalXfer(), CIF_UsePartialAccessToPixelData, 0, 1);
+    if (image.getStatus() != EIS_Normal) {
+        qDebug() << "Erro ao decodificar pixels:" << DicomImage::getString(image.getStatus());
+        return result;
+    }
+    if (!proceed(85)) return result;
+
+    // [4] Pixels em profundidade nativa + pirâmide de resolução (ainda na thread de trabalho).
+    // Imagens coloridas não têm representação nativa: seguem o pipeline de 8 bits da DCMTK.
+    result.pixels = extractPixelData(&image, dataset);
+    if (!result.pixels.isNull()) {
+        result.pyramid = buildPyramid(result.pixels);
+        DicomDiskCache::storeInBackground(path, sopInstanceUid, result); // Próxima abertura: mapeamento, sem codec
+    } else {
+        result.image = renderImage(&image);
+    }
+    if (progress) progress(100);
+
+    qCDebug(dicomPerf) << "loadDicomFile:" << timer.elapsed() << "ms -" << path;
+    return result;
+}
+
+/**
+ * @brief Decodifica os frames [firstFrame, firstFrame + count) sob demanda.
+ * @details Etapas:
+ * 1. Arquivos sem compressão elegíveis: cada frame aponta para o mapeamento do arquivo.
+ * 2. PixelData encapsulado: os frames são descomprimidos em paralelo (decodeEncapsulated)
+ *    e devolvidos como planos do volume, sem cópia.
+ * 3. Demais: o dataset é lido com o PixelData adiado e a DicomImage é construída com
+ *    CIF_UsePartialAccessToPixelData para o intervalo pedido; só esses frames são lidos e
+ *    descomprimidos. Cada frame é então copiado para um DicomPixelData próprio.
+ * O callback de progresso é consultado antes de cada frame. As etapas 1 e 2 usam o
+ * mapeamento, o Header (copiado) e os fragmentos já abertos em 'source'.
+ */
+QVector<DicomPixelData> DicomManager::loadFrames(const DicomFrameSource &source, int firstFrame, int count,
+                                                 const DicomProgressCallback &progress) {
+    QVector<DicomPixelData> frames;
+    QElapsedTimer timer;
+    timer.start();
+
+    auto proceed = [&](int done, int total) -> bool {
+        return !progress || progress(total > 0 ? done * 100 / total : 100);
+    };
+
+    const QString &path = source.path;
+    const DicomMappedFile &mapped = source.mapped;
+    if (source.hasHeader) {
+        const std::unique_ptr<DcmDataset> header = source.copyHeader();
+        DcmDataset *dataset = header.get();
+        const int last = std::min(source.frameCount, firstFrame + count);
+
+        // [1] Sem compressão: frames direto do mapeamento
+        for (int frame = firstFrame; frame < last && mapped.isNative(); ++frame) {
+            if (!proceed(frame - firstFrame, last - firstFrame)) {
+                return QVector<DicomPixelData>();
+            }
+            DicomPixelData pixels = mappedPixelData(mapped, dataset, frame);
+            if (pixels.isNull()) {
+                break; // Formato não suportado no mapeamento: segue pela DCMTK
+            }
+            if (!frames.isEmpty()) {
+                pixels.windowCenter = frames.first().windowCenter; // Mesma janela para o intervalo
+                pixels.windowWidth = frames.first().windowWidth;
+            }
+            frames.append(pixels);
+        }
+        if (!frames.isEmpty() && frames.size() == last - firstFrame) {
+            qCDebug(dicomPerf) << "loadFrames (mapeado):" << frames.size() << "frames em" << timer.elapsed() << "ms -" << path;
+            return frames;
+        }
+        frames.clear();
+
+        // [2] Encapsulado: descompressão paralela em um bloco contíguo
+        if (mapped.isEncapsulated()) {
+            bool canceled = false;
+            const DicomVolume volume = decodeEncapsulated(source, dataset, firstFrame, last - firstFrame, progress, canceled);
+            if (canceled) {
+                return frames;
+            }
+            for (int z = 0; z < volume.depth; ++z) {
+                frames.append(volume.frame(z));
+            }
+            if (!frames.isEmpty()) {
+                if (progress) progress(100);
+                qCDebug(dicomPerf) << "loadFrames (paralelo):" << frames.size() << "frames em" << timer.elapsed() << "ms -" << path;
+                return frames;
+            }
+        }
+    }
+
+    // [3] Acesso parcial da DCMTK
+    DcmFileFormat fileformat;
+    if (loadDeferred(path, fileformat).bad()) {
+        return frames;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+    const int last = std::min(numberOfFrames(dataset), firstFrame + count);
+    if (firstFrame < 0 || firstFrame >= last) {
+        return frames;
+    }
+
+    DicomImage image(&fileformat, dataset->getOriginalXfer(), CIF_UsePartialAccessToPixelData,
+                     static_cast<unsigned long>(firstFrame), static_cast<unsigned long>(last - firstFrame));
+    if (image.getStatus() != EIS_Normal) {
+        qDebug() << "Erro ao decodificar frames:" << DicomImage::getString(image.getStatus());
+        return frames;
+    }
+
+    frames.reserve(last - firstFrame);
+    for (int i = 0; i < last - firstFrame; ++i) {
+        if (!proceed(i, last - firstFrame)) {
+            return QVector<DicomPixelData>();
+        }
+        const DicomPixelData pixels = extractPixelData(&image, dataset, i);
+        if (pixels.isNull()) {
+            return QVector<DicomPixelData>(); // Colorida ou frame ausente
+        }
+        frames.append(pixels);
+    }
+    if (progress) progress(100);
+
+    qCDebug(dicomPerf) << "loadFrames:" << frames.size() << "frames em" << timer.elapsed() << "ms -" << path;
+    return frames;
+}
+
+/**
+ * @brief Decodifica os frames [firstFrame, firstFrame + count), abrindo o arquivo só para esta chamada.
+ */
+QVector<DicomPixelData> DicomManager::loadFrames(const QString &path, int firstFrame, int count,
+                                                 const DicomProgressCallback &progress) {
+    return loadFrames(*openFrameSource(path), firstFrame, count, progress);
+}
+
+/**
+ * @brief Renderiza em 8 bits os frames [firstFrame, firstFrame + count) de um objeto colorido.
+ * @details Etapas:
+ * 1. Mapeado (encapsulado com fragmentos divididos, ou sem compressão): cada frame, em uma
+ *    tarefa do escalonador (parallelFor), ganha um dataset próprio com a cópia do Header e só
+ *    os seus bytes (attachFrame / attachNativeFrame) e é renderizado pela DicomImage.
+ * 2. Demais: acesso parcial da DCMTK ao intervalo, com a janela aplicada uma vez e um
+ *    frame renderizado por vez.
+ * O progresso é reportado (e o cancelamento verificado) apenas na thread chamadora.
+ */
+QVector<QImage> DicomManager::loadColorFrames(const DicomFrameSource &source, int firstFrame, int count,
+                                              const DicomProgressCallback &progress) {
+    QVector<QImage> images;
+    QElapsedTimer timer;
+    timer.start();
+
+    // [1] Um dataset por frame, a partir do mapeamento
+    const DicomMappedFile &mapped = source.mapped;
+    const bool encapsulated = mapped.isEncapsulated() && source.fragments.size() == source.frameCount;
+    const int last = std::min(source.frameCount, firstFrame + count);
+    if (source.hasHeader && (encapsulated || mapped.isNative()) && firstFrame >= 0 && firstFrame < last) {
+        const int total = last - firstFrame;
+        images.resize(total);
+        QImage *out = images.data();
+        const E_TransferSyntax xfer = DcmXfer(mapped.transferSyntax().constData()).getXfer();
+        const std::thread::id caller = std::this_thread::get_id();
+        std::atomic_int done{0};
+        std::atomic_bool failed{false};
+        std::atomic_bool stop{false};
+
+        DicomScheduler::instance().parallelFor(total, [&](int i) {
+            if (failed.load() || stop.load()) {
+                return;
+            }
+            const std::unique_ptr<DcmDataset> frameSet = source.copyHeader();
+            if (encapsulated) {
+                attachFrame(frameSet.get(), mapped.data().get(), source.fragments.at(firstFrame + i), xfer);
+            } else if (!attachNativeFrame(frameSet.get(), mapped, firstFrame + i)) {
+                failed.store(true);
+                return;
+            }
+
+            DicomImage image(frameSet.get(), xfer, 0, 0, 1);
+            if (image.getStatus() == EIS_Normal) {
+                out[i] = renderImage(&image);
+            }
+            if (out[i].isNull()) {
+                failed.store(true);
+                return;
+            }
+
+            const int finished = done.fetch_add(1) + 1;
+            if (progress && std::this_thread::get_id() == caller && !progress(finished * 100 / total)) {
+                stop.store(true);
+            }
+        });
+
+        if (stop.load()) {
+            return QVector<QImage>();
+        }
+        if (!failed.load()) {
+            qCDebug(dicomPerf) << "loadColorFrames (paralelo):" << total << "frames em" << timer.elapsed() << "ms -" << source.path;
+            return images;
+        }
+        images.clear();
+    }
+
+    // [2] Acesso parcial da DCMTK
+    DcmFileFormat fileformat;
+    if (loadDeferred(source.path, fileformat).bad()) {
+        return images;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+    const int available = std::min(numberOfFrames(dataset), firstFrame + count);
+    if (firstFrame < 0 || firstFrame >= available) {
+        return images;
+    }
+
+    DicomImage image(&fileformat, dataset->getOriginalXfer(), CIF_UsePartialAccessToPixelData,
+                     static_cast<unsigned long>(firstFrame), static_cast<unsigned long>(available - firstFrame));
+    if (image.getStatus() != EIS_Normal) {
+        qDebug() << "Erro ao decodificar frames:" << DicomImage::getString(image.getStatus());
+        return images;
+    }
+    if (!image.setWindow(0)) {
+        image.setMinMaxWindow();
+    }
+
+    images.reserve(available - firstFrame);
+    for (int i = 0; i < available - firstFrame; ++i) {
+        if (progress && !progress(i * 100 / (available - firstFrame))) {
+            return QVector<QImage>();
+        }
+        const QImage frame = outputImage(&image, i);
+        if (frame.isNull()) {
+            return QVector<QImage>();
+        }
+        images.append(frame);
+    }
+    if (progress) progress(100);
+
+    qCDebug(dicomPerf) << "loadColorFrames:" << images.size() << "frames em" << timer.elapsed() << "ms -" << source.path;
+    return images;
+}
+
+/**
+ * @brief Decodifica todos os frames de um objeto em um bloco contíguo.
+ * @details Etapas:
+ * 1. PixelData encapsulado: decodeEncapsulated já escreve cada frame no seu plano do bloco.
+ * 2. Demais: os frames de loadFrames (mapeamento ou DCMTK, com deslocamento comum) são
+ *    copiados em paralelo para o bloco.
+ */
+DicomVolume DicomManager::loadVolume(const QString &path, const DicomProgressCallback &progress) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // [1] Encapsulado: descompressão paralela direto no bloco
+    DicomFrameSource source;
+    if (source.open(path) && source.mapped.isEncapsulated()) {
+        bool canceled = false;
+        DicomVolume volume = decodeEncapsulated(source, source.header.getDataset(), 0, source.frameCount, progress, canceled);
+        if (canceled) {
+            return DicomVolume();
+        }
+        if (!volume.isNull()) {
+            if (progress) progress(100);
+            qCDebug(dicomPerf) << "loadVolume (paralelo):" << volume.depth << "frames em" << timer.elapsed() << "ms -" << path;
+            return volume;
+        }
+    }
+
+    // [2] Demais: cópia dos frames para o bloco
+    const QVector<DicomPixelData> frames = loadFrames(source, 0, std::numeric_limits<int>::max(), progress);
+    DicomVolume volume;
+    if (frames.isEmpty()) {
+        return volume;
+    }
+
+    const DicomPixelData &first = frames.first();
+    const qint64 sliceSize = qint64(first.width) * first.height;
+    const std::shared_ptr<quint16> voxels = allocateVoxels(sliceSize * frames.size());
+    if (!voxels) {
+        return volume;
+    }
+    DicomScheduler::instance().parallelFor(frames.size(), [&](int z) {
+        std::memcpy(voxels.get() + sliceSize * z, frames.at(z).pixels.get(), size_t(sliceSize) * sizeof(quint16));
+    });
+
+    volume.width = first.width;
+    volume.height = first.height;
+    volume.depth = frames.size();
+    volume.valueOffset = first.valueOffset;
+    volume.minStored = 65535;
+    for (const DicomPixelData &frame : frames) {
+        volume.minStored = std::min(volume.minStored, frame.minStored);
+        volume.maxStored = std::max(volume.maxStored, frame.maxStored);
+    }
+    volume.windowCenter = first.windowCenter;
+    volume.windowWidth = first.windowWidth;
+    volume.sigmoid = first.sigmoid;
+    volume.inverted = first.inverted;
+    volume.voxels = voxels;
+
+    DcmFileFormat fileformat;
+    if (loadHeader(path, fileformat).good()) {
+        volumeSpacing(fileformat.getDataset(), volume);
+    }
+
+    qCDebug(dicomPerf) << "loadVolume:" << volume.depth << "frames em" << timer.elapsed() << "ms -" << path;
+    return volume;
+}
+
+/// Quantidade mínima de elementos por bloco da ordenação paralela.
+static const int kMinSortChunk = 64;
+
+/**
+ * @brief Ordenação paralela: blocos ordenados no escalonador e intercalados em rodadas.
+ * @details Com n blocos, a primeira etapa ordena cada bloco em uma tarefa; as rodadas
+ * seguintes intercalam pares vizinhos (std::inplace_merge), também em paralelo, até restar
+ * um único bloco. Listas pequenas são ordenadas direto na thread chamadora.
+ */
+template <typename T, typename Less>
+static void parallelSort(std::vector<T> &items, Less less) {
+    DicomScheduler &scheduler = DicomScheduler::instance();
+    const int chunks = std::min(scheduler.workerCount(), int(items.size()) / kMinSortChunk);
+    if (chunks < 2) {
+        std::sort(items.begin(), items.end(), less);
+        return;
+    }
+
+    std::vector<size_t> bounds(size_t(chunks) + 1);
+    for (int i = 0; i <= chunks; ++i) {
+        bounds[size_t(i)] = items.size() * size_t(i) / size_t(chunks);
+    }
+    scheduler.parallelFor(chunks, [&](int c) {
+        std::sort(items.begin() + bounds[size_t(c)], items.begin() + bounds[size_t(c) + 1], less);
+    });
+
+    for (int width = 1; width < chunks; width *= 2) {
+        const int pairs = (chunks + 2 * width - 1) / (2 * width);
+        scheduler.parallelFor(pairs, [&](int p) {
+            const int left = p * 2 * width;
+            const int middle = std::min(left + width, chunks);
+            const int right = std::min(left + 2 * width, chunks);
+            if (middle < right) {
+                std::inplace_merge(items.begin() + bounds[size_t(left)], items.begin() + bounds[size_t(middle)],
+                                   items.begin() + bounds[size_t(right)], less);
+            }
+        });
+    }
+}
+
+/**
+ * @struct SeriesSlice
+ * @brief Dados de um corte lidos só do Header: ordenação, dimensões e faixa de valores.
+ */
+struct SeriesSlice {
+    QString path;              ///< Arquivo do corte
+    bool readable = false;     ///< Header lido e imagem monocromática
+    bool hasPosition = false;  ///< Image Position e Image Orientation presentes
+    double position = 0.0;     ///< Posição ao longo da normal do plano (mm)
+    int instanceNumber = 0;    ///< Instance Number
+    int rows = 0;              ///< Linhas
+    int columns = 0;           ///< Colunas
+    qint64 lowest = 0;         ///< Menor valor de modalidade possível (lowestModalityValue)
+};
+
+/**
+ * @brief Lê o Header de um corte da série.
+ * @details A posição de ordenação é a projeção de Image Position Patient na normal do
+ * plano (produto vetorial das direções de linha e coluna de Image Orientation Patient),
+ * que cresce de forma monotônica ao longo da pilha qualquer que seja a orientação.
+ */
+static SeriesSlice readSeriesSlice(const QString &path) {
+    SeriesSlice slice;
+    slice.path = path;
+
+    DcmFileFormat fileformat;
+    if (loadHeader(path, fileformat).bad()) {
+        return slice;
+    }
+    DcmDataset *dataset = fileformat.getDataset();
+
+    Uint16 rows = 0, columns = 0, samples = 1;
+    Sint32 instanceNumber = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_SamplesPerPixel, samples);
+    dataset->findAndGetSint32(DCM_InstanceNumber, instanceNumber);
+    slice.rows = rows;
+    slice.columns = columns;
+    slice.instanceNumber = instanceNumber;
+    slice.lowest = lowestModalityValue(dataset);
+    slice.readable = (rows > 0 && columns > 0 && samples == 1);
+
+    Float64 ipp[3] = {0.0, 0.0, 0.0};
+    Float64 iop[6] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    bool complete = true;
+    for (unsigned long i = 0; i < 3 && complete; ++i) {
+        complete = dataset->findAndGetFloat64(DCM_ImagePositionPatient, ipp[i], i).good();
+    }
+    for (unsigned long i = 0; i < 6 && complete; ++i) {
+        complete = dataset->findAndGetFloat64(DCM_ImageOrientationPatient, iop[i], i).good();
+    }
+    if (complete) {
+        const double normal[3] = {iop[1] * iop[5] - iop[2] * iop[4],
+                                  iop[2] * iop[3] - iop[0] * iop[5],
+                                  iop[0] * iop[4] - iop[1] * iop[3]};
+        slice.position = ipp[0] * normal[0] + ipp[1] * normal[1] + ipp[2] * normal[2];
+        slice.hasPosition = true;
+    }
+    return slice;
+}
+
+/**
+ * @brief Decodifica o único frame de um corte direto no seu plano do volume da série.
+ * @details Nenhum buffer do tamanho do corte é alocado além do próprio plano:
+ * 1. Encapsulado: decodeEncapsulated escreve no plano (FrameTarget), já com o deslocamento
+ *    da série.
+ * 2. Sem compressão mapeado: os valores do mapeamento são deslocados para o plano (a única cópia).
+ * 3. Demais: os pixels intermediários da DicomImage são convertidos direto para o plano.
+ * @param target Bloco da série, plano do corte e deslocamento comum.
+ * @param rows Linhas esperadas (as do primeiro corte).
+ * @param columns Colunas esperadas.
+ * @param stop Pedido de cancelamento da série.
+ * @return false se o corte não pôde ser decodificado com essas dimensões (plano indefinido).
+ */
+static bool decodeSlice(const QString &path, const FrameTarget &target, int rows, int columns,
+                        const std::atomic_bool &stop) {
+    const qint64 sliceSize = qint64(rows) * columns;
+    quint16 *plane = target.voxels.get() + sliceSize * target.firstPlane;
+
+    DicomFrameSource source;
+    if (source.open(path)) {
+        DcmDataset *dataset = source.header.getDataset();
+        Uint16 headerRows = 0, headerColumns = 0;
+        dataset->findAndGetUint16(DCM_Rows, headerRows);
+        dataset->findAndGetUint16(DCM_Columns, headerColumns);
+        if (headerRows != rows || headerColumns != columns) {
+            return false;
+        }
+
+        // [1] Encapsulado: direto no plano
+        if (source.mapped.isEncapsulated()) {
+            bool canceled = false;
+            const DicomVolume volume = decodeEncapsulated(source, dataset, 0, 1, [&stop](int) {
+                return !stop.load();
+            }, canceled, &target);
+            if (canceled) {
+                return false;
+            }
+            if (!volume.isNull()) {
+                return true;
+            }
+        }
+
+        // [2] Sem compressão: do mapeamento para o plano
+        const DicomPixelData pixels = mappedPixelData(source.mapped, dataset, 0);
+        if (!pixels.isNull()) {
+            const qint64 shift = qint64(pixels.valueOffset) - target.valueOffset;
+            const quint16 *src = pixels.pixels.get();
+            for (qint64 i = 0; i < sliceSize; ++i) {
+                const qint64 value = qint64(src[i]) + shift;
+                plane[i] = quint16(value < 0 ? 0 : (value > 65535 ? 65535 : value));
+            }
+            return true;
+        }
+    }
+
+    // [3] DCMTK: pixels intermediários convertidos para o plano
+    DcmFileFormat fileformat;
+    if (stop.load() || loadDeferred(path, fileformat).bad()) {
+        return false;
+    }
+    DicomImage image(&fileformat, fileformat.getDataset()->getOriginalXfer(), CIF_UsePartialAccessToPixelData, 0, 1);
+    const DiPixel *inter = (image.getStatus() == EIS_Normal && image.isMonochrome()) ? image.getInterData() : nullptr;
+    if (inter == nullptr || inter->getData() == nullptr || int(image.getWidth()) != columns ||
+        int(image.getHeight()) != rows || inter->getCount() < size_t(sliceSize)) {
+        return false;
+    }
+    return interToStored(inter, 0, plane, size_t(sliceSize), target.valueOffset);
+}
+
+/**
+ * @brief Empilha os cortes de uma série em um volume contíguo.
+ * @details Etapas:
+ * 1. Headers lidos em paralelo (parallelFor), sem pixels.
+ * 2. Ordenação paralela pela posição ao longo da normal (se todos os cortes a tiverem) ou
+ *    pelo Instance Number; empates pelo caminho, para a ordem ser sempre a mesma.
+ * 3. Cortes com dimensões diferentes das do primeiro são descartados.
+ * 4. Bloco alocado uma única vez; o deslocamento comum é o menor lowestModalityValue.
+ * 5. Cada corte é decodificado em uma tarefa direto no seu plano (decodeSlice: descompressão,
+ *    mapeamento ou DCMTK, já com o deslocamento comum); a faixa armazenada é combinada no fim.
+ * 6. Janela, espaçamento e metadados vêm do primeiro corte; o espaçamento entre planos é a
+ *    mediana das distâncias entre posições consecutivas, quando houver posições.
+ * O progresso (0-20% Headers, 20-100% pixels) é reportado só na thread chamadora.
+ */
+DicomSeriesResult DicomManager::loadSeries(const QStringList &paths, const DicomProgressCallback &progress) {
+    DicomSeriesResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    DicomScheduler &scheduler = DicomScheduler::instance();
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic_bool stop{false};
+    std::atomic_int done{0};
+
+    // Reporta o progresso (apenas na thread chamadora) e registra o pedido de cancelamento
+    auto report = [&](int percent) {
+        if (progress && std::this_thread::get_id() == caller && !progress(percent)) {
+            stop.store(true);
+        }
+    };
+
+    // [1] Headers em paralelo
+    std::vector<SeriesSlice> slices(size_t(paths.size()));
+    scheduler.parallelFor(paths.size(), [&](int i) {
+        if (stop.load()) {
+            return;
+        }
+        slices[size_t(i)] = readSeriesSlice(paths.at(i));
+        report((done.fetch_add(1) + 1) * 20 / paths.size());
+    });
+    if (stop.load()) {
+        result.canceled = true;
+        return result;
+    }
+    slices.erase(std::remove_if(slices.begin(), slices.end(), [](const SeriesSlice &s) { return !s.readable; }),
+                 slices.end());
+    if (slices.empty()) {
+        return result;
+    }
+
+    // [2] Ordenação
+    const bool byPosition = std::all_of(slices.begin(), slices.end(), [](const SeriesSlice &s) { return s.hasPosition; });
+    parallelSort(slices, [byPosition](const SeriesSlice &a, const SeriesSlice &b) {
+        if (byPosition && a.position != b.position) {
+            return a.position < b.position;
+        }
+        if (a.instanceNumber != b.instanceNumber) {
+            return a.instanceNumber < b.instanceNumber;
+        }
+        return a.path < b.path;
+    });
+
+    // [3] Dimensões do primeiro corte
+    const int rows = slices.front().rows;
+    const int columns = slices.front().columns;
+    const size_t total = slices.size();
+    slices.erase(std::remove_if(slices.begin(), slices.end(), [rows, columns](const SeriesSlice &s) {
+        return s.rows != rows || s.columns != columns;
+    }), slices.end());
+    if (slices.size() != total) {
+        qDebug() << "loadSeries:" << total - slices.size() << "cortes com dimensões diferentes ignorados";
+    }
+
+    // [4] Bloco único e deslocamento comum
+    const int depth = int(slices.size());
+    const qint64 sliceSize = qint64(rows) * columns;
+    qint64 offset = slices.front().lowest;
+    for (const SeriesSlice &slice : slices) {
+        offset = std::min(offset, slice.lowest);
+    }
+    const std::shared_ptr<quint16> voxels = allocateVoxels(sliceSize * depth);
+    if (!voxels) {
+        qDebug() << "Memória insuficiente para o volume:" << sliceSize * depth * 2 / (1024 * 1024) << "MB";
+        return result;
+    }
+
+    // [5] Um corte por tarefa, direto no seu plano
+    std::mutex mutex;
+    quint16 minStored = 65535, maxStored = 0;
+    std::atomic_int failed{0};
+    done.store(0);
+    scheduler.parallelFor(depth, [&](int z) {
+        if (stop.load()) {
+            return;
+        }
+        quint16 *plane = voxels.get() + sliceSize * z;
+        FrameTarget target;
+        target.voxels = voxels;
+        target.firstPlane = z;
+        target.valueOffset = offset;
+        if (!decodeSlice(slices[size_t(z)].path, target, rows, columns, stop)) {
+            std::fill(plane, plane + sliceSize, quint16(0));
+            failed.fetch_add(1);
+            return;
+        }
+
+        quint16 planeMin = 65535, planeMax = 0;
+        storedRange(plane, sliceSize, planeMin, planeMax);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            minStored = std::min(minStored, planeMin);
+            maxStored = std::max(maxStored, planeMax);
+        }
+        report(20 + (done.fetch_add(1) + 1) * 80 / depth);
+    });
+    if (stop.load()) {
+        result.canceled = true;
+        return result;
+    }
+    if (failed.load() == depth) {
+        return result;
+    }
+    if (failed.load() > 0) {
+        qDebug() << "loadSeries:" << failed.load() << "cortes não puderam ser decodificados";
+    }
+
+    // [6] Geometria, janela e metadados
+    DicomVolume &volume = result.volume;
+    volume.width = columns;
+    volume.height = rows;
+    volume.depth = depth;
+    volume.valueOffset = int(offset);
+    volume.minStored = minStored;
+    volume.maxStored = maxStored;
+
+    DcmFileFormat header;
+    if (loadHeader(slices.front().path, header).good()) {
+        DcmDataset *dataset = header.getDataset();
+        OFString photometric;
+        dataset->findAndGetOFString(DCM_PhotometricInterpretation, photometric);
+        volume.inverted = (photometric == "MONOCHROME1");
+        initialWindow(dataset, volume);
+        volumeSpacing(dataset, volume);
+        result.metadata = readMetadata(dataset);
+        result.metadata.dimensions += QString(" x %1 cortes").arg(depth);
+    } else {
+        initialWindow(nullptr, volume);
+    }
+
+    if (byPosition && depth > 1) {
+        std::vector<double> gaps;
+        gaps.reserve(size_t(depth) - 1);
+        for (int z = 1; z < depth; ++z) {
+            gaps.push_back(slices[size_t(z)].position - slices[size_t(z) - 1].position);
+        }
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        if (gaps[gaps.size() / 2] > 0.0) {
+            volume.spacingZ = gaps[gaps.size() / 2];
+        }
+    }
+
+    volume.voxels = voxels;
+    for (const SeriesSlice &slice : slices) {
+        result.paths.append(slice.path);
+    }
+
+    qCDebug(dicomPerf) << "loadSeries:" << depth << "cortes em" << timer.elapsed() << "ms";
+    return result;
+}
+
+/**
+ * @brief Compara o decodificador JPEG Lossless próprio com o codec da DCMTK.
+ * @details Para cada frame, as duas decodificações são repetidas kBenchmarkRuns vezes e vale
+ * o melhor tempo de cada uma. A DCMTK decodifica pelo codec registrado em
+ * DJDecoderRegistration (DcmPixelData::getUncompressedFrame), sobre o mesmo dataset de frame
+ * usado no carregamento. Fluxo concatenado e dataset do frame são montados antes das
+ * medições, que cobrem só a decodificação. A razão compara os dois decodificadores em uma
+ * thread; o tempo do próprio com os intervalos de restart em paralelo (como no
+ * carregamento) é registrado à parte. A comparação é feita sobre as amostras brutas, antes
+ * de qualquer conversão. O resultado vai para o log (qDebug).
+ */
+bool DicomManager::benchmarkJpegLossless(const QString &path) {
+    static const int kBenchmarkRuns = 5;
+
+    DicomMappedFile mapped;
+    DcmFileFormat header;
+    if (!mapped.open(path) || !mapped.isEncapsulated() || !DicomJpegLossless::supports(mapped.transferSyntax()) ||
+        !mapped.readHeader(header)) {
+        qDebug() << "benchmarkJpegLossless: arquivo não é JPEG Lossless SV1 encapsulado -" << path;
+        return false;
+    }
+
+    DcmDataset *dataset = header.getDataset();
+    Uint16 rows = 0, columns = 0, bitsAllocated = 0;
+    dataset->findAndGetUint16(DCM_Rows, rows);
+    dataset->findAndGetUint16(DCM_Columns, columns);
+    dataset->findAndGetUint16(DCM_BitsAllocated, bitsAllocated);
+    const int frames = numberOfFrames(dataset);
+    QVector<QVector<DicomMappedFile::Fragment>> fragments;
+    if (rows == 0 || columns == 0 || bitsAllocated != 16 || !mapped.frameFragments(frames, fragments)) {
+        qDebug() << "benchmarkJpegLossless: só imagens de 16 bits alocados com fragmentos válidos -" << path;
+        return false;
+    }
+
+    const E_TransferSyntax xfer = DcmXfer(mapped.transferSyntax().constData()).getXfer();
+    const uchar *mapping = mapped.data().get();
+    const size_t sliceSize = size_t(rows) * columns;
+    std::vector<quint16> own(sliceSize), reference(sliceSize);
+    qint64 ownNs = 0, parallelNs = 0, dcmtkNs = 0;
+    int fallbacks = 0, mismatches = 0;
+    QElapsedTimer timer;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        const QVector<DicomMappedFile::Fragment> &frameFragments = fragments.at(frame);
+
+        // [1] Decodificador próprio: fluxo do frame concatenado uma vez, fora da medição;
+        // primeiro em uma thread (base da razão), depois com os intervalos em paralelo
+        std::vector<uchar> storage;
+        size_t length = 0;
+        const uchar *stream = frameStream(mapping, frameFragments, storage, length);
+        qint64 best = std::numeric_limits<qint64>::max();
+        qint64 bestParallel = std::numeric_limits<qint64>::max();
+        bool decoded = true;
+        for (int run = 0; run < kBenchmarkRuns && decoded; ++run) {
+            timer.start();
+            decoded = DicomJpegLossless::decode(stream, length, columns, rows, own.data(), false);
+            best = std::min(best, timer.nsecsElapsed());
+        }
+        for (int run = 0; run < kBenchmarkRuns && decoded; ++run) {
+            timer.start();
+            decoded = DicomJpegLossless::decode(stream, length, columns, rows, own.data());
+            bestParallel = std::min(bestParallel, timer.nsecsElapsed());
+        }
+        if (!decoded) {
+            ++fallbacks;
+            continue;
+        }
+        ownNs += best;
+        parallelNs += bestParallel;
+
+        // [2] DCMTK (uma thread): codec registrado. O dataset do frame (cópia do Header e dos
+        // fragmentos) também é montado fora da medição.
+        DcmDataset frameSet(*dataset);
+        DcmPixelData *pixelData = attachFrame(&frameSet, mapping, frameFragments, xfer);
+        best = std::numeric_limits<qint64>::max();
+        bool ok = true;
+        for (int run = 0; run < kBenchmarkRuns && ok; ++run) {
+            timer.start();
+            Uint32 startFragment = 0;
+            OFString colorModel;
+            ok = pixelData->getUncompressedFrame(&frameSet, 0, startFragment, reference.data(),
+                                                 Uint32(sliceSize * sizeof(quint16)), colorModel).good();
+            best = std::min(best, timer.nsecsElapsed());
+        }
+        if (!ok) {
+            qDebug() << "benchmarkJpegLossless: a DCMTK não decodificou o frame" << frame;
+            return false;
+        }
+        dcmtkNs += best;
+
+        // [3] Amostras idênticas bit a bit
+        if (std::memcmp(own.data(), reference.data(), sliceSize * sizeof(quint16)) != 0) {
+            ++mismatches;
+        }
+    }
+
+    const double ownMs = ownNs / 1e6, parallelMs = parallelNs / 1e6, dcmtkMs = dcmtkNs / 1e6;
+    qDebug().noquote() << QString("benchmarkJpegLossless: %1 frame(s) %2x%3 - uma thread: próprio %4 ms, "
+                                  "DCMTK %5 ms (%6x); próprio com intervalos de restart em paralelo "
+                                  "(%7 worker(s)) %8 ms; %9 divergente(s), %10 com reserva na DCMTK - %11")
+                              .arg(frames).arg(columns).arg(rows)
+                              .arg(ownMs, 0, 'f', 1).arg(dcmtkMs, 0, 'f', 1)
+                              .arg(ownMs > 0.0 ? dcmtkMs / ownMs : 0.0, 0, 'f', 1)
+                              .arg(DicomScheduler::instance().workerCount()).arg(parallelMs, 0, 'f', 1)
+                              .arg(mismatches).arg(fallbacks).arg(path);
+    return mismatches == 0 && fallbacks < frames;
+}
@@ -11,7 +11,22 @@
 #define DICOMMANAGER_H
 
 #include <QString>
+#include <QStringList>
 #include <QImage>
+#include <QRect>
+#include <QSize>
+#include <QMetaType>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+
+// Declarações antecipadas da DCMTK (evita expor os headers da biblioteca na interface)
+class DcmDataset;
+class DicomImage;
+
+// Arquivo aberto para pedidos repetidos de frames (definido em DicomManager.cpp)
+struct DicomFrameSource;
 
 /**
  * @struct DicomMetadata
@@ -28,6 +43,182 @@ struct DicomMetadata {
     bool isValid = false; ///< Flag para indicar se a extração foi bem-sucedida
 };
 
+/**
+ * @struct DicomInstanceInfo
+ * @brief Tags de identificação de uma instância, usadas para indexar pastas inteiras.
+ * @details Contém apenas o necessário para montar a hierarquia Paciente -> Estudo -> Série ->
+ * Instância do navegador de pastas; é lida somente do Header do arquivo.
+ */
+struct DicomInstanceInfo {
+    QString path;               ///< Caminho absoluto do arquivo
+    QString patientID;          ///< ID do Paciente (0010,0020)
+    QString patientName;        ///< Nome do Paciente (0010,0010), '^' trocado por espaço
+    QString studyInstanceUID;   ///< Study Instance UID (0020,000D)
+    QString studyDate;          ///< Data do Estudo (0008,0020), formato DICOM YYYYMMDD
+    QString studyDescription;   ///< Descrição do Estudo (0008,1030)
+    QString seriesInstanceUID;  ///< Series Instance UID (0020,000E)
+    QString seriesDescription;  ///< Descrição da Série (0008,103E)
+    QString sopInstanceUID;     ///< SOP Instance UID (0008,0018)
+    QString modality;           ///< Modalidade (0008,0060)
+    int seriesNumber = 0;       ///< Series Number (0020,0011)
+    int instanceNumber = 0;     ///< Instance Number (0020,0013)
+    qint64 fileSize = 0;        ///< Tamanho do arquivo na leitura (reindexação incremental)
+    qint64 modified = 0;        ///< Data de modificação na leitura (ms desde a época)
+    bool isValid = false;       ///< true se o arquivo é DICOM e tem os três UIDs
+};
+
+Q_DECLARE_METATYPE(DicomInstanceInfo)
+
+/**
+ * @struct DicomPixelData
+ * @brief Pixels de um frame em profundidade nativa, já com a Modality LUT aplicada.
+ * @details Os valores de modalidade (12-16 bits na mamografia, HU na tomografia, etc.) são
+ * armazenados em 16 bits sem sinal com um deslocamento: valor = pixels[i] + valueOffset.
+ * O buffer é compartilhado (std::shared_ptr), então cópias da estrutura são baratas e
+ * qualquer visualização em 8 bits pode ser derivada novamente sem reler o arquivo.
+ */
+struct DicomPixelData {
+    int width = 0;                          ///< Colunas
+    int height = 0;                         ///< Linhas
+    int valueOffset = 0;                    ///< Deslocamento somado ao valor armazenado
+    quint16 minStored = 0;                  ///< Menor valor armazenado no frame
+    quint16 maxStored = 0;                  ///< Maior valor armazenado no frame
+    double windowCenter = 0.0;              ///< Window Center inicial (valores de modalidade)
+    double windowWidth = 0.0;               ///< Window Width inicial (valores de modalidade)
+    bool sigmoid = false;                   ///< VOI LUT Function = SIGMOID (senão LINEAR)
+    bool inverted = false;                  ///< MONOCHROME1 (valores altos são escuros)
+    std::shared_ptr<const quint16> pixels;  ///< width * height valores (linhas contíguas)
+
+    /// Indica se não há pixels carregados.
+    bool isNull() const { return !pixels || width <= 0 || height <= 0; }
+
+    /// Memória ocupada pelos pixels (bytes).
+    qint64 byteSize() const { return qint64(width) * height * qint64(sizeof(quint16)); }
+
+    /// Ponteiro para o início da linha y.
+    const quint16 *scanLine(int y) const { return pixels.get() + qint64(y) * width; }
+};
+
+Q_DECLARE_METATYPE(DicomPixelData)
+
+/**
+ * @struct DicomVolume
+ * @brief Conjunto de frames em profundidade nativa em um único bloco contíguo (volume).
+ * @details Mesma convenção de DicomPixelData (valor = voxels[i] + valueOffset), com faixa e
+ * janela comuns a todos os planos. O bloco é alocado uma única vez, alinhado a 64 bytes, com
+ * os planos em sequência (plano z começa em z * width * height).
+ */
+struct DicomVolume {
+    int width = 0;                          ///< Colunas
+    int height = 0;                         ///< Linhas
+    int depth = 0;                          ///< Quantidade de planos (frames)
+    int valueOffset = 0;                    ///< Deslocamento somado ao valor armazenado
+    quint16 minStored = 0;                  ///< Menor valor armazenado no volume
+    quint16 maxStored = 0;                  ///< Maior valor armazenado no volume
+    double windowCenter = 0.0;              ///< Window Center inicial (valores de modalidade)
+    double windowWidth = 0.0;               ///< Window Width inicial (valores de modalidade)
+    bool sigmoid = false;                   ///< VOI LUT Function = SIGMOID (senão LINEAR)
+    bool inverted = false;                  ///< MONOCHROME1 (valores altos são escuros)
+    double spacingX = 1.0;                  ///< Distância entre colunas (mm)
+    double spacingY = 1.0;                  ///< Distância entre linhas (mm)
+    double spacingZ = 1.0;                  ///< Distância entre planos (mm)
+    std::shared_ptr<const quint16> voxels;  ///< width * height * depth valores (alinhado a 64 bytes)
+
+    /// Indica se não há voxels carregados.
+    bool isNull() const { return !voxels || width <= 0 || height <= 0 || depth <= 0; }
+
+    /// Valores por plano.
+    qint64 sliceSize() const { return qint64(width) * height; }
+
+    /// Memória ocupada pelos voxels (bytes).
+    qint64 byteSize() const { return sliceSize() * depth * qint64(sizeof(quint16)); }
+
+    /**
+     * @brief Plano z como DicomPixelData, sem cópia (o ponteiro mantém o volume vivo).
+     */
+    DicomPixelData frame(int z) const {
+        DicomPixelData data;
+        if (isNull() || z < 0 || z >= depth) {
+            return data;
+        }
+        data.width = width;
+        data.height = height;
+        data.valueOffset = valueOffset;
+        data.minStored = minStored;
+        data.maxStored = maxStored;
+        data.windowCenter = windowCenter;
+        data.windowWidth = windowWidth;
+        data.sigmoid = sigmoid;
+        data.inverted = inverted;
+        data.pixels = std::shared_ptr<const quint16>(voxels, voxels.get() + sliceSize() * z);
+        return data;
+    }
+};
+
+/**
+ * @struct DicomSeriesResult
+ * @brief Resultado do empilhamento de uma série em um volume (DicomManager::loadSeries).
+ */
+struct DicomSeriesResult {
+    QStringList paths;      ///< Arquivos empilhados, na ordem dos planos
+    DicomVolume volume;     ///< Cortes em um único bloco contíguo
+    DicomMetadata metadata; ///< Metadados do primeiro corte (dimensões incluem a quantidade de cortes)
+    bool canceled = false;  ///< true se o carregamento foi interrompido pelo chamador
+
+    /// Indica se há um volume para exibir.
+    bool isValid() const { return !volume.isNull(); }
+};
+
+Q_DECLARE_METATYPE(DicomSeriesResult)
+
+/**
+ * @struct DicomLoadResult
+ * @brief Resultado do carregamento completo de um arquivo DICOM (pixels + metadados).
+ * @details Agrupa tudo o que a tela do visualizador precisa após abrir um arquivo,
+ * permitindo que a imagem e o overlay sejam obtidos a partir de uma única leitura do disco.
+ */
+struct DicomLoadResult {
+    QString path;           ///< Caminho do arquivo de origem
+    QImage image;           ///< Imagem em 8 bits da DCMTK (apenas sem pixels nativos, ex.: coloridas)
+    DicomPixelData pixels;  ///< Pixels em profundidade nativa (nulos para imagens coloridas)
+    QVector<DicomPixelData> pyramid; ///< Níveis 2x reduzidos; pyramid[0] compartilha o buffer de 'pixels'
+    DicomMetadata metadata; ///< Metadados extraídos do mesmo dataset da imagem
+    int frameCount = 1;     ///< Number of Frames do objeto (só o primeiro é decodificado; demais via loadFrames)
+    double frameRate = 0.0; ///< Frames por segundo (Frame Time ou Cine Rate); 0 se o arquivo não informa
+    bool canceled = false;  ///< true se o carregamento foi interrompido pelo chamador
+
+    /// Indica se há algo para exibir (pixels nativos ou imagem em 8 bits).
+    bool isValid() const { return !pixels.isNull() || !image.isNull(); }
+};
+
+Q_DECLARE_METATYPE(DicomLoadResult)
+
+/**
+ * @struct DicomPreview
+ * @brief Pré-visualização de baixa resolução, disponível antes da decodificação completa.
+ * @details Obtida apenas do Header do arquivo (Icon Image Sequence, tag 0088,0200); só o
+ * ícone, de poucos KB, passa pelo codec. Exibida esticada para o tamanho original até o
+ * DicomLoadResult chegar.
+ */
+struct DicomPreview {
+    QString path;           ///< Caminho do arquivo de origem
+    QImage image;           ///< Ícone em 8 bits (nulo se o arquivo não tiver ícone)
+    QSize fullSize;         ///< Dimensões da imagem completa (Columns x Rows)
+    DicomMetadata metadata; ///< Metadados do overlay (lidos do mesmo Header)
+
+    /// Indica se há algo para exibir.
+    bool isValid() const { return !image.isNull() && !fullSize.isEmpty(); }
+};
+
+Q_DECLARE_METATYPE(DicomPreview)
+
+/**
+ * @brief Callback de progresso do carregamento.
+ * @details Recebe o percentual concluído (0-100) e retorna false para solicitar o cancelamento.
+ * É chamado a partir da thread que executa o carregamento.
+ */
+using DicomProgressCallback = std::function<bool(int percent)>;
+
 /**
  * @class DicomManager
  * @brief Classe utilitária estática para carregar e processar imagens médicas.
@@ -43,6 +234,7 @@ public:
      *
      * Este método realiza a leitura dos metadados e dos pixels, aplica
      * as correções de fotometria e gera uma imagem pronta para renderização.
+     * Em objetos multi-frame, apenas o primeiro frame é decodificado.
      *
      * @param path O caminho completo (absoluto ou relativo) para o arquivo .dcm.
      * @return QImage A imagem processada em escala de cinza (8-bit). 
@@ -52,12 +244,234 @@ public:
 
     /**
      * @brief Extrai metadados textuais do arquivo DICOM (Overlay).
-     * * Lê o cabeçalho do arquivo DICOM sem processar os pixels da imagem,
-     * tornando a operação extremamente rápida.
+     * * Lê o cabeçalho do arquivo DICOM e interrompe a leitura no PixelData (7FE0,0010),
+     * sem ler nem processar os pixels da imagem. O I/O fica na ordem de kilobytes,
+     * tornando a operação adequada para preencher listas com milhares de arquivos.
      * * @param path O caminho completo para o arquivo .dcm.
      * @return DicomMetadata Estrutura contendo as tags principais (Nome, Data, etc).
      */
     static DicomMetadata extractMetadata(const QString &path);
+
+    /**
+     * @brief Lê as tags de identificação (UIDs, números, datas) de um arquivo.
+     *
+     * Mesma leitura limitada de extractMetadata (apenas Header, valores grandes adiados):
+     * adequada para indexar dezenas de milhares de arquivos em paralelo.
+     *
+     * @param path O caminho completo para o arquivo.
+     * @return DicomInstanceInfo Tags lidas; isValid = false se o arquivo não for DICOM ou não
+     * tiver Study/Series/SOP Instance UID.
+     */
+    static DicomInstanceInfo extractInstanceInfo(const QString &path);
+
+    /**
+     * @brief Lê a pré-visualização embutida no arquivo (Icon Image Sequence).
+     *
+     * Assim como extractMetadata, lê apenas o Header (para no PixelData), então o custo
+     * fica em poucos milissegundos mesmo para arquivos comprimidos de vários MB.
+     * Em arquivos comprimidos o ícone costuma estar encapsulado na mesma sintaxe de
+     * transferência (ex.: JPEG Lossless na mamografia de exemplo) e é decodificado pelos
+     * codecs registrados, o que custa pouco para um ícone de 64 x 64.
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @return DicomPreview Ícone, dimensões completas e metadados; DicomPreview::isValid()
+     * retorna false se o arquivo não tiver ícone ou não puder ser lido.
+     */
+    static DicomPreview loadPreview(const QString &path);
+
+    /**
+     * @brief Gera uma miniatura em 8 bits sem decodificar a imagem em resolução completa
+     * quando possível (ícone embutido), ou decodificando apenas o primeiro frame.
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @param maxSize Lado máximo da miniatura em pixels.
+     * @return QImage Miniatura em Grayscale8 (RGB888 se colorida), ou nula em caso de falha.
+     */
+    static QImage loadThumbnail(const QString &path, int maxSize);
+
+    /**
+     * @brief Carrega imagem e metadados com uma única leitura do arquivo.
+     *
+     * O arquivo é lido e interpretado uma única vez (DcmFileFormat). O mesmo dataset
+     * alimenta a DicomImage (pixels) e o preenchimento do DicomMetadata (overlay),
+     * evitando a leitura dupla de `loadDicomImage` + `extractMetadata`.
+     *
+     * Pode ser executado fora da thread da interface: o progresso é reportado por etapas
+     * (leitura, metadados, decodificação, renderização) e o cancelamento é verificado entre elas.
+     *
+     * Em objetos multi-frame, só o primeiro frame é lido e decodificado (acesso parcial ao
+     * PixelData); os demais ficam no disco até serem pedidos com loadFrames().
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @param progress Callback opcional de progresso/cancelamento.
+     * @return DicomLoadResult Pixels nativos + pirâmide (ou imagem em 8 bits para coloridas) e metadados.
+     * Em caso de falha, DicomLoadResult::isValid() retorna false.
+     * Se o callback solicitar o cancelamento, retorna com canceled = true e imagem nula.
+     */
+    static DicomLoadResult loadDicomFile(const QString &path, const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Decodifica um intervalo de frames de um objeto multi-frame, sob demanda.
+     *
+     * Apenas os frames pedidos são lidos do disco e descomprimidos, então a memória acompanha
+     * o intervalo e não o objeto inteiro. Arquivos sem compressão elegíveis (ver
+     * loadDicomFile) devolvem os frames direto do mapeamento, sem cópia. PixelData
+     * encapsulado (comprimido) é descomprimido frame a frame em paralelo, no escalonador,
+     * para um bloco contíguo compartilhado pelos frames devolvidos. Os demais casos usam o
+     * acesso parcial ao PixelData da DCMTK (CIF_UsePartialAccessToPixelData).
+     *
+     * Todos os frames de uma mesma chamada compartilham valueOffset e janela inicial.
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @param firstFrame Primeiro frame (0 = primeiro do objeto).
+     * @param count Quantidade de frames (recortada ao fim do objeto).
+     * @param progress Callback opcional de progresso/cancelamento (consultado a cada frame).
+     * @return QVector<DicomPixelData> Frames em profundidade nativa; vazio em caso de falha,
+     * cancelamento ou imagem colorida.
+     */
+    static QVector<DicomPixelData> loadFrames(const QString &path, int firstFrame, int count,
+                                              const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Abre um arquivo uma única vez para vários pedidos de frames.
+     *
+     * Mapeia o arquivo e lê o Header e a tabela de fragmentos; os pedidos feitos com a fonte
+     * (loadFrames, loadColorFrames) só decodificam os frames, sem reabrir nem reinterpretar
+     * o arquivo. A fonte pode ser usada por várias threads ao mesmo tempo.
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @return Fonte nunca nula; arquivos que não podem ser mapeados são lidos pela DCMTK a cada pedido.
+     */
+    static std::shared_ptr<const DicomFrameSource> openFrameSource(const QString &path);
+
+    /**
+     * @brief Igual a loadFrames(path, ...), sobre um arquivo já aberto com openFrameSource().
+     */
+    static QVector<DicomPixelData> loadFrames(const DicomFrameSource &source, int firstFrame, int count,
+                                              const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Renderiza em 8 bits (RGB888) um intervalo de frames de um objeto colorido.
+     *
+     * Imagens coloridas não têm pixels nativos (loadFrames devolve vazio para elas); os
+     * frames saem como o primeiro em DicomLoadResult::image. Frames encapsulados ou sem
+     * compressão são lidos do mapeamento e renderizados em paralelo, um por tarefa.
+     *
+     * @param source Arquivo aberto com openFrameSource().
+     * @param firstFrame Primeiro frame (0 = primeiro do objeto).
+     * @param count Quantidade de frames (recortada ao fim do objeto).
+     * @param progress Callback opcional de progresso/cancelamento.
+     * @return QVector<QImage> Frames renderizados; vazio em caso de falha ou cancelamento.
+     */
+    static QVector<QImage> loadColorFrames(const DicomFrameSource &source, int firstFrame, int count,
+                                           const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Decodifica todos os frames de um objeto em um único volume contíguo.
+     *
+     * O bloco é alocado antes da decodificação, no tamanho final. Em PixelData encapsulado,
+     * os fragmentos de cada frame são localizados pela Extended/Basic Offset Table (ou um
+     * fragmento por frame) e os frames são descomprimidos em paralelo, cada um direto no seu
+     * plano do bloco: o tempo acompanha a quantidade de núcleos, não o codec de uma thread.
+     *
+     * @param path O caminho completo para o arquivo .dcm.
+     * @param progress Callback opcional de progresso/cancelamento.
+     * @return DicomVolume Volume com todos os frames; nulo em caso de falha, cancelamento ou
+     * imagem colorida.
+     */
+    static DicomVolume loadVolume(const QString &path, const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Empilha os arquivos de uma série (um corte por arquivo) em um volume contíguo.
+     *
+     * Os Headers são lidos em paralelo e os cortes ordenados (também em paralelo) pela
+     * posição ao longo da normal do plano (Image Position / Image Orientation Patient) ou,
+     * na falta dela, pelo Instance Number. Os pixels de cada corte são decodificados no
+     * escalonador direto no seu plano de um bloco alocado uma única vez (alinhado a 64
+     * bytes), com um deslocamento comum a todos os cortes. Depois disso, trocar de corte
+     * é só remapear um plano em memória: nenhum arquivo é relido.
+     *
+     * @param paths Arquivos da série (qualquer ordem).
+     * @param progress Callback opcional de progresso/cancelamento.
+     * @return DicomSeriesResult Volume, ordem dos arquivos e metadados; inválido em caso de
+     * falha, cancelamento (canceled = true) ou imagens coloridas. Cortes com dimensões
+     * diferentes das do primeiro são ignorados.
+     */
+    static DicomSeriesResult loadSeries(const QStringList &paths, const DicomProgressCallback &progress = {});
+
+    /**
+     * @brief Gera uma visualização em 8 bits a partir dos pixels em profundidade nativa.
+     *
+     * Aplica a VOI (janela linear ou sigmoide, conforme o arquivo) e a inversão de
+     * MONOCHROME1 sem acessar o disco nem o codec. É a base do janelamento interativo.
+     *
+     * @param pixels Pixels em profundidade nativa (DicomLoadResult::pixels).
+     * @param center Window Center em valores de modalidade.
+     * @param width Window Width em valores de modalidade.
+     * @return QImage Imagem em Grayscale8, ou nula se pixels.isNull().
+     */
+    static QImage renderWindow(const DicomPixelData &pixels, double center, double width);
+
+    /**
+     * @brief Gera a visualização em 8 bits de apenas uma região dos pixels nativos.
+     *
+     * Usado na renderização por blocos (tiles): só a parte visível da imagem é processada.
+     *
+     * @param pixels Pixels em profundidade nativa.
+     * @param center Window Center em valores de modalidade.
+     * @param width Window Width em valores de modalidade.
+     * @param region Região em coordenadas de pixel (recortada aos limites da imagem).
+     * @return QImage Imagem em Grayscale8 do tamanho da região, ou nula se a região for vazia.
+     */
+    static QImage renderWindow(const DicomPixelData &pixels, double center, double width, const QRect &region);
+
+    /**
+     * @brief Constrói a pirâmide de resolução (mipmap) a partir dos pixels nativos.
+     *
+     * Cada nível é a média 2x2 do anterior, até o maior lado ficar menor ou igual a minSize.
+     * A exibição usa o nível mais próximo do zoom atual, então o custo de desenho
+     * acompanha os pixels da tela e não os da imagem original.
+     *
+     * @param base Pixels em resolução completa (nível 0, compartilhado sem cópia).
+     * @param minSize Tamanho (lado maior) a partir do qual não se reduz mais.
+     * @return QVector<DicomPixelData> Níveis do mais detalhado (0) ao mais reduzido; vazio se base for nulo.
+     */
+    static QVector<DicomPixelData> buildPyramid(const DicomPixelData &base, int minSize = 256);
+
+    /**
+     * @brief Compara o decodificador JPEG Lossless próprio (DicomJpegLossless) com a DCMTK.
+     *
+     * Decodifica cada frame pelos dois caminhos, registra no log o melhor tempo de cada um
+     * e verifica se as amostras são idênticas. Exige os codecs da DCMTK registrados.
+     *
+     * @param path Arquivo JPEG Lossless SV1 (1.2.840.10008.1.2.4.70) com 16 bits alocados.
+     * @return bool true se todos os frames decodificados pelos dois caminhos forem idênticos bit a bit.
+     */
+    static bool benchmarkJpegLossless(const QString &path);
+
+private:
+    /**
+     * @brief Copia os pixels de um frame (pós Modality LUT) para um DicomPixelData.
+     * @param image Imagem DCMTK válida e monocromática.
+     * @param dataset Dataset de origem (usado para ler a VOI LUT Function).
+     * @param frame Índice do frame entre os decodificados pela DicomImage (0 = primeiro).
+     * @return DicomPixelData Pixels nativos e janela inicial; nulo se a imagem não for monocromática.
+     */
+    static DicomPixelData extractPixelData(DicomImage *image, DcmDataset *dataset, int frame = 0);
+
+    /**
+     * @brief Preenche a estrutura de metadados a partir de um dataset já carregado.
+     * @param dataset Dataset DICOM lido previamente (não pode ser nulo).
+     * @return DicomMetadata Estrutura preenchida com isValid = true.
+     */
+    static DicomMetadata readMetadata(DcmDataset *dataset);
+
+    /**
+     * @brief Aplica o janelamento inicial e converte uma DicomImage para QImage (8 bits).
+     * @param image Imagem DCMTK já carregada (não é liberada por este método).
+     * @return QImage Imagem em Grayscale8 (RGB888 se colorida), ou nula se a imagem for inválida.
+     */
+    static QImage renderImage(DicomImage *image);
 };
 
 #endif // DICOMMANAGER_H
\ No newline at end of file
@@ -0,0 +1,334 @@
+/**
+ * @file DicomMappedFile.cpp
+ * @brief Implementação da leitura de arquivos DICOM mapeados em memória.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomMappedFile.h"
+
+#define HAVE_CONFIG_H // Definição necessária para compilação da DCMTK em ambiente Windows
+
+#include <dcmtk/config/osconfig.h>
+#include <dcmtk/dcmdata/dcfilefo.h>  // DcmFileFormat
+#include <dcmtk/dcmdata/dcistrmb.h>  // DcmInputBufferStream (leitura a partir de memória)
+
+#include <QFile>
+
+#include <cstring>
+
+/// UID da sintaxe de transferência Explicit VR Little Endian.
+static const char kExplicitLittleEndian[] = "1.2.840.10008.1.2.1";
+
+/// Sintaxes cujo dataset não é Explicit VR Little Endian (não percorridas).
+static const char *const kOtherEncodings[] = {
+    "1.2.840.10008.1.2",        // Implicit VR Little Endian
+    "1.2.840.10008.1.2.2",      // Explicit VR Big Endian
+    "1.2.840.10008.1.2.1.99",   // Deflated Explicit VR Little Endian
+};
+
+/// Comprimento indefinido (sequências e itens delimitados).
+static const quint32 kUndefinedLength = 0xFFFFFFFFu;
+
+/// Profundidade máxima de sequências aninhadas aceita pelo percurso.
+static const int kMaxDepth = 16;
+
+static quint16 readU16(const uchar *p) { return quint16(p[0] | (p[1] << 8)); }
+static quint32 readU32(const uchar *p) { return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24); }
+
+/**
+ * @brief Cabeçalho de um elemento em Explicit VR Little Endian.
+ */
+struct ElementHeader {
+    quint16 group = 0;
+    quint16 element = 0;
+    quint32 length = 0;
+    qint64 valueOffset = 0; ///< Posição do valor (logo após o cabeçalho)
+};
+
+/**
+ * @brief Lê o cabeçalho do elemento em 'pos'.
+ * @details Itens e delimitadores (grupo FFFE) não têm VR. Os VRs de cabeçalho longo
+ * (OB, OW, SQ, UN...) têm 2 bytes reservados e comprimento de 4 bytes.
+ */
+static bool readElementHeader(const uchar *data, qint64 size, qint64 pos, ElementHeader &header) {
+    if (pos + 8 > size) {
+        return false;
+    }
+    header.group = readU16(data + pos);
+    header.element = readU16(data + pos + 2);
+
+    if (header.group == 0xFFFE) {
+        header.length = readU32(data + pos + 4);
+        header.valueOffset = pos + 8;
+        return true;
+    }
+
+    const char vr[3] = {char(data[pos + 4]), char(data[pos + 5]), 0};
+    static const char *const longVRs[] = {"OB", "OD", "OF", "OL", "OV", "OW", "SQ", "SV", "UC", "UN", "UR", "UT", "UV"};
+    bool longHeader = false;
+    for (const char *candidate : longVRs) {
+        longHeader = longHeader || std::strcmp(vr, candidate) == 0;
+    }
+
+    if (longHeader) {
+        if (pos + 12 > size) {
+            return false;
+        }
+        header.length = readU32(data + pos + 8);
+        header.valueOffset = pos + 12;
+    } else {
+        header.length = readU16(data + pos + 6);
+        header.valueOffset = pos + 8;
+    }
+    return true;
+}
+
+static bool skipElement(const uchar *data, qint64 size, const ElementHeader &header, qint64 &pos, int depth);
+
+/**
+ * @brief Pula uma sequência de comprimento indefinido (itens até o Sequence Delimitation Item).
+ * @details Itens de comprimento indefinido são percorridos elemento a elemento até o Item
+ * Delimitation Item, já que o conteúdo pode ter outras sequências indefinidas.
+ */
+static bool skipUndefinedSequence(const uchar *data, qint64 size, qint64 &pos, int depth) {
+    if (depth > kMaxDepth) {
+        return false;
+    }
+    for (;;) {
+        ElementHeader item;
+        if (!readElementHeader(data, size, pos, item) || item.group != 0xFFFE) {
+            return false;
+        }
+        pos = item.valueOffset;
+        if (item.element == 0xE0DD) {
+            return true; // Sequence Delimitation Item
+        }
+        if (item.element != 0xE000) {
+            return false;
+        }
+        if (item.length != kUndefinedLength) {
+            pos += item.length;
+            continue;
+        }
+        for (;;) {
+            ElementHeader nested;
+            if (!readElementHeader(data, size, pos, nested)) {
+                return false;
+            }
+            if (nested.group == 0xFFFE && nested.element == 0xE00D) {
+                pos = nested.valueOffset; // Item Delimitation Item
+                break;
+            }
+            if (!skipElement(data, size, nested, pos, depth + 1)) {
+                return false;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Avança 'pos' para depois do elemento (valor definido ou sequência indefinida).
+ */
+static bool skipElement(const uchar *data, qint64 size, const ElementHeader &header, qint64 &pos, int depth) {
+    pos = header.valueOffset;
+    if (header.length == kUndefinedLength) {
+        return skipUndefinedSequence(data, size, pos, depth);
+    }
+    pos += header.length;
+    return pos <= size;
+}
+
+/**
+ * @brief Mapeia o arquivo e percorre Meta Header e dataset até o PixelData.
+ * @details Etapas:
+ * 1. QFile::map do arquivo inteiro (nenhum byte é lido neste momento).
+ * 2. Preâmbulo de 128 bytes + "DICM"; o Meta Header (grupo 0002) é sempre Explicit VR
+ *    Little Endian e traz a sintaxe de transferência (0002,0010).
+ * 3. Sintaxes com dataset em Explicit VR Little Endian seguem adiante; os elementos do
+ *    dataset principal são pulados pelo comprimento até a tag (7FE0,0010), guardando a
+ *    Extended Offset Table se aparecer. Só as páginas dos cabeçalhos dos elementos são
+ *    tocadas, então o custo não depende do tamanho dos pixels.
+ * 4. PixelData encapsulado: lê a Basic Offset Table (1º item) e registra a posição de cada
+ *    fragmento até o Sequence Delimitation Item.
+ */
+bool DicomMappedFile::open(const QString &path) {
+    m_mapping.reset();
+    m_encapsulated = false;
+    m_basicOffsets.clear();
+    m_extendedOffsets.clear();
+    m_fragments.clear();
+    m_fragmentItems.clear();
+
+    // [1] Mapeamento
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < 132) {
+        return false;
+    }
+    const qint64 size = file->size();
+    uchar *mapped = file->map(0, size);
+    if (mapped == nullptr) {
+        return false;
+    }
+    // O deleter guarda o QFile: o mapeamento vive enquanto algum ponteiro o referenciar
+    std::shared_ptr<const uchar> mapping(mapped, [file](const uchar *address) { file->unmap(const_cast<uchar *>(address)); });
+
+    // [2] Meta Header
+    if (std::memcmp(mapped + 128, "DICM", 4) != 0) {
+        return false;
+    }
+    qint64 pos = 132;
+    QByteArray transferSyntax;
+    ElementHeader header;
+    while (readElementHeader(mapped, size, pos, header) && header.group == 0x0002) {
+        if (header.element == 0x0010 && header.valueOffset + header.length <= size) {
+            transferSyntax = QByteArray(reinterpret_cast<const char *>(mapped + header.valueOffset), int(header.length));
+            while (transferSyntax.endsWith('\0') || transferSyntax.endsWith(' ')) {
+                transferSyntax.chop(1);
+            }
+        }
+        if (!skipElement(mapped, size, header, pos, 0)) {
+            return false;
+        }
+    }
+    if (transferSyntax.isEmpty()) {
+        return false;
+    }
+    for (const char *other : kOtherEncodings) {
+        if (transferSyntax == other) {
+            return false;
+        }
+    }
+    m_transferSyntax = transferSyntax;
+
+    // [3] Dataset principal até o PixelData
+    while (readElementHeader(mapped, size, pos, header)) {
+        if (header.group == 0x7FE0 && header.element == 0x0001 && header.length != kUndefinedLength &&
+            header.valueOffset + header.length <= size) {
+            for (quint32 i = 0; i + 8 <= header.length; i += 8) {
+                const uchar *value = mapped + header.valueOffset + i;
+                m_extendedOffsets.append(quint64(readU32(value)) | (quint64(readU32(value + 4)) << 32));
+            }
+        }
+        if (header.group == 0x7FE0 && header.element == 0x0010) {
+            m_pixelTag = pos;
+            if (header.length != kUndefinedLength) {
+                if (header.valueOffset + header.length > size) {
+                    return false;
+                }
+                m_pixelOffset = header.valueOffset;
+                m_pixelLength = header.length;
+                m_mapping = mapping;
+                return true;
+            }
+
+            // [4] Encapsulado: Basic Offset Table + fragmentos
+            pos = header.valueOffset;
+            ElementHeader item;
+            if (!readElementHeader(mapped, size, pos, item) || item.group != 0xFFFE || item.element != 0xE000 ||
+                item.length == kUndefinedLength || item.valueOffset + item.length > size) {
+                return false;
+            }
+            for (quint32 i = 0; i + 4 <= item.length; i += 4) {
+                m_basicOffsets.append(readU32(mapped + item.valueOffset + i));
+            }
+            pos = item.valueOffset + item.length;
+
+            const qint64 firstFragment = pos;
+            while (readElementHeader(mapped, size, pos, item) && item.group == 0xFFFE) {
+                if (item.element == 0xE0DD) {
+                    m_encapsulated = true;
+                    m_mapping = mapping;
+                    return !m_fragments.isEmpty();
+                }
+                if (item.element != 0xE000 || item.length == kUndefinedLength ||
+                    item.valueOffset + item.length > size) {
+                    break;
+                }
+                m_fragmentItems.append(pos - firstFragment);
+                m_fragments.append(Fragment{item.valueOffset, qint64(item.length)});
+                pos = item.valueOffset + item.length;
+            }
+            return false;
+        }
+        if (header.group > 0x7FE0 || !skipElement(mapped, size, header, pos, 0)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool DicomMappedFile::isNative() const {
+    return m_mapping && !m_encapsulated && m_transferSyntax == kExplicitLittleEndian;
+}
+
+/**
+ * @brief Divide os fragmentos entre os frames.
+ * @details As tabelas de deslocamento apontam para o início do item (tag FFFE,E000) do
+ * primeiro fragmento de cada frame, contado a partir do primeiro item após a Basic Offset
+ * Table; um frame vai até o início do próximo.
+ */
+bool DicomMappedFile::frameFragments(int frameCount, QVector<QVector<Fragment>> &frames) const {
+    frames.clear();
+    if (!m_encapsulated || frameCount <= 0) {
+        return false;
+    }
+
+    // Sem tabela: um fragmento por frame, ou um único frame com todos os fragmentos
+    const QVector<quint64> &table = !m_extendedOffsets.isEmpty() ? m_extendedOffsets : m_basicOffsets;
+    if (table.size() != frameCount) {
+        if (m_fragments.size() == frameCount) {
+            for (const Fragment &fragment : m_fragments) {
+                frames.append(QVector<Fragment>{fragment});
+            }
+            return true;
+        }
+        if (frameCount == 1) {
+            frames.append(m_fragments);
+            return true;
+        }
+        return false;
+    }
+
+    // Com tabela: localiza o item inicial de cada frame
+    frames.resize(frameCount);
+    int fragment = 0;
+    for (int frame = 0; frame < frameCount; ++frame) {
+        const qint64 start = qint64(table.at(frame));
+        const qint64 end = (frame + 1 < frameCount) ? qint64(table.at(frame + 1)) : -1;
+        while (fragment < m_fragmentItems.size() && m_fragmentItems.at(fragment) < start) {
+            ++fragment;
+        }
+        if (fragment >= m_fragmentItems.size() || m_fragmentItems.at(fragment) != start) {
+            frames.clear();
+            return false; // Tabela inconsistente com os fragmentos
+        }
+        while (fragment < m_fragmentItems.size() && (end < 0 || m_fragmentItems.at(fragment) < end)) {
+            frames[frame].append(m_fragments.at(fragment));
+            ++fragment;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Entrega à DCMTK os bytes anteriores ao PixelData, direto do mapeamento.
+ * @details O DcmInputBufferStream lê da memória informada; o fim do buffer (setEos) marca o
+ * fim do dataset, então o PixelData nunca é lido nem copiado pela DCMTK.
+ */
+bool DicomMappedFile::readHeader(DcmFileFormat &fileformat) const {
+    if (!m_mapping) {
+        return false;
+    }
+
+    DcmInputBufferStream stream;
+    stream.setBuffer(m_mapping.get(), offile_off_t(m_pixelTag));
+    stream.setEos();
+
+    fileformat.transferInit();
+    const OFCondition status = fileformat.read(stream);
+    fileformat.transferEnd();
+    stream.releaseBuffer();
+
+    return status.good() || status == EC_StreamNotifyClient;
+}
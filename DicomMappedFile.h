@@ -0,0 +1,107 @@
+/**
+ * @file DicomMappedFile.h
+ * @brief Definição da leitura de arquivos DICOM mapeados em memória (mmap).
+ * @details Para arquivos sem compressão (Explicit VR Little Endian), o PixelData é usado
+ * diretamente no mapeamento do arquivo: abrir um multi-frame de centenas de MB não aloca
+ * nem copia os pixels antes de exibir o primeiro frame. Para PixelData encapsulado
+ * (comprimido), os fragmentos de cada frame são localizados no mapeamento, permitindo
+ * descomprimir frames independentes em paralelo.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMMAPPEDFILE_H
+#define DICOMMAPPEDFILE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include <memory>
+
+class DcmFileFormat;
+
+/**
+ * @class DicomMappedFile
+ * @brief Arquivo DICOM mapeado com a posição do PixelData localizada sem copiar nada.
+ *
+ * open() mapeia o arquivo inteiro (QFile::map), lê a sintaxe de transferência no Meta
+ * Header e, se o dataset for codificado em Explicit VR Little Endian (a sintaxe nativa e
+ * todas as comprimidas), percorre os elementos do dataset principal (apenas tags e
+ * comprimentos) até o PixelData. PixelData encapsulado tem os itens (Basic Offset Table e
+ * fragmentos) registrados; a Extended Offset Table (7FE0,0001), se presente, também.
+ * readHeader() entrega à DCMTK somente os bytes anteriores ao PixelData, através de um
+ * DcmInputBufferStream sobre o mapeamento, sem passar pelo fluxo de arquivo bufferizado.
+ *
+ * Os ponteiros devolvidos por pixelData() apontam para dentro do mapeamento; data() mantém
+ * o mapeamento vivo (use-o como dono em um std::shared_ptr de aliasing).
+ */
+class DicomMappedFile {
+public:
+    /**
+     * @struct Fragment
+     * @brief Fragmento de PixelData encapsulado (posição do valor no arquivo).
+     */
+    struct Fragment {
+        qint64 offset = 0;  ///< Início dos bytes comprimidos no mapeamento
+        qint64 length = 0;  ///< Comprimento em bytes
+    };
+
+    /**
+     * @brief Mapeia o arquivo e localiza o PixelData.
+     * @param path O caminho do arquivo .dcm.
+     * @return false se o arquivo não puder ser mapeado, não tiver o dataset em Explicit VR
+     * Little Endian ou não tiver PixelData legível (nesses casos use o caminho da DCMTK).
+     */
+    bool open(const QString &path);
+
+    /// UID da sintaxe de transferência (Meta Header).
+    const QByteArray &transferSyntax() const { return m_transferSyntax; }
+
+    /// PixelData sem compressão em Explicit VR Little Endian (pixels utilizáveis no mapeamento).
+    bool isNative() const;
+
+    /// PixelData encapsulado (comprimido, fragmentos).
+    bool isEncapsulated() const { return m_encapsulated; }
+
+    /**
+     * @brief Fragmentos de cada frame de um PixelData encapsulado.
+     * @details A divisão usa, nesta ordem: Extended Offset Table, Basic Offset Table, um
+     * fragmento por frame ou, para um único frame, todos os fragmentos.
+     * @param frameCount Number of Frames do objeto.
+     * @param frames Destino: frames[i] = fragmentos do frame i, em ordem.
+     * @return false se a divisão não puder ser determinada.
+     */
+    bool frameFragments(int frameCount, QVector<QVector<Fragment>> &frames) const;
+
+    /**
+     * @brief Interpreta Meta Header e dataset (tudo antes do PixelData) a partir do mapeamento.
+     * @param fileformat Destino da leitura.
+     * @return true se a DCMTK aceitou os dados.
+     */
+    bool readHeader(DcmFileFormat &fileformat) const;
+
+    /// Início do valor do PixelData nativo dentro do mapeamento (nulo se open() falhou).
+    const uchar *pixelData() const { return m_mapping ? m_mapping.get() + m_pixelOffset : nullptr; }
+
+    /// Comprimento do valor do PixelData em bytes.
+    qint64 pixelLength() const { return m_pixelLength; }
+
+    /// Mapeamento do arquivo inteiro (o deleter desfaz o mapeamento e fecha o arquivo).
+    const std::shared_ptr<const uchar> &data() const { return m_mapping; }
+
+private:
+    std::shared_ptr<const uchar> m_mapping;  ///< Arquivo inteiro mapeado
+    qint64 m_pixelTag = 0;                   ///< Posição da tag (7FE0,0010)
+    qint64 m_pixelOffset = 0;                ///< Posição do valor do PixelData
+    qint64 m_pixelLength = 0;                ///< Comprimento do valor do PixelData
+    QByteArray m_transferSyntax;             ///< UID da sintaxe de transferência
+    bool m_encapsulated = false;             ///< PixelData com comprimento indefinido
+    QVector<quint64> m_basicOffsets;         ///< Basic Offset Table (relativa ao 1º fragmento)
+    QVector<quint64> m_extendedOffsets;      ///< Extended Offset Table (7FE0,0001)
+    QVector<Fragment> m_fragments;           ///< Fragmentos, em ordem
+    QVector<qint64> m_fragmentItems;         ///< Posição de cada item, relativa ao 1º fragmento
+};
+
+#endif // DICOMMAPPEDFILE_H
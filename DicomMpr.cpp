@@ -0,0 +1,414 @@
+/**
+ * @file DicomMpr.cpp
+ * @brief Implementação da reconstrução multiplanar (MPR) e das projeções em slab.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomMpr.h"
+#include "DicomLog.h"
+#include "DicomScheduler.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // Intrínsecos SSE2 (mistura das quatro linhas e redução dos slabs)
+#endif
+
+/// Alinhamento (bytes) do bloco de voxels em blocos (linha de cache).
+static const size_t kBrickAlignment = 64;
+
+/// Maior altura de um plano reformatado (espaçamentos entre cortes absurdos no Header).
+static const int kMaxReformatRows = 8192;
+
+/// Abaixo desta quantidade de pixels o plano é reformatado só na thread chamadora.
+static const qint64 kMinParallelPixels = 1 << 16;
+
+using Brick = DicomBrickedVolume;
+
+/**
+ * @brief Tamanho do plano reformatado e passo entre linhas da saída em planos do volume.
+ * @details Coronal e sagital têm pixels quadrados: a altura é a extensão da pilha
+ * ((depth - 1) * spacingZ) dividida pela distância entre pixels da linha da saída.
+ */
+struct PlaneGeometry {
+    int width = 0;        ///< Colunas da saída
+    int height = 0;       ///< Linhas da saída
+    double zStep = 0.0;   ///< Planos do volume por linha da saída (coronal/sagital)
+};
+
+static PlaneGeometry planeGeometry(const DicomVolume &volume, DicomMpr::Plane plane) {
+    PlaneGeometry geometry;
+    if (plane == DicomMpr::Plane::Axial) {
+        geometry.width = volume.width;
+        geometry.height = volume.height;
+        return geometry;
+    }
+
+    const bool coronal = (plane == DicomMpr::Plane::Coronal);
+    const double pixel = coronal ? volume.spacingX : volume.spacingY;
+    geometry.width = coronal ? volume.width : volume.height;
+    geometry.height = 1;
+    if (volume.depth > 1 && pixel > 0.0) {
+        const double extent = (volume.depth - 1) * volume.spacingZ / pixel;
+        geometry.height = std::min(kMaxReformatRows, int(std::lround(extent)) + 1);
+    }
+    geometry.zStep = (geometry.height > 1) ? double(volume.depth - 1) / (geometry.height - 1) : 0.0;
+    return geometry;
+}
+
+DicomBrickedVolume DicomMpr::brick(const DicomVolume &volume) {
+    DicomBrickedVolume bricks;
+    if (volume.isNull()) {
+        return bricks;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bricks.width = volume.width;
+    bricks.height = volume.height;
+    bricks.depth = volume.depth;
+    bricks.bricksX = (volume.width + Brick::kBrickMask) >> Brick::kBrickShift;
+    bricks.bricksY = (volume.height + Brick::kBrickMask) >> Brick::kBrickShift;
+    bricks.bricksZ = (volume.depth + Brick::kBrickMask) >> Brick::kBrickShift;
+
+    const qint64 count = qint64(bricks.bricksX) * bricks.bricksY * bricks.bricksZ * Brick::kBrickVoxels;
+    void *memory = ::operator new[](size_t(count) * sizeof(quint16), std::align_val_t(kBrickAlignment), std::nothrow);
+    if (memory == nullptr) {
+        qDebug() << "Memória insuficiente para o volume em blocos:" << count * 2 / (1024 * 1024) << "MB";
+        return DicomBrickedVolume();
+    }
+    quint16 *dst = static_cast<quint16 *>(memory);
+    bricks.voxels = std::shared_ptr<const quint16>(dst, [](const quint16 *voxels) {
+        ::operator delete[](const_cast<quint16 *>(voxels), std::align_val_t(kBrickAlignment));
+    });
+
+    // Uma tarefa por linha de blocos (bz, by): lê width valores contíguos de cada linha do volume
+    const quint16 *src = volume.voxels.get();
+    const qint64 sliceSize = volume.sliceSize();
+    DicomScheduler::instance().parallelFor(bricks.bricksZ * bricks.bricksY, [&](int row) {
+        const int bz = row / bricks.bricksY;
+        const int by = row % bricks.bricksY;
+        for (int bx = 0; bx < bricks.bricksX; ++bx) {
+            quint16 *out = const_cast<quint16 *>(bricks.brick(bx, by, bz));
+            const int x0 = bx << Brick::kBrickShift;
+            const int n = std::min(Brick::kBrickSize, volume.width - x0);
+            for (int lz = 0; lz < Brick::kBrickSize; ++lz) {
+                const int z = (bz << Brick::kBrickShift) + lz;
+                for (int ly = 0; ly < Brick::kBrickSize; ++ly, out += Brick::kBrickSize) {
+                    const int y = (by << Brick::kBrickShift) + ly;
+                    if (z >= volume.depth || y >= volume.height) {
+                        std::fill(out, out + Brick::kBrickSize, quint16(0));
+                        continue;
+                    }
+                    std::memcpy(out, src + sliceSize * z + qint64(y) * volume.width + x0, size_t(n) * sizeof(quint16));
+                    std::fill(out + n, out + Brick::kBrickSize, quint16(0));
+                }
+            }
+        }
+    });
+
+    qCDebug(dicomPerf) << "MPR: volume em blocos" << bricks.bricksX << "x" << bricks.bricksY << "x" << bricks.bricksZ
+             << "em" << timer.elapsed() << "ms";
+    return bricks;
+}
+
+int DicomMpr::sliceCount(const DicomVolume &volume, Plane plane) {
+    switch (plane) {
+    case Plane::Axial:
+        return volume.depth;
+    case Plane::Coronal:
+        return volume.height;
+    case Plane::Sagittal:
+        return volume.width;
+    }
+    return 0;
+}
+
+/**
+ * @brief Lê kBrickSize valores de uma linha do volume, a partir de 'start' (múltiplo de kBrickSize).
+ * @details A linha anda em x (alongX) ou em y; as outras coordenadas são fixas. O trecho
+ * fica inteiro em um bloco: em x são valores contíguos, em y o passo é kBrickSize.
+ */
+static void fetchSpan(const DicomBrickedVolume &bricks, bool alongX, int start, int fixed, int z, quint16 *out) {
+    const int inner = (z & Brick::kBrickMask) << (2 * Brick::kBrickShift);
+    if (alongX) {
+        const quint16 *line = bricks.brick(start >> Brick::kBrickShift, fixed >> Brick::kBrickShift, z >> Brick::kBrickShift)
+                              + inner + ((fixed & Brick::kBrickMask) << Brick::kBrickShift);
+        std::memcpy(out, line, Brick::kBrickSize * sizeof(quint16));
+    } else {
+        const quint16 *line = bricks.brick(fixed >> Brick::kBrickShift, start >> Brick::kBrickShift, z >> Brick::kBrickShift)
+                              + inner + (fixed & Brick::kBrickMask);
+        for (int i = 0; i < Brick::kBrickSize; ++i) {
+            out[i] = line[i << Brick::kBrickShift];
+        }
+    }
+}
+
+/**
+ * @brief Mistura quatro linhas com os pesos bilineares (kBrickSize valores).
+ * @details Com SSE2 processa 8 valores por iteração: expande 16 -> 32 bits, converte para
+ * float, acumula os quatro produtos e volta para 16 bits sem sinal (o empacotamento com
+ * sinal do SSE2 é feito com o valor deslocado de 32768).
+ */
+static void blendSpan(const quint16 (&lines)[4][Brick::kBrickSize], const float (&weights)[4], quint16 *out) {
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias = _mm_set1_epi32(32768);
+    const __m128i flip = _mm_set1_epi16(short(0x8000));
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 w[4] = {_mm_set1_ps(weights[0]), _mm_set1_ps(weights[1]),
+                         _mm_set1_ps(weights[2]), _mm_set1_ps(weights[3])};
+
+    for (; i + 8 <= Brick::kBrickSize; i += 8) {
+        __m128 lo = half;
+        __m128 hi = half;
+        for (int k = 0; k < 4; ++k) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[k] + i));
+            lo = _mm_add_ps(lo, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), w[k]));
+            hi = _mm_add_ps(hi, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), w[k]));
+        }
+        const __m128i a = _mm_sub_epi32(_mm_cvttps_epi32(lo), bias);
+        const __m128i b = _mm_sub_epi32(_mm_cvttps_epi32(hi), bias);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_xor_si128(_mm_packs_epi32(a, b), flip));
+    }
+#endif
+
+    for (; i < Brick::kBrickSize; ++i) {
+        const float value = 0.5f + lines[0][i] * weights[0] + lines[1][i] * weights[1]
+                                 + lines[2][i] * weights[2] + lines[3][i] * weights[3];
+        out[i] = quint16(std::min(65535.0f, value));
+    }
+}
+
+/**
+ * @brief Amostra uma linha da saída: eixo da linha em x (alongX) ou y, coordenadas fixas (b, z).
+ * @details As coordenadas da linha caem em centros de voxels; b e z são fracionárias e
+ * definem as quatro linhas vizinhas e os pesos. A linha é percorrida bloco a bloco.
+ */
+static void sampleRow(const DicomBrickedVolume &bricks, bool alongX, double b, double z, int count, quint16 *dst) {
+    const int limitB = (alongX ? bricks.height : bricks.width) - 1;
+    b = std::min(std::max(b, 0.0), double(limitB));
+    z = std::min(std::max(z, 0.0), double(bricks.depth - 1));
+
+    const int b0 = int(b);
+    const int b1 = std::min(b0 + 1, limitB);
+    const int z0 = int(z);
+    const int z1 = std::min(z0 + 1, bricks.depth - 1);
+    const float fb = float(b - b0);
+    const float fz = float(z - z0);
+    const float weights[4] = {(1.0f - fb) * (1.0f - fz), fb * (1.0f - fz), (1.0f - fb) * fz, fb * fz};
+
+    alignas(16) quint16 lines[4][Brick::kBrickSize];
+    alignas(16) quint16 mixed[Brick::kBrickSize];
+    for (int start = 0; start < count; start += Brick::kBrickSize) {
+        fetchSpan(bricks, alongX, start, b0, z0, lines[0]);
+        fetchSpan(bricks, alongX, start, b1, z0, lines[1]);
+        fetchSpan(bricks, alongX, start, b0, z1, lines[2]);
+        fetchSpan(bricks, alongX, start, b1, z1, lines[3]);
+        blendSpan(lines, weights, mixed);
+        std::memcpy(dst + start, mixed, size_t(std::min(Brick::kBrickSize, count - start)) * sizeof(quint16));
+    }
+}
+
+/**
+ * @brief Aloca a saída de um plano com a convenção de valores, a faixa e a janela do volume.
+ * @param buffer Destino: início dos pixels (preenchidos pelo chamador).
+ */
+static DicomPixelData planeData(const DicomVolume &volume, const PlaneGeometry &geometry, quint16 *&buffer) {
+    DicomPixelData data;
+    buffer = new quint16[size_t(geometry.width) * size_t(geometry.height)];
+    data.pixels = std::shared_ptr<const quint16>(buffer, std::default_delete<quint16[]>());
+    data.width = geometry.width;
+    data.height = geometry.height;
+    data.valueOffset = volume.valueOffset;
+    data.minStored = volume.minStored;
+    data.maxStored = volume.maxStored;
+    data.windowCenter = volume.windowCenter;
+    data.windowWidth = volume.windowWidth;
+    data.sigmoid = volume.sigmoid;
+    data.inverted = volume.inverted;
+    return data;
+}
+
+/**
+ * @brief Indica se o volume em blocos corresponde ao volume.
+ */
+static bool matches(const DicomVolume &volume, const DicomBrickedVolume &bricks) {
+    return !bricks.isNull() && bricks.width == volume.width && bricks.height == volume.height
+           && bricks.depth == volume.depth;
+}
+
+/**
+ * @brief Reformata um plano.
+ * @details Etapas:
+ * 1. Geometria da saída (planeGeometry) e validação do plano pedido.
+ * 2. Cada linha da saída é amostrada por sampleRow; as linhas são divididas em faixas
+ *    entre as threads do DicomScheduler (a thread chamadora participa).
+ */
+DicomPixelData DicomMpr::reformat(const DicomVolume &volume, const DicomBrickedVolume &bricks, Plane plane, double slice) {
+    if (volume.isNull() || !matches(volume, bricks) || slice < 0.0 || slice > sliceCount(volume, plane) - 1) {
+        return DicomPixelData();
+    }
+
+    // [1] Geometria
+    const PlaneGeometry geometry = planeGeometry(volume, plane);
+    quint16 *buffer = nullptr;
+    const DicomPixelData data = planeData(volume, geometry, buffer);
+
+    // [2] Linhas em paralelo
+    const qint64 pixelCount = qint64(geometry.width) * geometry.height;
+    DicomScheduler::instance().parallelForRows(geometry.height, pixelCount, kMinParallelPixels, [&](int first, int last) {
+        for (int v = first; v < last; ++v) {
+            quint16 *dst = buffer + qint64(v) * geometry.width;
+            const double z = (geometry.height - 1 - v) * geometry.zStep; // Último plano no topo
+            switch (plane) {
+            case Plane::Axial:
+                sampleRow(bricks, true, v, slice, geometry.width, dst);
+                break;
+            case Plane::Coronal:
+                sampleRow(bricks, true, slice, z, geometry.width, dst);
+                break;
+            case Plane::Sagittal:
+                sampleRow(bricks, false, slice, z, geometry.width, dst);
+                break;
+            }
+        }
+    });
+    return data;
+}
+
+/**
+ * @brief Linha v do plano s da orientação (plano inteiro, sem interpolação entre planos).
+ * @details No axial a linha é lida direto do volume contíguo; no coronal e no sagital é
+ * amostrada dos blocos em 'scratch' (interpolada apenas em z, como em reformat()).
+ */
+static const quint16 *planeRow(const DicomVolume &volume, const DicomBrickedVolume &bricks, DicomMpr::Plane plane,
+                               const PlaneGeometry &geometry, int s, int v, quint16 *scratch) {
+    const double z = (geometry.height - 1 - v) * geometry.zStep;
+    switch (plane) {
+    case DicomMpr::Plane::Axial:
+        return volume.voxels.get() + volume.sliceSize() * s + qint64(v) * volume.width;
+    case DicomMpr::Plane::Coronal:
+        sampleRow(bricks, true, s, z, geometry.width, scratch);
+        return scratch;
+    case DicomMpr::Plane::Sagittal:
+        sampleRow(bricks, false, s, z, geometry.width, scratch);
+        return scratch;
+    }
+    return scratch;
+}
+
+/**
+ * @brief acc = max(acc, row) ou min(acc, row), valor a valor.
+ * @details SSE2 só compara inteiros de 16 bits com sinal: os dois lados são deslocados de
+ * 32768 (xor do bit de sinal), comparados e deslocados de volta. 8 valores por iteração.
+ */
+static void extremeRow(quint16 *acc, const quint16 *row, int count, bool maximum) {
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i flip = _mm_set1_epi16(short(0x8000));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(acc + i)), flip);
+        const __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)), flip);
+        const __m128i m = maximum ? _mm_max_epi16(a, b) : _mm_min_epi16(a, b);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(acc + i), _mm_xor_si128(m, flip));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        acc[i] = maximum ? std::max(acc[i], row[i]) : std::min(acc[i], row[i]);
+    }
+}
+
+/**
+ * @brief sum += row, valor a valor (acumulador de 32 bits; até 65536 planos sem estouro).
+ * @details Com SSE2 expande 8 valores para 32 bits e soma em dois registradores por iteração.
+ */
+static void accumulateRow(quint32 *sum, const quint16 *row, int count) {
+    int i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        __m128i *lo = reinterpret_cast<__m128i *>(sum + i);
+        __m128i *hi = reinterpret_cast<__m128i *>(sum + i + 4);
+        _mm_storeu_si128(lo, _mm_add_epi32(_mm_loadu_si128(lo), _mm_unpacklo_epi16(v, zero)));
+        _mm_storeu_si128(hi, _mm_add_epi32(_mm_loadu_si128(hi), _mm_unpackhi_epi16(v, zero)));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        sum[i] += row[i];
+    }
+}
+
+/**
+ * @brief Projeção de um slab.
+ * @details Etapas:
+ * 1. Intervalo de planos: 'thickness' planos centrados em 'slice', deslocado para dentro do volume.
+ * 2. Cada faixa de linhas tem seus próprios buffers (linha amostrada e somas); para cada
+ *    linha da saída, as linhas dos planos do slab são reduzidas com extremeRow (MIP/MinIP,
+ *    direto na saída) ou accumulateRow (média, dividida no fim).
+ */
+DicomPixelData DicomMpr::slab(const DicomVolume &volume, const DicomBrickedVolume &bricks,
+                              Plane plane, int slice, int thickness, Projection projection) {
+    const int count = sliceCount(volume, plane);
+    if (volume.isNull() || slice < 0 || slice >= count || thickness < 1
+        || (plane != Plane::Axial && !matches(volume, bricks))) {
+        return DicomPixelData();
+    }
+
+    // [1] Planos do slab
+    thickness = std::min(thickness, count);
+    const int first = std::min(std::max(slice - (thickness - 1) / 2, 0), count - thickness);
+
+    const PlaneGeometry geometry = planeGeometry(volume, plane);
+    quint16 *buffer = nullptr;
+    const DicomPixelData data = planeData(volume, geometry, buffer);
+
+    // [2] Redução por linha, em paralelo
+    const qint64 values = qint64(geometry.width) * geometry.height * thickness;
+    DicomScheduler::instance().parallelForRows(geometry.height, values, kMinParallelPixels, [&](int firstRow, int lastRow) {
+        std::vector<quint16> scratch(size_t(geometry.width) + Brick::kBrickSize);
+        std::vector<quint32> sums(projection == Projection::Average ? size_t(geometry.width) : 0);
+
+        for (int v = firstRow; v < lastRow; ++v) {
+            quint16 *dst = buffer + qint64(v) * geometry.width;
+            if (projection == Projection::Average) {
+                std::fill(sums.begin(), sums.end(), 0u);
+            }
+
+            for (int k = 0; k < thickness; ++k) {
+                const quint16 *row = planeRow(volume, bricks, plane, geometry, first + k, v, scratch.data());
+                if (projection == Projection::Average) {
+                    accumulateRow(sums.data(), row, geometry.width);
+                } else if (k == 0) {
+                    std::memcpy(dst, row, size_t(geometry.width) * sizeof(quint16));
+                } else {
+                    extremeRow(dst, row, geometry.width, projection == Projection::Maximum);
+                }
+            }
+
+            if (projection == Projection::Average) {
+                const quint32 half = quint32(thickness) / 2;
+                for (int i = 0; i < geometry.width; ++i) {
+                    dst[i] = quint16((sums[size_t(i)] + half) / quint32(thickness));
+                }
+            }
+        }
+    });
+    return data;
+}
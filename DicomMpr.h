@@ -0,0 +1,132 @@
+/**
+ * @file DicomMpr.h
+ * @brief Definição da reconstrução multiplanar (MPR) e das projeções em slab de volumes.
+ * @details Planos axial, coronal e sagital reamostrados de uma cópia do volume organizada
+ * em blocos cúbicos (bricks): um plano coronal ou sagital percorre a pilha sem saltos de
+ * width * height valores entre leituras vizinhas.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMMPR_H
+#define DICOMMPR_H
+
+#include <QtGlobal>
+
+#include <memory>
+
+#include "DicomManager.h"
+
+/**
+ * @struct DicomBrickedVolume
+ * @brief Voxels de um DicomVolume reorganizados em blocos de kBrickSize³ valores.
+ * @details Cada bloco ocupa kBrickVoxels valores contíguos (8 KB, x mais rápido, depois y,
+ * depois z) e os blocos seguem a mesma ordem. As dimensões são arredondadas para múltiplos
+ * de kBrickSize; o excesso é zero e nunca é lido (as coordenadas são limitadas ao volume).
+ */
+struct DicomBrickedVolume {
+    static constexpr int kBrickShift = 4;                                     ///< log2 do lado do bloco
+    static constexpr int kBrickSize = 1 << kBrickShift;                       ///< Lado do bloco (voxels)
+    static constexpr int kBrickMask = kBrickSize - 1;                         ///< Posição dentro do bloco
+    static constexpr int kBrickVoxels = kBrickSize * kBrickSize * kBrickSize; ///< Valores por bloco
+
+    int width = 0;                          ///< Colunas do volume original
+    int height = 0;                         ///< Linhas do volume original
+    int depth = 0;                          ///< Planos do volume original
+    int bricksX = 0;                        ///< Blocos por linha
+    int bricksY = 0;                        ///< Linhas de blocos por camada
+    int bricksZ = 0;                        ///< Camadas de blocos
+    std::shared_ptr<const quint16> voxels;  ///< bricksX * bricksY * bricksZ blocos
+
+    /// Indica se não há voxels.
+    bool isNull() const { return !voxels || width <= 0 || height <= 0 || depth <= 0; }
+
+    /// Início do bloco (bx, by, bz).
+    const quint16 *brick(int bx, int by, int bz) const {
+        return voxels.get() + ((qint64(bz) * bricksY + by) * bricksX + bx) * kBrickVoxels;
+    }
+
+    /// Voxel (x, y, z), sem verificação de limites.
+    quint16 at(int x, int y, int z) const {
+        return brick(x >> kBrickShift, y >> kBrickShift, z >> kBrickShift)
+            [((z & kBrickMask) << (2 * kBrickShift)) | ((y & kBrickMask) << kBrickShift) | (x & kBrickMask)];
+    }
+};
+
+/**
+ * @class DicomMpr
+ * @brief Reformatação de planos ortogonais de um volume (classe utilitária estática).
+ *
+ * O volume empilhado é axial (planos ao longo da normal dos cortes). Os planos coronal e
+ * sagital são reamostrados com pixels quadrados: a direção dos planos é interpolada na
+ * distância entre pixels do corte (spacingX ou spacingY), com o último plano no topo.
+ * Cada linha da saída anda ao longo de um eixo do volume, com as outras duas coordenadas
+ * fixas: a amostragem trilinear combina quatro linhas de voxels, lidas bloco a bloco, com
+ * SSE2 (oito pixels por iteração); as linhas da saída são divididas entre as threads do
+ * DicomScheduler.
+ *
+ * slab() reduz vários planos consecutivos da mesma orientação (slab espesso) a um só:
+ * máximo (MIP), mínimo (MinIP) ou média. Cada linha da saída acumula as linhas
+ * correspondentes dos planos do slab com SSE2; as linhas são divididas entre as threads.
+ */
+class DicomMpr {
+public:
+    /**
+     * @enum Plane
+     * @brief Orientação do plano reformatado.
+     */
+    enum class Plane {
+        Axial = 0,  ///< Planos originais da pilha (x, y)
+        Coronal,    ///< Plano (x, z) para cada linha y
+        Sagittal    ///< Plano (y, z) para cada coluna x
+    };
+
+    /**
+     * @enum Projection
+     * @brief Redução aplicada aos planos de um slab.
+     */
+    enum class Projection {
+        Maximum = 0, ///< MIP: maior valor (vasos, contraste, calcificações)
+        Minimum,     ///< MinIP: menor valor (vias aéreas)
+        Average      ///< Média (slab espesso com menos ruído)
+    };
+
+    /**
+     * @brief Copia o volume para a organização em blocos, em paralelo (uma tarefa por linha de blocos).
+     * @param volume Volume contíguo (DicomManager::loadSeries).
+     * @return Volume em blocos (nulo se faltar memória).
+     */
+    static DicomBrickedVolume brick(const DicomVolume &volume);
+
+    /**
+     * @brief Quantidade de planos da orientação.
+     */
+    static int sliceCount(const DicomVolume &volume, Plane plane);
+
+    /**
+     * @brief Reformata um plano.
+     * @param volume Volume de origem (geometria, espaçamento, janela e faixa de valores).
+     * @param bricks Mesmo volume em blocos (DicomMpr::brick).
+     * @param plane Orientação.
+     * @param slice Plano (0 a sliceCount() - 1; posições fracionárias são interpoladas).
+     * @return Plano na mesma convenção do volume (valor = armazenado + valueOffset), pronto
+     * para o mesmo caminho de janelamento de um frame; nulo se os parâmetros forem inválidos.
+     */
+    static DicomPixelData reformat(const DicomVolume &volume, const DicomBrickedVolume &bricks,
+                                   Plane plane, double slice);
+
+    /**
+     * @brief Projeção de um slab espesso centrado em um plano.
+     * @param volume Volume de origem.
+     * @param bricks Mesmo volume em blocos (pode ser nulo para o plano axial, lido direto do volume).
+     * @param plane Orientação.
+     * @param slice Plano central (0 a sliceCount() - 1).
+     * @param thickness Quantidade de planos do slab (limitada ao volume; 1 = o próprio plano).
+     * @param projection Redução aplicada.
+     * @return Plano projetado na mesma convenção e janela do volume; nulo se os parâmetros forem inválidos.
+     */
+    static DicomPixelData slab(const DicomVolume &volume, const DicomBrickedVolume &bricks,
+                               Plane plane, int slice, int thickness, Projection projection);
+};
+
+#endif // DICOMMPR_H
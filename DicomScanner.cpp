@@ -0,0 +1,199 @@
+/**
+ * @file DicomScanner.cpp
+ * @brief Implementação do varredor paralelo de pastas DICOM.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomScanner.h"
+#include "DicomLog.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <atomic>
+#include <memory>
+
+/**
+ * @brief Construtor. Registra os tipos dos sinais enfileirados.
+ */
+DicomScanner::DicomScanner(QObject *parent)
+    : QObject(parent),
+      m_scanToken(m_lifetime.child()) {
+    qRegisterMetaType<DicomInstanceInfo>("DicomInstanceInfo");
+    qRegisterMetaType<QVector<DicomInstanceInfo>>("QVector<DicomInstanceInfo>");
+
+    connect(this, &DicomScanner::jobBatch, this, &DicomScanner::onJobBatch, Qt::QueuedConnection);
+    connect(this, &DicomScanner::jobFound, this, &DicomScanner::onJobFound, Qt::QueuedConnection);
+    connect(this, &DicomScanner::jobFinished, this, &DicomScanner::onJobFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destrutor. As tarefas referenciam 'this': cancela todas e aguarda as que estão em execução.
+ */
+DicomScanner::~DicomScanner() {
+    m_lifetime.cancel();
+    m_lifetime.waitForIdle();
+}
+
+/**
+ * @brief Inicia a varredura.
+ * @details Etapas:
+ * 1. Cancela a varredura anterior e zera os contadores.
+ * 2. Uma tarefa percorre a árvore. Arquivos presentes em 'known' com o mesmo tamanho e data
+ *    de modificação são reaproveitados diretamente (o QDirIterator já traz esses atributos);
+ *    os demais são agrupados em lotes de kBatchSize para leitura.
+ * 3. Cada lote é lido em outra tarefa (Background); a leitura começa enquanto a árvore
+ *    ainda está sendo percorrida, e cada lote concluído é publicado imediatamente.
+ * 4. Um contador de tarefas pendentes (a do percurso conta como uma) detecta o fim:
+ *    quem o leva a zero emite jobFinished. Tarefas canceladas antes de começar não
+ *    executam, mas nesse caso a varredura já foi substituída e o fim não interessa.
+ * @param directory Pasta raiz.
+ * @param known Resultados anteriores por caminho (compartilhados, sem cópia).
+ */
+void DicomScanner::scan(const QString &directory, const QHash<QString, DicomInstanceInfo> &known) {
+    cancel();
+
+    const quint64 scanId = ++m_scanId;
+    const DicomScheduler::CancellationToken token = m_lifetime.child();
+    m_scanToken = token;
+    m_scanning = true;
+    m_scanned = 0;
+    m_found = 0;
+    m_valid = 0;
+
+    auto pending = std::make_shared<std::atomic_int>(1); // Tarefa do percurso
+
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Background, [this, directory, known, scanId, token, pending]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        // Libera uma tarefa pendente; a última sinaliza o fim da varredura
+        auto release = [this, scanId, pending]() {
+            if (pending->fetch_sub(1) == 1) {
+                emit jobFinished(scanId);
+            }
+        };
+
+        // [3] Leitura de um lote de Headers em outra tarefa
+        auto submit = [this, scanId, token, pending, release](const QVector<QFileInfo> &files) {
+            pending->fetch_add(1);
+            DicomScheduler::instance().submit(DicomScheduler::Priority::Background, [this, scanId, token, files, release]() {
+                QVector<DicomInstanceInfo> instances;
+                instances.reserve(files.size());
+                for (const QFileInfo &file : files) {
+                    if (token.isCanceled()) {
+                        break;
+                    }
+                    DicomInstanceInfo info = DicomManager::extractInstanceInfo(file.filePath());
+                    info.fileSize = file.size();
+                    info.modified = file.lastModified().toMSecsSinceEpoch();
+                    instances.append(info);
+                }
+                emit jobBatch(scanId, instances, files.size());
+                release();
+            }, token);
+        };
+
+        // [2] Percurso da árvore
+        QVector<QFileInfo> batch;
+        QVector<DicomInstanceInfo> reused;
+        int found = 0, unchanged = 0;
+        QDirIterator it(directory, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (it.hasNext() && !token.isCanceled()) {
+            const QString path = it.next();
+            const QFileInfo file = it.fileInfo();
+            ++found;
+
+            auto knownIt = known.constFind(path);
+            if (knownIt != known.constEnd() &&
+                knownIt->fileSize == file.size() &&
+                knownIt->modified == file.lastModified().toMSecsSinceEpoch()) {
+                reused.append(knownIt.value());
+                ++unchanged;
+                if (reused.size() == kBatchSize) {
+                    emit jobBatch(scanId, reused, reused.size());
+                    reused.clear();
+                    emit jobFound(scanId, found);
+                }
+                continue;
+            }
+
+            batch.append(file);
+            if (batch.size() == kBatchSize) {
+                submit(batch);
+                batch.clear();
+                emit jobFound(scanId, found);
+            }
+        }
+        if (!token.isCanceled()) {
+            if (!batch.isEmpty()) {
+                submit(batch);
+            }
+            if (!reused.isEmpty()) {
+                emit jobBatch(scanId, reused, reused.size());
+            }
+        }
+        emit jobFound(scanId, found);
+
+        qCDebug(dicomPerf) << "DicomScanner: percurso de" << directory << "-" << found << "arquivos ("
+                 << unchanged << "inalterados) em" << timer.elapsed() << "ms";
+        release();
+    }, token);
+}
+
+/**
+ * @brief Cancela a varredura ativa. Lotes em andamento terminam no próximo arquivo.
+ */
+void DicomScanner::cancel() {
+    if (!m_scanning) {
+        return;
+    }
+    m_scanToken.cancel();
+    m_scanning = false;
+    ++m_scanId;
+}
+
+/**
+ * @brief Publica um lote concluído (apenas da varredura ativa).
+ */
+void DicomScanner::onJobBatch(quint64 scanId, const QVector<DicomInstanceInfo> &instances, int scanned) {
+    if (scanId != m_scanId) {
+        return;
+    }
+    m_scanned += scanned;
+    for (const DicomInstanceInfo &info : instances) {
+        m_valid += info.isValid ? 1 : 0;
+    }
+    if (!instances.isEmpty()) {
+        emit batchReady(instances);
+    }
+    emit progressChanged(m_scanned, m_found);
+}
+
+/**
+ * @brief Atualiza o total de arquivos encontrados pelo percurso.
+ */
+void DicomScanner::onJobFound(quint64 scanId, int found) {
+    if (scanId != m_scanId) {
+        return;
+    }
+    m_found = found;
+    emit progressChanged(m_scanned, m_found);
+}
+
+/**
+ * @brief Encerra a varredura ativa.
+ */
+void DicomScanner::onJobFinished(quint64 scanId) {
+    if (scanId != m_scanId) {
+        return;
+    }
+    m_scanning = false;
+    qCDebug(dicomPerf) << "DicomScanner: concluído -" << m_scanned << "arquivos," << m_valid << "instâncias";
+    emit finished(m_scanned, m_valid);
+}
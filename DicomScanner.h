@@ -0,0 +1,100 @@
+/**
+ * @file DicomScanner.h
+ * @brief Definição do varredor paralelo de pastas DICOM ("Abrir Pasta").
+ * @details Percorre uma árvore de diretórios e lê apenas o Header de cada arquivo no
+ * DicomScheduler, entregando os resultados em lotes para que o navegador seja preenchido
+ * enquanto a varredura ainda está em andamento.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMSCANNER_H
+#define DICOMSCANNER_H
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "DicomManager.h"
+#include "DicomScheduler.h"
+
+/**
+ * @class DicomScanner
+ * @brief Varre pastas em paralelo e publica as instâncias encontradas em lotes.
+ *
+ * Uma tarefa percorre a árvore (QDirIterator) e, a cada kBatchSize arquivos, enfileira um
+ * lote para leitura de Headers (DicomManager::extractInstanceInfo) em outras tarefas.
+ * Todas rodam com prioridade Background, atrás da imagem exibida e da pré-carga. Cada lote concluído chega à thread da interface pelo sinal batchReady; o sinal
+ * finished é emitido quando a árvore foi percorrida e todos os lotes terminaram.
+ * Como em DicomLoader, iniciar uma nova varredura cancela a anterior.
+ *
+ * Para reindexação incremental, scan() recebe as instâncias já conhecidas (por caminho):
+ * arquivos com o mesmo tamanho e data de modificação são reaproveitados sem abrir o arquivo.
+ */
+class DicomScanner : public QObject {
+    Q_OBJECT
+
+public:
+    static const int kBatchSize = 256; ///< Arquivos por lote de leitura de Headers
+
+    /**
+     * @brief Construtor.
+     * @param parent Objeto pai (gerenciamento de memória do Qt).
+     */
+    explicit DicomScanner(QObject *parent = nullptr);
+
+    /**
+     * @brief Destrutor. Cancela a varredura ativa e aguarda as tarefas em execução.
+     */
+    ~DicomScanner() override;
+
+    /**
+     * @brief Inicia a varredura recursiva de uma pasta (cancela a anterior).
+     * @param directory Pasta raiz.
+     * @param known Resultados de uma varredura anterior (caminho -> instância); arquivos
+     * inalterados (tamanho e data) não são lidos novamente.
+     */
+    void scan(const QString &directory, const QHash<QString, DicomInstanceInfo> &known = {});
+
+    /**
+     * @brief Cancela a varredura ativa (lotes já lidos continuam válidos).
+     */
+    void cancel();
+
+    /**
+     * @brief Indica se há uma varredura em andamento.
+     */
+    bool isScanning() const { return m_scanning; }
+
+signals:
+    /// Lote de arquivos da varredura ativa (inclui arquivos não-DICOM, com isValid = false).
+    void batchReady(const QVector<DicomInstanceInfo> &instances);
+
+    /// Progresso: arquivos lidos / arquivos encontrados até agora.
+    void progressChanged(int scanned, int found);
+
+    /// Varredura concluída (não emitido em caso de cancelamento).
+    void finished(int scanned, int valid);
+
+    // --- Sinais internos (threads de trabalho -> thread da interface) ---
+    void jobBatch(quint64 scanId, const QVector<DicomInstanceInfo> &instances, int scanned);
+    void jobFound(quint64 scanId, int found);
+    void jobFinished(quint64 scanId);
+
+private slots:
+    void onJobBatch(quint64 scanId, const QVector<DicomInstanceInfo> &instances, int scanned);
+    void onJobFound(quint64 scanId, int found);
+    void onJobFinished(quint64 scanId);
+
+private:
+    DicomScheduler::CancellationToken m_lifetime;    ///< Pai de todos os tokens (cancelado no destrutor)
+    DicomScheduler::CancellationToken m_scanToken;   ///< Token da varredura ativa
+    quint64 m_scanId = 0;                            ///< Identificador da varredura ativa
+    bool m_scanning = false;                         ///< Há uma varredura em andamento
+    int m_scanned = 0;                               ///< Arquivos lidos na varredura ativa
+    int m_found = 0;                                 ///< Arquivos encontrados na varredura ativa
+    int m_valid = 0;                                 ///< Instâncias válidas na varredura ativa
+};
+
+#endif // DICOMSCANNER_H
@@ -0,0 +1,333 @@
+/**
+ * @file DicomScheduler.cpp
+ * @brief Implementação do escalonador único de tarefas.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomScheduler.h"
+
+#include <QThread>
+
+#include <algorithm>
+
+/// Thread do pool em execução (-1 fora do pool).
+static thread_local int tl_worker = -1;
+
+/// Prioridade da tarefa em execução nesta thread (herdada por parallelFor).
+static thread_local DicomScheduler::Priority tl_priority = DicomScheduler::Priority::Visible;
+
+/// Classes limitadas a workerCount() - 1 threads simultâneas (todas menos Visible).
+static bool isLowPriority(DicomScheduler::Priority priority) {
+    return priority >= DicomScheduler::Priority::Interactive;
+}
+
+// =========================================================
+// CancellationToken
+// =========================================================
+
+/**
+ * @brief Estado compartilhado de um token.
+ * @details 'active' conta as tarefas em execução deste token e de todos os seus filhos.
+ */
+struct DicomScheduler::CancellationToken::State {
+    std::atomic_bool canceled{false};
+    std::atomic_int active{0};
+    std::shared_ptr<State> parent;
+    std::mutex mutex;
+    std::condition_variable idle;
+};
+
+DicomScheduler::CancellationToken::CancellationToken()
+    : m_state(std::make_shared<State>()) {
+}
+
+void DicomScheduler::CancellationToken::cancel() const {
+    m_state->canceled.store(true);
+}
+
+bool DicomScheduler::CancellationToken::isCanceled() const {
+    for (const State *state = m_state.get(); state != nullptr; state = state->parent.get()) {
+        if (state->canceled.load()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+DicomScheduler::CancellationToken DicomScheduler::CancellationToken::child() const {
+    CancellationToken token;
+    token.m_state->parent = m_state;
+    return token;
+}
+
+/**
+ * @brief Registra uma tarefa em execução neste token e em todos os ancestrais.
+ */
+void DicomScheduler::CancellationToken::enter() const {
+    for (State *state = m_state.get(); state != nullptr; state = state->parent.get()) {
+        state->active.fetch_add(1);
+    }
+}
+
+/**
+ * @brief Desfaz enter(); acorda quem espera em waitForIdle() quando a contagem zera.
+ */
+void DicomScheduler::CancellationToken::leave() const {
+    for (State *state = m_state.get(); state != nullptr; state = state->parent.get()) {
+        if (state->active.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->idle.notify_all();
+        }
+    }
+}
+
+void DicomScheduler::CancellationToken::waitForIdle() const {
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->idle.wait(lock, [this]() { return m_state->active.load() == 0; });
+}
+
+// =========================================================
+// DicomScheduler
+// =========================================================
+
+DicomScheduler &DicomScheduler::instance() {
+    static DicomScheduler scheduler;
+    return scheduler;
+}
+
+/**
+ * @brief Construtor. Cria uma thread por núcleo (no mínimo duas).
+ * @details Com duas ou mais threads, uma delas fica sempre disponível para Visible
+ * (m_lowLimit = threads - 1).
+ */
+DicomScheduler::DicomScheduler() {
+    for (std::atomic_int &pending : m_pending) {
+        pending.store(0);
+    }
+
+    const int count = std::max(2, QThread::idealThreadCount());
+    m_lowLimit = count - 1;
+
+    m_workers.reserve(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        m_workers.emplace_back(new Worker);
+    }
+    for (int i = 0; i < count; ++i) {
+        m_workers[size_t(i)]->thread = std::thread(&DicomScheduler::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Destrutor. Tarefas ainda na fila são descartadas; as em execução terminam normalmente.
+ */
+DicomScheduler::~DicomScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief Enfileira uma tarefa.
+ * @details De dentro do pool, a tarefa vai para a fila da própria thread; de fora, as filas
+ * são escolhidas em rodízio. O contador da classe é incrementado sob m_sleepMutex, o mesmo
+ * que as threads ociosas usam para dormir, então nenhum envio passa despercebido.
+ */
+void DicomScheduler::submit(Priority priority, std::function<void()> job, const CancellationToken &token) {
+    const int queue = (tl_worker >= 0) ? tl_worker : int(m_nextQueue.fetch_add(1) % m_workers.size());
+
+    Worker &worker = *m_workers[size_t(queue)];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[int(priority)].push_back(Job{std::move(job), priority, token});
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_pending[int(priority)].fetch_add(1);
+    }
+    m_wake.notify_one();
+}
+
+/**
+ * @brief Divide os itens entre a thread chamadora e tarefas auxiliares.
+ * @details Os itens são distribuídos por um contador atômico: quem estiver livre pega o
+ * próximo. O estado fica em um shared_ptr porque tarefas auxiliares que só começarem depois
+ * do fim (todos os itens já feitos) ainda o acessam, encontrando o contador esgotado.
+ */
+void DicomScheduler::parallelFor(int count, const std::function<void(int)> &work) {
+    if (count <= 0) {
+        return;
+    }
+    if (count == 1) {
+        work(0);
+        return;
+    }
+
+    struct Shared {
+        std::function<void(int)> work;
+        int count = 0;
+        std::atomic_int next{0};
+        std::atomic_int done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto shared = std::make_shared<Shared>();
+    shared->work = work;
+    shared->count = count;
+
+    auto drain = [shared]() {
+        for (int i = shared->next.fetch_add(1); i < shared->count; i = shared->next.fetch_add(1)) {
+            shared->work(i);
+            if (shared->done.fetch_add(1) + 1 == shared->count) {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->finished.notify_all();
+            }
+        }
+    };
+
+    const int helpers = std::min(count - 1, workerCount());
+    for (int i = 0; i < helpers; ++i) {
+        submit(tl_priority, drain);
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished.wait(lock, [&shared]() { return shared->done.load() == shared->count; });
+}
+
+/**
+ * @brief Faixas de linhas de tamanho igual (a última pode ser menor) distribuídas por parallelFor.
+ */
+void DicomScheduler::parallelForRows(int rows, qint64 elements, qint64 minParallel,
+                                     const std::function<void(int, int)> &work) {
+    const int bands = (elements < minParallel) ? 1 : std::min(workerCount(), rows);
+    if (bands <= 1) {
+        work(0, rows);
+        return;
+    }
+
+    const int rowsPerBand = (rows + bands - 1) / bands;
+    parallelFor(bands, [&](int band) {
+        const int first = band * rowsPerBand;
+        const int last = std::min(rows, first + rowsPerBand);
+        if (first < last) {
+            work(first, last);
+        }
+    });
+}
+
+/**
+ * @brief Há tarefa Visible na fila, ou de outra classe com vaga disponível.
+ */
+bool DicomScheduler::hasRunnableWork() const {
+    if (m_pending[int(Priority::Visible)].load() > 0) {
+        return true;
+    }
+    return m_runningLow.load() < m_lowLimit &&
+           (m_pending[int(Priority::Interactive)].load() > 0 || m_pending[int(Priority::Prefetch)].load() > 0 ||
+            m_pending[int(Priority::Background)].load() > 0);
+}
+
+/**
+ * @brief Procura a tarefa de maior prioridade disponível.
+ * @details Para cada classe (da mais alta para a mais baixa): fim da própria fila e, em
+ * seguida, início das filas das outras threads. Para as classes baixas, uma vaga em
+ * m_runningLow é reservada antes da busca e devolvida se nada for encontrado.
+ */
+bool DicomScheduler::takeJob(int self, Job &job) {
+    const int count = workerCount();
+
+    for (int p = 0; p < kPriorityCount; ++p) {
+        if (m_pending[p].load() <= 0) {
+            continue;
+        }
+
+        const bool low = isLowPriority(Priority(p));
+        if (low && m_runningLow.fetch_add(1) >= m_lowLimit) {
+            m_runningLow.fetch_sub(1);
+            return false; // Classes baixas esgotaram as vagas
+        }
+
+        bool found = false;
+        {
+            Worker &own = *m_workers[size_t(self)];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            std::deque<Job> &queue = own.queues[p];
+            if (!queue.empty()) {
+                job = std::move(queue.back());
+                queue.pop_back();
+                found = true;
+            }
+        }
+        for (int i = 1; i < count && !found; ++i) {
+            Worker &victim = *m_workers[size_t((self + i) % count)];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            std::deque<Job> &queue = victim.queues[p];
+            if (!queue.empty()) {
+                job = std::move(queue.front());
+                queue.pop_front();
+                found = true;
+            }
+        }
+
+        if (found) {
+            m_pending[p].fetch_sub(1);
+            return true;
+        }
+        if (low) {
+            m_runningLow.fetch_sub(1);
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Executa uma tarefa, a menos que o token já esteja cancelado.
+ * @details enter() vem antes da verificação de cancelamento: quem chama cancel() e depois
+ * waitForIdle() ou vê a tarefa registrada (e espera) ou a tarefa vê o cancelamento.
+ */
+void DicomScheduler::runJob(Job &job) {
+    const Priority previous = tl_priority;
+    tl_priority = job.priority;
+
+    job.token.enter();
+    if (!job.token.isCanceled()) {
+        job.run();
+    }
+    job.run = nullptr; // Libera as capturas antes de avisar que a tarefa terminou
+    job.token.leave();
+
+    tl_priority = previous;
+
+    if (isLowPriority(job.priority)) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_runningLow.fetch_sub(1);
+        m_wake.notify_one(); // Uma vaga das classes baixas foi liberada
+    }
+}
+
+/**
+ * @brief Laço de uma thread: executa enquanto houver trabalho e dorme quando não houver.
+ */
+void DicomScheduler::workerLoop(int index) {
+    tl_worker = index;
+
+    for (;;) {
+        Job job;
+        if (takeJob(index, job)) {
+            runJob(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this]() { return m_stop || hasRunnableWork(); });
+        if (m_stop) {
+            return;
+        }
+    }
+}
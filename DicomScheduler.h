@@ -0,0 +1,184 @@
+/**
+ * @file DicomScheduler.h
+ * @brief Definição do escalonador único de tarefas (decodificação, renderização e varreduras).
+ * @details Todas as tarefas em segundo plano da aplicação (imagem aberta, pré-carga,
+ * miniaturas e varredura de pastas) disputam os mesmos núcleos; este escalonador as
+ * executa em um único conjunto de threads, por ordem de prioridade, com cancelamento.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMSCHEDULER_H
+#define DICOMSCHEDULER_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class DicomScheduler
+ * @brief Pool de threads com classes de prioridade, filas por núcleo e roubo de tarefas.
+ *
+ * Único para todo o processo (instance()). Cada thread tem uma fila por classe de
+ * prioridade; tarefas enviadas por uma thread do pool entram na fila dela (e são
+ * retiradas pelo fim, aproveitando o cache do núcleo), as demais são distribuídas em
+ * rodízio. Uma thread sem trabalho na própria fila rouba pelo início da fila das outras.
+ * A busca percorre as classes da mais alta para a mais baixa em todas as filas, então uma
+ * tarefa Visible nunca espera atrás de uma Background já enfileirada.
+ *
+ * Como uma tarefa em execução não é interrompida, as classes Interactive, Prefetch e
+ * Background ocupam juntas no máximo workerCount() - 1 threads ao mesmo tempo: sempre há
+ * uma thread livre para a imagem exibida, mesmo durante uma varredura longa ou com uma
+ * galeria de miniaturas decodificando frames inteiros.
+ *
+ * Tarefas recebem um CancellationToken: se o token for cancelado antes do início, a tarefa
+ * é descartada sem executar; durante a execução, a própria tarefa consulta isCanceled().
+ */
+class DicomScheduler {
+public:
+    /**
+     * @enum Priority
+     * @brief Classes de prioridade (da mais alta para a mais baixa).
+     */
+    enum class Priority {
+        Visible = 0,   ///< Imagem que o usuário pediu para ver
+        Interactive,   ///< Conteúdo na tela aguardando o usuário (ex.: miniaturas visíveis)
+        Prefetch,      ///< Pré-carga especulativa (vizinhos da imagem exibida)
+        Background     ///< Manutenção (varredura e indexação de pastas)
+    };
+
+    static const int kPriorityCount = 4; ///< Quantidade de classes de prioridade
+
+    /**
+     * @class CancellationToken
+     * @brief Sinal de cancelamento compartilhado entre quem envia e as tarefas enviadas.
+     *
+     * Cópias referem-se ao mesmo estado. Um token filho (child()) é considerado cancelado
+     * quando ele ou qualquer ancestral é cancelado; assim um objeto pode cancelar uma
+     * requisição isolada (filho) ou todas de uma vez (pai), por exemplo no destrutor.
+     */
+    class CancellationToken {
+    public:
+        /// Cria um token novo (não cancelado, sem pai).
+        CancellationToken();
+
+        /// Cancela o token (e, por consequência, seus filhos).
+        void cancel() const;
+
+        /// Indica se o token ou algum ancestral foi cancelado.
+        bool isCanceled() const;
+
+        /// Cria um token filho, cancelado junto com este.
+        CancellationToken child() const;
+
+        /**
+         * @brief Aguarda o término das tarefas em execução com este token ou com seus filhos.
+         * @details Usado nos destrutores após cancel(): tarefas ainda na fila são descartadas
+         * sem executar, então nenhuma tarefa referencia o objeto depois do retorno.
+         * Não deve ser chamado de dentro de uma tarefa com o mesmo token.
+         */
+        void waitForIdle() const;
+
+    private:
+        friend class DicomScheduler;
+        struct State;
+
+        void enter() const;  ///< Tarefa com este token começou a executar
+        void leave() const;  ///< Tarefa com este token terminou
+
+        std::shared_ptr<State> m_state;
+    };
+
+    /**
+     * @brief Retorna a instância única do processo.
+     */
+    static DicomScheduler &instance();
+
+    /**
+     * @brief Destrutor. Descarta as tarefas pendentes e aguarda as threads.
+     */
+    ~DicomScheduler();
+
+    /**
+     * @brief Enfileira uma tarefa.
+     * @param priority Classe de prioridade.
+     * @param job Tarefa a executar em uma das threads do pool.
+     * @param token Token de cancelamento (tarefas canceladas antes do início não executam).
+     */
+    void submit(Priority priority, std::function<void()> job,
+                const CancellationToken &token = CancellationToken());
+
+    /**
+     * @brief Executa work(0) ... work(count - 1) em paralelo e retorna quando todos terminarem.
+     * @details A thread chamadora também executa itens, então a chamada é segura de dentro
+     * de uma tarefa do pool (sem risco de todas as threads esperarem umas pelas outras).
+     * Os itens auxiliares herdam a prioridade da tarefa chamadora (Visible fora do pool).
+     * @param count Quantidade de itens.
+     * @param work Função chamada com o índice do item.
+     */
+    void parallelFor(int count, const std::function<void(int)> &work);
+
+    /**
+     * @brief Divide as linhas [0, rows) em faixas, uma por thread, e executa 'work' em cada
+     * uma com parallelFor.
+     * @details Abaixo de minParallel elementos, uma única faixa roda direto na thread
+     * chamadora (o custo de distribuir não compensa).
+     * @param rows Quantidade de linhas.
+     * @param elements Elementos processados no total (pixels ou valores lidos).
+     * @param minParallel Mínimo de elementos para dividir entre as threads.
+     * @param work Função chamada com o intervalo [primeira linha, última linha).
+     */
+    void parallelForRows(int rows, qint64 elements, qint64 minParallel, const std::function<void(int, int)> &work);
+
+    /// Quantidade de threads do pool.
+    int workerCount() const { return int(m_workers.size()); }
+
+private:
+    /// Tarefa enfileirada.
+    struct Job {
+        std::function<void()> run;
+        Priority priority = Priority::Background;
+        CancellationToken token;
+    };
+
+    /// Thread do pool e suas filas (uma por classe de prioridade).
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> queues[kPriorityCount];
+        std::thread thread;
+    };
+
+    DicomScheduler();
+    DicomScheduler(const DicomScheduler &) = delete;
+    DicomScheduler &operator=(const DicomScheduler &) = delete;
+
+    /// Laço de uma thread do pool.
+    void workerLoop(int index);
+
+    /// Retira a próxima tarefa (própria fila primeiro, depois roubo), por prioridade.
+    bool takeJob(int self, Job &job);
+
+    /// Executa uma tarefa retirada da fila.
+    void runJob(Job &job);
+
+    /// Existe tarefa que alguma thread ociosa poderia executar agora.
+    bool hasRunnableWork() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;      ///< Threads e filas
+    std::mutex m_sleepMutex;                             ///< Protege o sono das threads ociosas
+    std::condition_variable m_wake;                      ///< Acorda threads ao enfileirar
+    std::atomic_int m_pending[kPriorityCount];           ///< Tarefas na fila por classe
+    std::atomic_int m_runningLow{0};                     ///< Tarefas não Visible em execução
+    int m_lowLimit = 1;                                  ///< Máximo de tarefas não Visible simultâneas
+    std::atomic_uint m_nextQueue{0};                     ///< Rodízio para envios de fora do pool
+    bool m_stop = false;                                 ///< Encerramento (protegido por m_sleepMutex)
+};
+
+#endif // DICOMSCHEDULER_H
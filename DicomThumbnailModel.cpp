@@ -0,0 +1,179 @@
+/**
+ * @file DicomThumbnailModel.cpp
+ * @brief Implementação do modelo da galeria de miniaturas.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomThumbnailModel.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+/**
+ * @brief Construtor. Configura o cache em memória e o marcador das células.
+ */
+DicomThumbnailModel::DicomThumbnailModel(QObject *parent)
+    : QAbstractListModel(parent),
+      m_pixmaps(kMemoryBudget),
+      m_requestToken(m_lifetime.child()),
+      m_visibleFirst(std::make_shared<std::atomic_int>(0)),
+      m_visibleLast(std::make_shared<std::atomic_int>(-1)) {
+    m_placeholder = QPixmap(kThumbnailSize, kThumbnailSize);
+    m_placeholder.fill(QColor("#2c3e50"));
+
+    connect(this, &DicomThumbnailModel::jobFinished, this, &DicomThumbnailModel::onJobFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destrutor. As tarefas referenciam 'this': descarta as pendentes e aguarda as ativas.
+ */
+DicomThumbnailModel::~DicomThumbnailModel() {
+    m_lifetime.cancel();
+    m_lifetime.waitForIdle();
+}
+
+/**
+ * @brief Troca a lista exibida. O cache em memória é mantido (chave = caminho do arquivo).
+ */
+void DicomThumbnailModel::setInstances(const QVector<DicomInstanceInfo> &instances) {
+    beginResetModel();
+    m_requestToken.cancel();
+    m_requestToken = m_lifetime.child();
+    ++m_generation;
+    m_requested.clear();
+    m_instances = instances;
+    m_visibleFirst->store(0);
+    m_visibleLast->store(-1);
+    endResetModel();
+}
+
+/**
+ * @brief Atualiza a faixa visível consultada pelas threads antes de decodificar.
+ */
+void DicomThumbnailModel::setVisibleRange(int first, int last) {
+    m_visibleFirst->store(first);
+    m_visibleLast->store(last);
+}
+
+int DicomThumbnailModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_instances.size();
+}
+
+/**
+ * @brief Dados de uma célula. A miniatura é pedida na primeira vez em que a célula é desenhada.
+ */
+QVariant DicomThumbnailModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_instances.size()) {
+        return QVariant();
+    }
+    const DicomInstanceInfo &info = m_instances.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("%1 - %2").arg(info.modality).arg(info.instanceNumber);
+    case Qt::ToolTipRole:
+        return QString("%1\n%2").arg(info.patientName, info.path);
+    case PathRole:
+        return info.path;
+    case Qt::DecorationRole:
+        if (const QPixmap *pixmap = m_pixmaps.object(info.path)) {
+            return *pixmap;
+        }
+        request(index.row());
+        return m_placeholder;
+    default:
+        return QVariant();
+    }
+}
+
+/**
+ * @brief Nome do arquivo no cache persistente de miniaturas.
+ * @details Tamanho e data de modificação entram na chave: se o .dcm mudar, a miniatura
+ * antiga simplesmente deixa de ser encontrada.
+ */
+QString DicomThumbnailModel::diskCacheFile(const DicomInstanceInfo &info) {
+    const QString key = QString("%1|%2|%3|%4").arg(info.path).arg(info.fileSize).arg(info.modified).arg(kThumbnailSize);
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    const QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return QDir(base).filePath("thumbnails/" + QString::fromLatin1(hash.toHex()) + ".png");
+}
+
+/**
+ * @brief Enfileira a miniatura de uma linha (prioridade Interactive: abaixo da imagem aberta,
+ * acima da pré-carga e da varredura de pastas).
+ * @details A tarefa:
+ * 1. Desiste se a linha saiu da faixa visível (mais kVisibleMargin) desde o pedido.
+ * 2. Tenta o cache em disco (PNG).
+ * 3. Senão, gera com DicomManager::loadThumbnail (ícone embutido ou primeiro frame reduzido)
+ *    e grava no cache em disco.
+ */
+void DicomThumbnailModel::request(int row) const {
+    if (m_requested.contains(row)) {
+        return;
+    }
+    m_requested.insert(row);
+
+    const DicomInstanceInfo info = m_instances.at(row);
+    const quint64 generation = m_generation;
+    auto visibleFirst = m_visibleFirst;
+    auto visibleLast = m_visibleLast;
+    DicomThumbnailModel *self = const_cast<DicomThumbnailModel *>(this);
+
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Interactive,
+                                      [self, info, row, generation, visibleFirst, visibleLast]() {
+        // [1] Linha fora da tela: descarta sem decodificar (será pedida de novo se voltar)
+        const int last = visibleLast->load();
+        if (last >= 0 && (row < visibleFirst->load() - kVisibleMargin || row > last + kVisibleMargin)) {
+            emit self->jobFinished(generation, row, QImage(), true);
+            return;
+        }
+
+        // [2] Cache persistente
+        const QString file = diskCacheFile(info);
+        QImage thumbnail;
+        if (QFile::exists(file)) {
+            thumbnail.load(file);
+        }
+
+        // [3] Geração
+        if (thumbnail.isNull()) {
+            thumbnail = DicomManager::loadThumbnail(info.path, kThumbnailSize);
+            if (!thumbnail.isNull()) {
+                QDir().mkpath(QFileInfo(file).absolutePath());
+                QSaveFile output(file);
+                if (output.open(QIODevice::WriteOnly) && thumbnail.save(&output, "PNG")) {
+                    output.commit();
+                }
+            }
+        }
+
+        emit self->jobFinished(generation, row, thumbnail, false);
+    }, m_requestToken);
+}
+
+/**
+ * @brief Recebe uma miniatura pronta e atualiza apenas a célula correspondente.
+ * @details Falhas de leitura guardam o marcador no cache, para não repetir o pedido a cada
+ * repintura. Pedidos descartados liberam a linha para um novo pedido.
+ */
+void DicomThumbnailModel::onJobFinished(quint64 generation, int row, const QImage &thumbnail, bool skipped) {
+    if (generation != m_generation) {
+        return; // Lista substituída
+    }
+    m_requested.remove(row);
+    if (skipped || row >= m_instances.size()) {
+        return;
+    }
+
+    QPixmap *pixmap = new QPixmap(thumbnail.isNull() ? m_placeholder : QPixmap::fromImage(thumbnail));
+    const int cost = qMax(1, pixmap->width() * pixmap->height() * pixmap->depth() / 8);
+    m_pixmaps.insert(m_instances.at(row).path, pixmap, cost);
+
+    const QModelIndex cell = index(row);
+    emit dataChanged(cell, cell, {Qt::DecorationRole});
+}
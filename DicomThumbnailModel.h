@@ -0,0 +1,101 @@
+/**
+ * @file DicomThumbnailModel.h
+ * @brief Definição do modelo da galeria de miniaturas (QListView virtualizada).
+ * @details As miniaturas são geradas sob demanda, apenas para as células visíveis, no
+ * DicomScheduler (prioridade Interactive), e guardadas em um cache em memória (limitado em bytes) e em
+ * um cache persistente em disco.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMTHUMBNAILMODEL_H
+#define DICOMTHUMBNAILMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+#include "DicomManager.h"
+#include "DicomScheduler.h"
+
+/**
+ * @class DicomThumbnailModel
+ * @brief Lista de instâncias cujo DecorationRole é a miniatura, gerada em segundo plano.
+ *
+ * O QListView só consulta data() para as células que desenha; é ali que a miniatura é
+ * pedida (uma única vez por linha). Enquanto não fica pronta, a célula mostra um
+ * marcador. Ao rolar, setVisibleRange() informa a faixa visível e pedidos que saíram dela
+ * são descartados antes de decodificar, então a fila nunca acumula trabalho fora da tela.
+ *
+ * Memória: apenas as miniaturas (QPixmap) mais recentes ficam em um QCache limitado a
+ * kMemoryBudget bytes; as demais são relidas do cache em disco (PNG, poucos KB) quando
+ * voltarem a ficar visíveis.
+ */
+class DicomThumbnailModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    static const int kThumbnailSize = 128;                 ///< Lado máximo da miniatura
+    static const int kMemoryBudget = 32 * 1024 * 1024;    ///< Limite do cache em memória (bytes)
+    static const int kVisibleMargin = 24;                  ///< Linhas além das visíveis ainda aceitas
+
+    /// Papel com o caminho do arquivo (para abrir a imagem).
+    static const int PathRole = Qt::UserRole;
+
+    /**
+     * @brief Construtor.
+     * @param parent Objeto pai.
+     */
+    explicit DicomThumbnailModel(QObject *parent = nullptr);
+
+    /**
+     * @brief Destrutor. Descarta os pedidos pendentes e aguarda os que estão em execução.
+     */
+    ~DicomThumbnailModel() override;
+
+    /**
+     * @brief Substitui a lista exibida (pedidos pendentes da lista anterior são descartados).
+     * @param instances Instâncias na ordem de exibição.
+     */
+    void setInstances(const QVector<DicomInstanceInfo> &instances);
+
+    /**
+     * @brief Informa a faixa de linhas visível na view (inclusive).
+     */
+    void setVisibleRange(int first, int last);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+
+signals:
+    // --- Sinal interno (threads de trabalho -> thread da interface) ---
+    void jobFinished(quint64 generation, int row, const QImage &thumbnail, bool skipped);
+
+private slots:
+    void onJobFinished(quint64 generation, int row, const QImage &thumbnail, bool skipped);
+
+private:
+    /// Enfileira a geração da miniatura de uma linha (se ainda não foi pedida).
+    void request(int row) const;
+
+    /// Arquivo da miniatura em disco (hash de caminho + tamanho + data de modificação).
+    static QString diskCacheFile(const DicomInstanceInfo &info);
+
+    QVector<DicomInstanceInfo> m_instances;            ///< Linhas do modelo
+    quint64 m_generation = 0;                          ///< Incrementado a cada setInstances
+    mutable QCache<QString, QPixmap> m_pixmaps;        ///< Miniaturas prontas (LRU, custo = bytes)
+    mutable QSet<int> m_requested;                     ///< Linhas com pedido em andamento
+    DicomScheduler::CancellationToken m_lifetime;      ///< Pai dos tokens (cancelado no destrutor)
+    DicomScheduler::CancellationToken m_requestToken;  ///< Pedidos da lista atual
+    std::shared_ptr<std::atomic_int> m_visibleFirst;   ///< Faixa visível (lida pelas threads)
+    std::shared_ptr<std::atomic_int> m_visibleLast;
+    QPixmap m_placeholder;                             ///< Célula ainda sem miniatura
+};
+
+#endif // DICOMTHUMBNAILMODEL_H
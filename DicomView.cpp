@@ -0,0 +1,138 @@
+/**
+ * @file DicomView.cpp
+ * @brief Implementação do visualizador gráfico de imagens DICOM.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomView.h"
+
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+#include <algorithm>
+
+/**
+ * @brief Construtor.
+ * @param scene Cena exibida.
+ * @param parent Widget pai.
+ */
+DicomView::DicomView(QGraphicsScene *scene, QWidget *parent)
+    : QGraphicsView(scene, parent) {
+}
+
+/**
+ * @brief Define a janela atual sem emitir windowLevelChanged().
+ */
+void DicomView::setWindowLevel(double center, double width) {
+    m_center = center;
+    m_width = std::max(width, 1.0);
+}
+
+/**
+ * @brief Define quantos valores de modalidade a janela varia por pixel arrastado.
+ */
+void DicomView::setWindowStep(double unitsPerPixel) {
+    m_step = std::max(unitsPerPixel, 0.01);
+}
+
+/**
+ * @brief Liga ou desliga a navegação por cortes (descarta o ângulo acumulado).
+ */
+void DicomView::setSliceScrolling(bool enabled) {
+    m_sliceScrolling = enabled;
+    m_wheelRemainder = 0;
+}
+
+/**
+ * @brief Liga ou desliga o modo de órbita (encerra um arraste em andamento).
+ */
+void DicomView::setOrbitMode(bool enabled) {
+    m_orbitMode = enabled;
+    m_orbiting = false;
+}
+
+/**
+ * @brief Inicia o janelamento com o botão direito; os demais botões seguem o comportamento padrão (pan).
+ */
+void DicomView::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::RightButton) {
+        m_windowing = true;
+        m_pressPos = event->pos();
+        m_pressCenter = m_center;
+        m_pressWidth = m_width;
+        m_savedCursor = viewport()->cursor();
+        viewport()->setCursor(Qt::SizeAllCursor);
+        event->accept();
+        return;
+    }
+    if (m_orbitMode && event->button() == Qt::LeftButton) {
+        m_orbiting = true;
+        m_orbitPos = event->pos();
+        event->accept();
+        return;
+    }
+    QGraphicsView::mousePressEvent(event);
+}
+
+/**
+ * @brief Atualiza a janela durante o arraste.
+ * @details Horizontal (direita = mais largo) altera o Window Width; vertical (baixo = mais alto)
+ * altera o Window Center. O cálculo parte do estado no clique, sem acumular erros.
+ */
+void DicomView::mouseMoveEvent(QMouseEvent *event) {
+    if (m_windowing) {
+        const QPoint delta = event->pos() - m_pressPos;
+        m_width = std::max(1.0, m_pressWidth + delta.x() * m_step);
+        m_center = m_pressCenter + delta.y() * m_step;
+        emit windowLevelChanged(m_center, m_width);
+        event->accept();
+        return;
+    }
+    if (m_orbiting) {
+        const QPoint delta = event->pos() - m_orbitPos;
+        m_orbitPos = event->pos();
+        emit orbitDragged(delta);
+        event->accept();
+        return;
+    }
+    QGraphicsView::mouseMoveEvent(event);
+}
+
+/**
+ * @brief Finaliza o janelamento ou a órbita.
+ */
+void DicomView::mouseReleaseEvent(QMouseEvent *event) {
+    if (m_windowing && event->button() == Qt::RightButton) {
+        m_windowing = false;
+        viewport()->setCursor(m_savedCursor);
+        event->accept();
+        return;
+    }
+    if (m_orbiting && event->button() == Qt::LeftButton) {
+        m_orbiting = false;
+        event->accept();
+        return;
+    }
+    QGraphicsView::mouseReleaseEvent(event);
+}
+
+/**
+ * @brief Converte a roda do mouse em passos de corte (roda para baixo = próximo corte).
+ * @details O ângulo é acumulado em m_wheelRemainder: touchpads enviam frações de passo, e
+ * só passos completos de 120 unidades emitem sliceScrolled().
+ */
+void DicomView::wheelEvent(QWheelEvent *event) {
+    if (!m_sliceScrolling) {
+        QGraphicsView::wheelEvent(event);
+        return;
+    }
+
+    m_wheelRemainder += event->angleDelta().y();
+    const int steps = m_wheelRemainder / 120;
+    if (steps != 0) {
+        m_wheelRemainder -= steps * 120;
+        emit sliceScrolled(-steps);
+    }
+    event->accept();
+}
@@ -0,0 +1,104 @@
+/**
+ * @file DicomView.h
+ * @brief Definição do visualizador gráfico de imagens DICOM.
+ * @details Especialização do QGraphicsView que adiciona as interações próprias de imagens
+ * médicas (janelamento com o botão direito) ao zoom/pan já oferecidos pelo Qt.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMVIEW_H
+#define DICOMVIEW_H
+
+#include <QCursor>
+#include <QGraphicsView>
+#include <QPoint>
+
+/**
+ * @class DicomView
+ * @brief QGraphicsView com Window/Level interativo e navegação por cortes.
+ *
+ * Arrastar com o botão direito altera a janela: o movimento horizontal ajusta a largura
+ * (Window Width, contraste) e o vertical ajusta o centro (Window Center, brilho).
+ * A view apenas calcula a nova janela e emite windowLevelChanged(); quem renderiza a
+ * imagem é o dono da cena, a partir dos pixels em profundidade nativa.
+ *
+ * Com a navegação por cortes ligada (volume ou multi-frame exibido), a roda do mouse não
+ * rola a cena: cada passo da roda (120 unidades de ângulo, acumuladas para touchpads)
+ * emite sliceScrolled().
+ *
+ * No modo de órbita (renderização 3D), arrastar com o botão esquerdo não move a cena:
+ * cada movimento emite orbitDragged() com o deslocamento desde o evento anterior.
+ */
+class DicomView : public QGraphicsView {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Construtor.
+     * @param scene Cena exibida.
+     * @param parent Widget pai.
+     */
+    explicit DicomView(QGraphicsScene *scene, QWidget *parent = nullptr);
+
+    /**
+     * @brief Define a janela atual sem emitir sinal (ex.: ao abrir um novo arquivo).
+     * @param center Window Center em valores de modalidade.
+     * @param width Window Width em valores de modalidade.
+     */
+    void setWindowLevel(double center, double width);
+
+    /**
+     * @brief Define a sensibilidade do arraste (valores de modalidade por pixel de tela).
+     * @param unitsPerPixel Variação da janela a cada pixel movido.
+     */
+    void setWindowStep(double unitsPerPixel);
+
+    /**
+     * @brief Liga ou desliga a navegação por cortes com a roda do mouse.
+     * @param enabled true = a roda emite sliceScrolled(); false = comportamento padrão.
+     */
+    void setSliceScrolling(bool enabled);
+
+    /**
+     * @brief Liga ou desliga o modo de órbita.
+     * @param enabled true = o arraste com o botão esquerdo emite orbitDragged(); false = pan.
+     */
+    void setOrbitMode(bool enabled);
+
+    double windowCenter() const { return m_center; } ///< Window Center atual
+    double windowWidth() const { return m_width; }   ///< Window Width atual
+
+signals:
+    /// Janela alterada pelo usuário (arraste com o botão direito).
+    void windowLevelChanged(double center, double width);
+
+    /// Roda do mouse com a navegação por cortes ligada (positivo = próximo corte).
+    void sliceScrolled(int steps);
+
+    /// Arraste com o botão esquerdo no modo de órbita (pixels desde o último movimento).
+    void orbitDragged(const QPoint &delta);
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    bool m_windowing = false; ///< Arraste de janelamento em andamento
+    QPoint m_pressPos;        ///< Posição do clique inicial
+    QCursor m_savedCursor;    ///< Cursor do viewport antes do arraste (mão do pan)
+    double m_pressCenter = 0.0;
+    double m_pressWidth = 1.0;
+    double m_center = 0.0;
+    double m_width = 1.0;
+    double m_step = 1.0;
+    bool m_sliceScrolling = false; ///< Roda do mouse troca o corte
+    int m_wheelRemainder = 0;      ///< Ângulo acumulado abaixo de um passo (1/8 de grau)
+    bool m_orbitMode = false;      ///< Botão esquerdo gira a câmera 3D
+    bool m_orbiting = false;       ///< Arraste de órbita em andamento
+    QPoint m_orbitPos;             ///< Posição do último movimento da órbita
+};
+
+#endif // DICOMVIEW_H
@@ -0,0 +1,476 @@
+/**
+ * @file DicomVolumeRenderer.cpp
+ * @brief Implementação da renderização volumétrica direta (ray casting) em CPU.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#include "DicomVolumeRenderer.h"
+#include "DicomLog.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+/// Abaixo desta norma (valores armazenados por mm) o gradiente não define uma superfície.
+static const float kMinGradient = 1.0f;
+
+static const double kPi = 3.14159265358979323846;
+
+using Brick = DicomBrickedVolume;
+
+/// Vetor 3D (coordenadas do paciente em mm ou coordenadas de voxel).
+struct Vec3 {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 0.0;
+};
+
+static Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+static Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+static Vec3 operator*(const Vec3 &a, double k) { return {a.x * k, a.y * k, a.z * k}; }
+static double dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec3 cross(const Vec3 &a, const Vec3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+static Vec3 normalized(const Vec3 &a) {
+    const double length = std::sqrt(dot(a, a));
+    return length > 0.0 ? a * (1.0 / length) : a;
+}
+
+// =========================================================
+// Funções de transferência prontas
+// =========================================================
+
+QVector<DicomVolumeRenderer::TransferPoint> DicomVolumeRenderer::windowPreset(double center, double width) {
+    const double half = std::max(width, 1.0) / 2.0;
+    return {{center - half, QColor(0, 0, 0), 0.0},
+            {center + half, QColor(255, 255, 255), 0.5}};
+}
+
+QVector<DicomVolumeRenderer::TransferPoint> DicomVolumeRenderer::ctBonePreset() {
+    return {{150.0, QColor(190, 140, 100), 0.0},
+            {300.0, QColor(230, 200, 170), 0.2},
+            {700.0, QColor(250, 240, 225), 0.6},
+            {3000.0, QColor(255, 255, 255), 0.8}};
+}
+
+QVector<DicomVolumeRenderer::TransferPoint> DicomVolumeRenderer::ctSoftTissuePreset() {
+    return {{-500.0, QColor(190, 120, 90), 0.0},
+            {-300.0, QColor(210, 140, 110), 0.02},
+            {-50.0, QColor(220, 110, 90), 0.01},
+            {40.0, QColor(200, 60, 50), 0.05},
+            {200.0, QColor(240, 200, 170), 0.1},
+            {400.0, QColor(255, 245, 230), 0.5},
+            {3000.0, QColor(255, 255, 255), 0.8}};
+}
+
+// =========================================================
+// Estado e interação
+// =========================================================
+
+/**
+ * @brief Construtor. O token do refinamento começa como filho de m_lifetime já cancelado.
+ */
+DicomVolumeRenderer::DicomVolumeRenderer(QObject *parent)
+    : QObject(parent),
+      m_token(m_lifetime.child()) {
+    m_token.cancel();
+    m_idle.setSingleShot(true);
+    m_idle.setInterval(kIdleMs);
+
+    connect(&m_idle, &QTimer::timeout, this, &DicomVolumeRenderer::refine);
+    connect(this, &DicomVolumeRenderer::jobFinished, this, &DicomVolumeRenderer::onJobFinished, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Destrutor. As tarefas referenciam 'this': descarta as pendentes e aguarda as ativas.
+ */
+DicomVolumeRenderer::~DicomVolumeRenderer() {
+    m_lifetime.cancel();
+    m_lifetime.waitForIdle();
+}
+
+/**
+ * @brief Define o volume e calcula a faixa de cada bloco.
+ * @details A faixa de um bloco cobre os voxels [início, início + kBrickSize] em cada eixo
+ * (um a mais que o bloco): uma amostra dentro do bloco interpola também os vizinhos da
+ * borda seguinte, e o salto só é seguro se eles também forem transparentes. Lida do
+ * volume contíguo, uma tarefa por linha de blocos.
+ */
+void DicomVolumeRenderer::setVolume(const DicomVolume &volume, const DicomBrickedVolume &bricks) {
+    clear();
+    if (volume.isNull() || bricks.isNull()) {
+        return;
+    }
+
+    auto ranges = std::make_shared<std::vector<BrickRange>>(size_t(bricks.bricksX) * bricks.bricksY * bricks.bricksZ);
+    const quint16 *voxels = volume.voxels.get();
+    const qint64 sliceSize = volume.sliceSize();
+    DicomScheduler::instance().parallelFor(bricks.bricksZ * bricks.bricksY, [&](int row) {
+        const int bz = row / bricks.bricksY;
+        const int by = row % bricks.bricksY;
+        const int z0 = bz << Brick::kBrickShift;
+        const int y0 = by << Brick::kBrickShift;
+        const int z1 = std::min(z0 + Brick::kBrickSize, volume.depth - 1);
+        const int y1 = std::min(y0 + Brick::kBrickSize, volume.height - 1);
+        for (int bx = 0; bx < bricks.bricksX; ++bx) {
+            const int x0 = bx << Brick::kBrickShift;
+            const int x1 = std::min(x0 + Brick::kBrickSize, volume.width - 1);
+            quint16 low = 65535, high = 0;
+            for (int z = z0; z <= z1; ++z) {
+                for (int y = y0; y <= y1; ++y) {
+                    const quint16 *line = voxels + sliceSize * z + qint64(y) * volume.width;
+                    for (int x = x0; x <= x1; ++x) {
+                        low = std::min(low, line[x]);
+                        high = std::max(high, line[x]);
+                    }
+                }
+            }
+            BrickRange &range = (*ranges)[(size_t(bz) * bricks.bricksY + by) * bricks.bricksX + bx];
+            range.minStored = low;
+            range.maxStored = high;
+        }
+    });
+
+    m_volume = volume;
+    m_bricks = bricks;
+    m_ranges = ranges;
+    m_azimuth = 0.0;
+    m_elevation = 0.0;
+    rebuildLut();
+}
+
+void DicomVolumeRenderer::clear() {
+    m_idle.stop();
+    m_token.cancel();
+    ++m_generation;
+    m_volume = DicomVolume();
+    m_bricks = DicomBrickedVolume();
+    m_ranges.reset();
+    m_lut.reset();
+}
+
+void DicomVolumeRenderer::setTransferFunction(const QVector<TransferPoint> &points) {
+    m_points = points;
+    std::sort(m_points.begin(), m_points.end(), [](const TransferPoint &a, const TransferPoint &b) {
+        return a.value < b.value;
+    });
+    rebuildLut();
+    render();
+}
+
+void DicomVolumeRenderer::setImageSize(int size) {
+    m_size = qBound(64, size, 2048);
+}
+
+void DicomVolumeRenderer::rotate(double degreesX, double degreesY) {
+    m_azimuth = std::fmod(m_azimuth + degreesX, 360.0);
+    m_elevation = qBound(-89.0, m_elevation + degreesY, 89.0);
+    render();
+}
+
+void DicomVolumeRenderer::resetCamera() {
+    m_azimuth = 0.0;
+    m_elevation = 0.0;
+    render();
+}
+
+/**
+ * @brief Pré-visualização imediata (resolução reduzida, passo dobrado) e refinamento agendado.
+ * @details A pré-visualização roda na thread chamadora com parallelFor (a thread participa);
+ * qualquer refinamento em andamento é cancelado e o temporizador recomeça.
+ */
+void DicomVolumeRenderer::render() {
+    if (!isActive() || !m_lut) {
+        return;
+    }
+    m_token.cancel();
+    ++m_generation;
+
+    const QImage preview = renderScene(scene(std::max(1, m_size / kPreviewScale), 2.0), m_lifetime);
+    emit imageReady(preview, kPreviewScale);
+    m_idle.start();
+}
+
+/**
+ * @brief Renderiza a resolução completa em segundo plano (a interação parou).
+ */
+void DicomVolumeRenderer::refine() {
+    if (!isActive() || !m_lut) {
+        return;
+    }
+    m_token = m_lifetime.child();
+
+    const Scene full = scene(m_size, 1.0);
+    const quint64 generation = m_generation;
+    const DicomScheduler::CancellationToken token = m_token;
+    DicomScheduler::instance().submit(DicomScheduler::Priority::Interactive, [this, full, generation, token]() {
+        QElapsedTimer timer;
+        timer.start();
+        const QImage image = renderScene(full, token);
+        if (!image.isNull()) {
+            qCDebug(dicomPerf) << "Ray casting:" << full.size << "x" << full.size << "em" << timer.elapsed() << "ms";
+            emit jobFinished(generation, image);
+        }
+    }, token);
+}
+
+void DicomVolumeRenderer::onJobFinished(quint64 generation, const QImage &image) {
+    if (generation != m_generation) {
+        return; // Cena alterada depois do pedido
+    }
+    emit imageReady(image, 1);
+}
+
+DicomVolumeRenderer::Scene DicomVolumeRenderer::scene(int size, double stepScale) const {
+    Scene scene;
+    scene.volume = m_volume;
+    scene.bricks = m_bricks;
+    scene.ranges = m_ranges;
+    scene.lut = m_lut;
+    scene.azimuth = m_azimuth;
+    scene.elevation = m_elevation;
+    scene.size = size;
+    scene.stepScale = stepScale;
+    return scene;
+}
+
+/**
+ * @brief Tabela a função de transferência por valor armazenado.
+ * @details O valor armazenado é reduzido (>> shift) até caber em kLutSize entradas; cada
+ * entrada usa o valor de modalidade do centro do seu intervalo. A opacidade fica por mm:
+ * renderScene() a converte para o passo usado.
+ */
+void DicomVolumeRenderer::rebuildLut() {
+    m_lut.reset();
+    if (m_volume.isNull() || m_points.isEmpty()) {
+        return;
+    }
+
+    auto lut = std::make_shared<TransferLut>();
+    while ((int(m_volume.maxStored) >> lut->shift) >= kLutSize) {
+        ++lut->shift;
+    }
+    lut->rgba.resize(size_t(kLutSize) * 4);
+    lut->visiblePrefix.assign(size_t(kLutSize) + 1, 0);
+
+    for (int i = 0; i < kLutSize; ++i) {
+        const double value = double((i << lut->shift) + ((1 << lut->shift) >> 1)) + m_volume.valueOffset;
+
+        // Pontos vizinhos (fora da faixa, o ponto da extremidade)
+        int next = 0;
+        while (next < m_points.size() && m_points.at(next).value < value) {
+            ++next;
+        }
+        const TransferPoint &a = m_points.at(std::max(0, next - 1));
+        const TransferPoint &b = m_points.at(std::min(next, m_points.size() - 1));
+        const double t = (b.value > a.value) ? qBound(0.0, (value - a.value) / (b.value - a.value), 1.0) : 0.0;
+
+        float *rgba = lut->rgba.data() + size_t(i) * 4;
+        rgba[0] = float((a.color.redF() + (b.color.redF() - a.color.redF()) * t));
+        rgba[1] = float((a.color.greenF() + (b.color.greenF() - a.color.greenF()) * t));
+        rgba[2] = float((a.color.blueF() + (b.color.blueF() - a.color.blueF()) * t));
+        rgba[3] = float(qBound(0.0, a.opacity + (b.opacity - a.opacity) * t, 1.0));
+        lut->visiblePrefix[size_t(i) + 1] = lut->visiblePrefix[size_t(i)] + (rgba[3] > 0.0f ? 1 : 0);
+    }
+    m_lut = lut;
+}
+
+// =========================================================
+// Ray casting
+// =========================================================
+
+/**
+ * @brief Valor interpolado (trilinear) em coordenadas de voxel já limitadas ao volume.
+ */
+static float sampleTrilinear(const DicomBrickedVolume &bricks, double x, double y, double z) {
+    const int x0 = int(x), y0 = int(y), z0 = int(z);
+    const int x1 = std::min(x0 + 1, bricks.width - 1);
+    const int y1 = std::min(y0 + 1, bricks.height - 1);
+    const int z1 = std::min(z0 + 1, bricks.depth - 1);
+    const float fx = float(x - x0), fy = float(y - y0), fz = float(z - z0);
+
+    const float c00 = bricks.at(x0, y0, z0) + (bricks.at(x1, y0, z0) - float(bricks.at(x0, y0, z0))) * fx;
+    const float c10 = bricks.at(x0, y1, z0) + (bricks.at(x1, y1, z0) - float(bricks.at(x0, y1, z0))) * fx;
+    const float c01 = bricks.at(x0, y0, z1) + (bricks.at(x1, y0, z1) - float(bricks.at(x0, y0, z1))) * fx;
+    const float c11 = bricks.at(x0, y1, z1) + (bricks.at(x1, y1, z1) - float(bricks.at(x0, y1, z1))) * fx;
+    const float c0 = c00 + (c10 - c00) * fy;
+    const float c1 = c01 + (c11 - c01) * fy;
+    return c0 + (c1 - c0) * fz;
+}
+
+/**
+ * @brief Renderiza a cena.
+ * @details Etapas:
+ * 1. Geometria: voxel (i, j, k) fica em (i * spacingX, j * spacingY, k * spacingZ) mm; a
+ *    câmera ortográfica olha para o centro do volume e a imagem cobre a diagonal.
+ * 2. Tabelas da renderização: opacidade por passo (1 - (1 - opacidade)^passo) e blocos
+ *    vazios (faixa do bloco sem nenhuma entrada visível na função de transferência).
+ * 3. Blocos de kTileSize x kTileSize pixels em paralelo; cada raio é recortado à caixa
+ *    do volume e percorrido em passos inteiros (coordenadas de voxel):
+ *    - bloco vazio: o raio avança até o primeiro passo fora do bloco;
+ *    - amostra visível: sombreamento difuso pelo gradiente (diferenças centrais) e
+ *      composição da frente para trás até kOpaqueAlpha.
+ */
+QImage DicomVolumeRenderer::renderScene(const Scene &scene, const DicomScheduler::CancellationToken &token) {
+    const DicomVolume &volume = scene.volume;
+    const DicomBrickedVolume &bricks = scene.bricks;
+    if (volume.isNull() || bricks.isNull() || !scene.lut || !scene.ranges || scene.size <= 0) {
+        return QImage();
+    }
+    const TransferLut &lut = *scene.lut;
+
+    // [1] Geometria
+    const Vec3 spacing = {volume.spacingX > 0.0 ? volume.spacingX : 1.0,
+                          volume.spacingY > 0.0 ? volume.spacingY : 1.0,
+                          volume.spacingZ > 0.0 ? volume.spacingZ : 1.0};
+    const Vec3 box = {(volume.width - 1) * spacing.x, (volume.height - 1) * spacing.y, (volume.depth - 1) * spacing.z};
+    const Vec3 center = box * 0.5;
+    const double diagonal = std::max(1.0, std::sqrt(dot(box, box)));
+    const double step = std::min(spacing.x, std::min(spacing.y, spacing.z)) * scene.stepScale;
+
+    const double azimuth = scene.azimuth * kPi / 180.0;
+    const double elevation = scene.elevation * kPi / 180.0;
+    const Vec3 forward = {std::sin(azimuth) * std::cos(elevation), std::cos(azimuth) * std::cos(elevation), -std::sin(elevation)};
+    const Vec3 up = normalized(Vec3{0.0, 0.0, 1.0} - forward * forward.z);   // Cabeça para cima
+    const Vec3 right = cross(forward, up);
+    const double pixel = diagonal / scene.size;
+
+    // Passo em coordenadas de voxel
+    const Vec3 delta = {forward.x * step / spacing.x, forward.y * step / spacing.y, forward.z * step / spacing.z};
+    const Vec3 limit = {double(volume.width - 1), double(volume.height - 1), double(volume.depth - 1)};
+
+    // [2] Tabelas
+    std::vector<float> alpha(static_cast<size_t>(kLutSize));
+    for (int i = 0; i < kLutSize; ++i) {
+        alpha[size_t(i)] = 1.0f - float(std::pow(1.0 - lut.rgba[size_t(i) * 4 + 3], step));
+    }
+    std::vector<char> empty(scene.ranges->size());
+    for (size_t i = 0; i < empty.size(); ++i) {
+        const BrickRange &range = (*scene.ranges)[i];
+        const int low = range.minStored >> lut.shift;
+        const int high = range.maxStored >> lut.shift;
+        empty[i] = (lut.visiblePrefix[size_t(high) + 1] == lut.visiblePrefix[size_t(low)]);
+    }
+
+    // Gradiente por diferenças centrais (valores armazenados por mm)
+    auto gradient = [&](int x, int y, int z) {
+        const int xm = std::max(x - 1, 0), xp = std::min(x + 1, volume.width - 1);
+        const int ym = std::max(y - 1, 0), yp = std::min(y + 1, volume.height - 1);
+        const int zm = std::max(z - 1, 0), zp = std::min(z + 1, volume.depth - 1);
+        return Vec3{(float(bricks.at(xp, y, z)) - bricks.at(xm, y, z)) / ((xp - xm) * spacing.x + 1e-9),
+                    (float(bricks.at(x, yp, z)) - bricks.at(x, ym, z)) / ((yp - ym) * spacing.y + 1e-9),
+                    (float(bricks.at(x, y, zp)) - bricks.at(x, y, zm)) / ((zp - zm) * spacing.z + 1e-9)};
+    };
+
+    // Um raio: cor RGB (0-1) composta da frente para trás
+    auto castRay = [&](const Vec3 &origin, float rgb[3]) {
+        rgb[0] = rgb[1] = rgb[2] = 0.0f;
+
+        // Origem em voxels e recorte à caixa [0, limit] (parâmetro em passos)
+        const Vec3 start = {origin.x / spacing.x, origin.y / spacing.y, origin.z / spacing.z};
+        double enter = 0.0;
+        double leave = diagonal / step;
+        const double starts[3] = {start.x, start.y, start.z};
+        const double deltas[3] = {delta.x, delta.y, delta.z};
+        const double limits[3] = {limit.x, limit.y, limit.z};
+        for (int axis = 0; axis < 3; ++axis) {
+            if (std::abs(deltas[axis]) < 1e-12) {
+                if (starts[axis] < 0.0 || starts[axis] > limits[axis]) {
+                    return;
+                }
+                continue;
+            }
+            double t0 = (0.0 - starts[axis]) / deltas[axis];
+            double t1 = (limits[axis] - starts[axis]) / deltas[axis];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            enter = std::max(enter, t0);
+            leave = std::min(leave, t1);
+        }
+
+        float accumulated = 0.0f;
+        for (double n = std::ceil(enter); n <= leave; n += 1.0) {
+            const double x = qBound(0.0, start.x + deltas[0] * n, limit.x);
+            const double y = qBound(0.0, start.y + deltas[1] * n, limit.y);
+            const double z = qBound(0.0, start.z + deltas[2] * n, limit.z);
+
+            // Salto de blocos vazios: primeiro passo fora do bloco
+            const int bx = std::min(int(x) >> Brick::kBrickShift, bricks.bricksX - 1);
+            const int by = std::min(int(y) >> Brick::kBrickShift, bricks.bricksY - 1);
+            const int bz = std::min(int(z) >> Brick::kBrickShift, bricks.bricksZ - 1);
+            if (empty[(size_t(bz) * bricks.bricksY + by) * bricks.bricksX + bx]) {
+                const double position[3] = {x, y, z};
+                const int brickIndex[3] = {bx, by, bz};
+                double exit = leave - n;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (deltas[axis] > 1e-12) {
+                        exit = std::min(exit, ((brickIndex[axis] + 1) * Brick::kBrickSize - position[axis]) / deltas[axis]);
+                    } else if (deltas[axis] < -1e-12) {
+                        exit = std::min(exit, (brickIndex[axis] * Brick::kBrickSize - position[axis]) / deltas[axis]);
+                    }
+                }
+                n += std::max(0.0, std::floor(exit)); // O incremento do laço dá o passo restante
+                continue;
+            }
+
+            const float value = sampleTrilinear(bricks, x, y, z);
+            const int entry = std::min(int(value) >> lut.shift, kLutSize - 1);
+            const float a = alpha[size_t(entry)];
+            if (a <= 0.0f) {
+                continue;
+            }
+
+            // Sombreamento difuso com luz na câmera (faces voltadas para o observador mais claras)
+            const Vec3 g = gradient(int(x + 0.5), int(y + 0.5), int(z + 0.5));
+            const double norm = std::sqrt(dot(g, g));
+            const float shade = (norm > kMinGradient) ? float(0.3 + 0.7 * std::abs(dot(g, forward)) / norm) : 1.0f;
+
+            const float *color = lut.rgba.data() + size_t(entry) * 4;
+            const float weight = (1.0f - accumulated) * a * shade;
+            rgb[0] += weight * color[0];
+            rgb[1] += weight * color[1];
+            rgb[2] += weight * color[2];
+            accumulated += (1.0f - accumulated) * a;
+            if (accumulated >= kOpaqueAlpha) {
+                break; // Término antecipado
+            }
+        }
+    };
+
+    // [3] Blocos da imagem em paralelo
+    QImage image(scene.size, scene.size, QImage::Format_RGB32);
+    if (image.isNull()) {
+        return image; // Falha de alocação
+    }
+    uchar *bits = image.bits(); // Uma vez aqui: scanLine() não constante faz detach()
+    const qint64 bytesPerLine = image.bytesPerLine();
+    const int tiles = (scene.size + kTileSize - 1) / kTileSize;
+    std::atomic_bool canceled{false};
+    DicomScheduler::instance().parallelFor(tiles * tiles, [&](int tile) {
+        if (canceled.load() || token.isCanceled()) {
+            canceled.store(true);
+            return;
+        }
+        const int top = (tile / tiles) * kTileSize;
+        const int left = (tile % tiles) * kTileSize;
+        const int bottom = std::min(top + kTileSize, scene.size);
+        const int rightEdge = std::min(left + kTileSize, scene.size);
+        for (int j = top; j < bottom; ++j) {
+            QRgb *line = reinterpret_cast<QRgb *>(bits + j * bytesPerLine);
+            const Vec3 rowOrigin = center - forward * (diagonal / 2.0) - up * ((j + 0.5 - scene.size / 2.0) * pixel);
+            for (int i = left; i < rightEdge; ++i) {
+                float rgb[3];
+                castRay(rowOrigin + right * ((i + 0.5 - scene.size / 2.0) * pixel), rgb);
+                line[i] = qRgb(int(std::min(1.0f, rgb[0]) * 255.0f + 0.5f),
+                               int(std::min(1.0f, rgb[1]) * 255.0f + 0.5f),
+                               int(std::min(1.0f, rgb[2]) * 255.0f + 0.5f));
+            }
+        }
+    });
+    return canceled.load() ? QImage() : image;
+}
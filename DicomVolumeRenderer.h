@@ -0,0 +1,189 @@
+/**
+ * @file DicomVolumeRenderer.h
+ * @brief Definição da renderização volumétrica direta (ray casting) em CPU.
+ * @details Renderização 3D de séries empilhadas sem GPU (estações de laudo em VDI): os raios
+ * são lançados em blocos da imagem divididos entre os núcleos do DicomScheduler, com função
+ * de transferência, término antecipado e salto de regiões vazias pelos blocos do volume.
+ * @author Marco Antonio (Saturnino.eng)
+ * @version 1.2.0
+ */
+
+#ifndef DICOMVOLUMERENDERER_H
+#define DICOMVOLUMERENDERER_H
+
+#include <QColor>
+#include <QImage>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+#include "DicomManager.h"
+#include "DicomMpr.h"
+#include "DicomScheduler.h"
+
+/**
+ * @class DicomVolumeRenderer
+ * @brief Ray casting de um DicomVolume com refinamento progressivo.
+ *
+ * A câmera é ortográfica e orbita o centro do volume (azimute em torno do eixo z do
+ * paciente, elevação acima/abaixo do plano axial). Cada raio percorre o volume em passos
+ * do menor espaçamento entre voxels, amostrando os blocos do DicomBrickedVolume com
+ * interpolação trilinear:
+ * - função de transferência: valores de modalidade -> cor e opacidade por mm, tabelada por
+ *   valor armazenado (kLutSize entradas) e corrigida para o tamanho do passo;
+ * - composição da frente para trás, encerrada quando a opacidade acumulada passa de
+ *   kOpaqueAlpha (término antecipado);
+ * - salto de regiões vazias: cada bloco de 16³ voxels tem os valores mínimo e máximo
+ *   (incluindo a borda lida pela interpolação); se a função de transferência é
+ *   transparente em toda essa faixa, o raio pula direto para a saída do bloco.
+ *
+ * A imagem é dividida em blocos de kTileSize x kTileSize pixels renderizados em paralelo.
+ * Enquanto o usuário interage (rotação, janela), a imagem é renderizada na hora com
+ * 1/kPreviewScale da resolução e passo dobrado; depois de kIdleMs sem interação, a
+ * resolução completa é renderizada em segundo plano (tarefa cancelável, descartada se
+ * houver nova interação).
+ */
+class DicomVolumeRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    static const int kTileSize = 32;             ///< Lado do bloco de pixels por tarefa
+    static const int kLutSize = 4096;            ///< Entradas da função de transferência tabelada
+    static const int kPreviewScale = 4;          ///< Redução da resolução durante a interação
+    static const int kIdleMs = 150;              ///< Tempo sem interação até o refinamento
+    static constexpr float kOpaqueAlpha = 0.98f; ///< Opacidade acumulada que encerra o raio
+
+    /**
+     * @struct TransferPoint
+     * @brief Ponto de controle da função de transferência (interpolação linear entre pontos).
+     */
+    struct TransferPoint {
+        double value = 0.0;   ///< Valor de modalidade (ex.: HU)
+        QColor color;         ///< Cor
+        double opacity = 0.0; ///< Opacidade por mm percorrido (0 a 1)
+    };
+
+    /// Rampa da janela (fora dela, transparente abaixo e opaco acima), em tons de cinza.
+    static QVector<TransferPoint> windowPreset(double center, double width);
+
+    /// CT: osso (tecidos moles transparentes).
+    static QVector<TransferPoint> ctBonePreset();
+
+    /// CT: pele e tecidos moles semitransparentes, osso opaco.
+    static QVector<TransferPoint> ctSoftTissuePreset();
+
+    /**
+     * @brief Construtor.
+     * @param parent Objeto pai.
+     */
+    explicit DicomVolumeRenderer(QObject *parent = nullptr);
+
+    /**
+     * @brief Destrutor. Cancela o refinamento pendente e aguarda o que estiver em execução.
+     */
+    ~DicomVolumeRenderer() override;
+
+    /**
+     * @brief Define o volume (câmera na vista anterior) e calcula a faixa de valores de cada bloco.
+     * @param volume Volume contíguo (geometria, espaçamento e valores).
+     * @param bricks Mesmo volume em blocos (DicomMpr::brick).
+     */
+    void setVolume(const DicomVolume &volume, const DicomBrickedVolume &bricks);
+
+    /// Esquece o volume (libera a tabela de blocos) e cancela o refinamento.
+    void clear();
+
+    /// Troca a função de transferência e renderiza a pré-visualização.
+    void setTransferFunction(const QVector<TransferPoint> &points);
+
+    /// Lado da imagem final (pixels; a imagem é quadrada e cobre a diagonal do volume).
+    void setImageSize(int size);
+
+    /**
+     * @brief Gira a câmera e renderiza a pré-visualização.
+     * @param degreesX Variação do azimute (graus).
+     * @param degreesY Variação da elevação (graus; limitada a +-89).
+     */
+    void rotate(double degreesX, double degreesY);
+
+    /// Volta à vista anterior (paciente de frente, cabeça para cima) e renderiza.
+    void resetCamera();
+
+    /// Renderiza a pré-visualização agora e agenda o refinamento.
+    void render();
+
+    bool isActive() const { return !m_volume.isNull(); } ///< Há volume definido
+    int imageSize() const { return m_size; }             ///< Lado da imagem final
+
+signals:
+    /**
+     * @brief Nova imagem renderizada.
+     * @param image Imagem RGB (lado = imageSize() / downsample).
+     * @param downsample 1 para a resolução completa, kPreviewScale para a pré-visualização.
+     */
+    void imageReady(const QImage &image, int downsample);
+
+    // --- Sinal interno (thread de trabalho -> thread da interface) ---
+    void jobFinished(quint64 generation, const QImage &image);
+
+private slots:
+    void refine();
+    void onJobFinished(quint64 generation, const QImage &image);
+
+private:
+    /// Faixa de valores armazenados de um bloco (com a borda lida pela interpolação).
+    struct BrickRange {
+        quint16 minStored = 0;
+        quint16 maxStored = 0;
+    };
+
+    /// Função de transferência tabelada por valor armazenado.
+    struct TransferLut {
+        int shift = 0;                    ///< Valor armazenado >> shift = entrada
+        std::vector<float> rgba;          ///< kLutSize entradas RGBA (cor 0-1, opacidade por passo)
+        std::vector<int> visiblePrefix;   ///< Entradas com opacidade > 0 acumuladas (salto de blocos)
+    };
+
+    /// Tudo o que uma renderização lê (copiado para a tarefa; os buffers são compartilhados).
+    struct Scene {
+        DicomVolume volume;
+        DicomBrickedVolume bricks;
+        std::shared_ptr<const std::vector<BrickRange>> ranges;
+        std::shared_ptr<const TransferLut> lut;
+        double azimuth = 0.0;   ///< Graus
+        double elevation = 0.0; ///< Graus
+        int size = 0;           ///< Lado da imagem (pixels)
+        double stepScale = 1.0; ///< Passo em múltiplos do menor espaçamento
+    };
+
+    /**
+     * @brief Renderiza uma cena (blocos da imagem em paralelo).
+     * @param scene Volume, câmera e função de transferência.
+     * @param token Consultado a cada bloco; imagem nula se cancelado.
+     */
+    static QImage renderScene(const Scene &scene, const DicomScheduler::CancellationToken &token);
+
+    /// Cena atual com o tamanho e o passo pedidos.
+    Scene scene(int size, double stepScale) const;
+
+    /// Tabela a função de transferência para a faixa de valores do volume.
+    void rebuildLut();
+
+    DicomVolume m_volume;                                   ///< Volume renderizado
+    DicomBrickedVolume m_bricks;                            ///< Mesmo volume em blocos
+    std::shared_ptr<const std::vector<BrickRange>> m_ranges; ///< Faixa de cada bloco
+    QVector<TransferPoint> m_points;                        ///< Função de transferência
+    std::shared_ptr<const TransferLut> m_lut;               ///< Função tabelada
+    double m_azimuth = 0.0;                                 ///< Graus
+    double m_elevation = 0.0;                               ///< Graus
+    int m_size = 512;                                       ///< Lado da imagem final
+    QTimer m_idle;                                          ///< Refinamento após a interação
+    quint64 m_generation = 0;                               ///< Incrementado a cada mudança da cena
+    DicomScheduler::CancellationToken m_lifetime;           ///< Pai dos tokens (cancelado no destrutor)
+    DicomScheduler::CancellationToken m_token;              ///< Refinamento em andamento
+};
+
+#endif // DICOMVOLUMERENDERER_H
@@ -16,14 +16,23 @@
 #include <QVBoxLayout>      // Organiza widgets verticalmente (um em cima do outro)
 #include <QHBoxLayout>      // Organiza widgets horizontalmente (um ao lado do outro)
 #include <QFileDialog>      // A janela de "Abrir Arquivo" do sistema operacional
+#include <QFileInfo>        // Informações do arquivo (nome exibido no progresso)
+#include <QCommandLineParser> // Opções de linha de comando (ex.: orçamento do cache)
 #include <QMessageBox>      // Janelas de alerta (Pop-ups de erro)
 #include <QApplication>     // Gerencia o fluxo da aplicação e configurações globais
 #include <QGraphicsView>    // O "visualizador" da imagem (permite zoom/pan)
 #include <QStackedWidget>   // Gerencia as "páginas" (Tela Inicial vs Visualizador)
 #include <QGraphicsScene>   // A "cena" onde a imagem é desenhada dentro do View
 #include <QProgressDialog> // Para a janela de "Aguarde"
+#include <QDockWidget>      // Painel lateral do navegador de pastas
+#include <QLineEdit>        // Campos de filtro do navegador
+#include <QElapsedTimer>    // Tempo das consultas ao índice
+#include <QListView>        // Galeria de miniaturas (virtualizada)
+#include <QScrollBar>       // Rolagem da galeria (faixa visível)
 #include <QGuiApplication>  // Classe base para aplicações com GUI
-#include <QGraphicsPixmapItem> // O item que contém a imagem
+#include <QGraphicsPixmapItem> // O item que contém a imagem (imagens coloridas)
+
+#include <algorithm>        // std::sort (instâncias da galeria)
 
 // Includes dos Codecs de descompressão da DCMTK
 #include "dcmtk/dcmjpeg/djdecode.h"  // Permite abrir DICOM comprimido em JPEG
@@ -32,6 +41,18 @@
 
 // Gerenciador personalizado
 #include "DicomManager.h" // Classes que fazem a ponte entre o arquivo .dcm e o Qt
+#include "DicomLoader.h"  // Carregamento assíncrono (fora da thread da interface)
+#include "DicomCache.h"   // Cache LRU das imagens decodificadas
+#include "DicomDiskCache.h" // Cache persistente dos pixels decodificados (opcional)
+#include "DicomView.h"    // QGraphicsView com janelamento interativo (botão direito)
+#include "DicomImageItem.h" // Item da cena com pirâmide de resolução
+#include "DicomScanner.h" // Varredura paralela de pastas ("Abrir Pasta")
+#include "DicomBrowser.h" // Árvore Paciente -> Estudo -> Série -> Instância
+#include "DicomArchiveIndex.h" // Índice persistente da pasta (reindexação incremental)
+#include "DicomThumbnailModel.h" // Miniaturas geradas sob demanda para a galeria
+#include "DicomCinePlayer.h" // Reprodução cine de multi-frames (frames decodificados à frente)
+#include "DicomMpr.h"        // Reconstrução multiplanar (axial / coronal / sagital) de séries
+#include "DicomVolumeRenderer.h" // Renderização volumétrica 3D (ray casting em CPU)
 
 /**
  * @brief Função principal da aplicação.
@@ -52,6 +73,33 @@ int main(int argc, char *argv[]) {
     
     QApplication app(argc, argv); //Prepara o ambiente gráfico
 
+    // --- Opções de linha de comando ---
+    // --cache-mb N: memória máxima das imagens decodificadas mantidas para reabertura instantânea
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption cacheOption("cache-mb", "Memória máxima (MB) do cache de imagens decodificadas.", "MB",
+                                   QString::number(DicomCache::kDefaultBudget / (1024 * 1024)));
+    parser.addOption(cacheOption);
+    // --disk-cache DIR: grava os pixels decodificados em DIR e os mapeia nas próximas aberturas
+    QCommandLineOption diskCacheOption("disk-cache", "Diretório do cache persistente de pixels decodificados.", "DIR");
+    parser.addOption(diskCacheOption);
+    // --benchmark-jpeg-lossless ARQUIVO: compara o decodificador JPEG Lossless próprio com a DCMTK e encerra
+    QCommandLineOption benchmarkOption("benchmark-jpeg-lossless",
+                                       "Compara o decodificador JPEG Lossless próprio com a DCMTK no arquivo e encerra.",
+                                       "ARQUIVO");
+    parser.addOption(benchmarkOption);
+    parser.process(app);
+    DicomCache::instance().setBudget(parser.value(cacheOption).toLongLong() * 1024 * 1024);
+    DicomDiskCache::setDirectory(parser.value(diskCacheOption));
+
+    if (parser.isSet(benchmarkOption)) {
+        const bool identical = DicomManager::benchmarkJpegLossless(parser.value(benchmarkOption));
+        DJDecoderRegistration::cleanup();
+        DJLSDecoderRegistration::cleanup();
+        DcmRLEDecoderRegistration::cleanup();
+        return identical ? 0 : 1;
+    }
+
     // Configuração da Janela Principal
     QMainWindow window;
     window.setWindowTitle("Saturnino.eng View - Versão 1.2.0");
@@ -124,6 +172,19 @@ int main(int argc, char *argv[]) {
     );
     
     welcomeLayout->addWidget(btnBigOpen, 0, Qt::AlignCenter);
+
+    // Botão Secundário "Abrir Pasta" (varre a pasta e monta o navegador de estudos)
+    QPushButton *btnBigOpenFolder = new QPushButton("📁 Abrir Pasta");
+    btnBigOpenFolder->setCursor(Qt::PointingHandCursor);
+    btnBigOpenFolder->setFixedSize(300, 45);
+    btnBigOpenFolder->setStyleSheet(
+        "QPushButton { "
+        "  background-color: #ecf0f1; color: #2c3e50; border-radius: 8px; font-size: 16px; font-weight: bold;"
+        "}"
+        "QPushButton:hover { background-color: #d5dbdb; }"
+    );
+    welcomeLayout->addSpacing(10);
+    welcomeLayout->addWidget(btnBigOpenFolder, 0, Qt::AlignCenter);
     welcomeLayout->addStretch(); 
 
     // =========================================================
@@ -146,7 +207,7 @@ int main(int argc, char *argv[]) {
 
     // 1. O Visualizador (Fica na camada de fundo)
     QGraphicsScene *scene = new QGraphicsScene();
-    QGraphicsView *view = new QGraphicsView(scene);
+    DicomView *view = new DicomView(scene);
     view->setDragMode(QGraphicsView::ScrollHandDrag); 
     view->setBackgroundBrush(Qt::black);              
     
@@ -175,6 +236,18 @@ int main(int argc, char *argv[]) {
     lblTopRight->setAttribute(Qt::WA_TransparentForMouseEvents);
     overlayLayout->addWidget(lblTopRight, 0, 1, Qt::AlignTop | Qt::AlignRight);
 
+    // Canto Inferior Esquerdo (Janela atual: Window Level / Window Width)
+    QLabel *lblBottomLeft = new QLabel("");
+    lblBottomLeft->setStyleSheet(overlayStyle);
+    lblBottomLeft->setAttribute(Qt::WA_TransparentForMouseEvents);
+    overlayLayout->addWidget(lblBottomLeft, 2, 0, Qt::AlignBottom | Qt::AlignLeft);
+
+    // Acima do canto inferior esquerdo (Cine: frame atual, taxa e contadores de fluidez)
+    QLabel *lblCine = new QLabel("");
+    lblCine->setStyleSheet(overlayStyle);
+    lblCine->setAttribute(Qt::WA_TransparentForMouseEvents);
+    overlayLayout->addWidget(lblCine, 1, 0, Qt::AlignBottom | Qt::AlignLeft);
+
     // Canto Inferior Direito (Info Técnica)
     QLabel *lblBottomRight = new QLabel("");
     lblBottomRight->setStyleSheet(overlayStyle);
@@ -189,6 +262,11 @@ int main(int argc, char *argv[]) {
     QHBoxLayout *toolsLayout = new QHBoxLayout();
     
     QPushButton *btnOpenAnother = new QPushButton("Abrir Outro");
+    QPushButton *btnOpenFolder = new QPushButton("Abrir Pasta");
+    QPushButton *btnCine = new QPushButton("▶ Cine");
+    QPushButton *btnPlane = new QPushButton("Plano: Axial");
+    QPushButton *btnSlab = new QPushButton("Slab: Desligado");
+    QPushButton *btn3D = new QPushButton("3D: Desligado");
     QPushButton *btnZoomIn = new QPushButton("Zoom (+)");
     QPushButton *btnZoomOut = new QPushButton("Zoom (-)");
     QPushButton *btnFit = new QPushButton("Resetar");
@@ -201,6 +279,15 @@ int main(int argc, char *argv[]) {
     // Estilização dos botões da barra
     QString toolBtnStyle = "padding: 8px 15px; font-weight: bold; border-radius: 4px; background-color: #ecf0f1;";
     btnOpenAnother->setStyleSheet(toolBtnStyle);
+    btnOpenFolder->setStyleSheet(toolBtnStyle);
+    btnCine->setStyleSheet(toolBtnStyle);
+    btnCine->setEnabled(false); // Só para objetos multi-frame
+    btnPlane->setStyleSheet(toolBtnStyle);
+    btnPlane->setEnabled(false); // Só para séries empilhadas em volume
+    btnSlab->setStyleSheet(toolBtnStyle);
+    btnSlab->setEnabled(false); // Volumes e multi-frames (abertos como volume)
+    btn3D->setStyleSheet(toolBtnStyle);
+    btn3D->setEnabled(false); // Só para séries empilhadas em volume
     btnZoomIn->setStyleSheet(toolBtnStyle);
     btnZoomOut->setStyleSheet(toolBtnStyle);
     btnFit->setStyleSheet(toolBtnStyle);
@@ -209,6 +296,11 @@ int main(int argc, char *argv[]) {
     
 
     toolsLayout->addWidget(btnOpenAnother);
+    toolsLayout->addWidget(btnOpenFolder);
+    toolsLayout->addWidget(btnCine);
+    toolsLayout->addWidget(btnPlane);
+    toolsLayout->addWidget(btnSlab);
+    toolsLayout->addWidget(btn3D);
     toolsLayout->addStretch(); // Espaçador
     toolsLayout->addWidget(btnToggleInfo);
     toolsLayout->addWidget(btnZoomIn);
@@ -218,17 +310,258 @@ int main(int argc, char *argv[]) {
     
     viewerLayout->addLayout(toolsLayout);
 
+    // =========================================================
+    // TELA 3: Galeria de miniaturas (Study Browser)
+    // =========================================================
+    QWidget *galleryPage = new QWidget;
+    QVBoxLayout *galleryLayout = new QVBoxLayout(galleryPage);
+    galleryLayout->setContentsMargins(0, 0, 0, 0);
+    galleryLayout->setSpacing(0);
+
+    // Lista virtualizada: só as células visíveis são desenhadas (e pedem miniatura)
+    DicomThumbnailModel *thumbnailModel = new DicomThumbnailModel(&window);
+    QListView *galleryView = new QListView;
+    galleryView->setModel(thumbnailModel);
+    galleryView->setViewMode(QListView::IconMode);
+    galleryView->setIconSize(QSize(DicomThumbnailModel::kThumbnailSize, DicomThumbnailModel::kThumbnailSize));
+    galleryView->setGridSize(QSize(DicomThumbnailModel::kThumbnailSize + 24, DicomThumbnailModel::kThumbnailSize + 36));
+    galleryView->setUniformItemSizes(true);             // Layout sem consultar cada célula
+    galleryView->setLayoutMode(QListView::Batched);     // Milhares de linhas sem travar a interface
+    galleryView->setResizeMode(QListView::Adjust);
+    galleryView->setMovement(QListView::Static);
+    galleryView->setSelectionMode(QAbstractItemView::SingleSelection);
+    galleryView->setStyleSheet("QListView { background-color: #1e272e; color: #ecf0f1; border: none; }");
+    galleryLayout->addWidget(galleryView);
+
+    QHBoxLayout *galleryToolsLayout = new QHBoxLayout();
+    QLabel *lblGalleryCount = new QLabel("");
+    QPushButton *btnGalleryBack = new QPushButton("Voltar");
+    btnGalleryBack->setStyleSheet(toolBtnStyle);
+    galleryToolsLayout->addWidget(lblGalleryCount);
+    galleryToolsLayout->addStretch();
+    galleryToolsLayout->addWidget(btnGalleryBack);
+    galleryLayout->addLayout(galleryToolsLayout);
+
     // Adiciona as páginas ao Stack
     stackedWidget->addWidget(welcomePage); // Índice 0
     stackedWidget->addWidget(viewerPage);  // Índice 1
+    stackedWidget->addWidget(galleryPage); // Índice 2
     stackedWidget->setCurrentIndex(0);     // Inicia na tela de boas-vindas
 
+    // Painel lateral: filtros + navegador de pastas (oculto até a primeira varredura)
+    QWidget *browserPanel = new QWidget;
+    QVBoxLayout *browserLayout = new QVBoxLayout(browserPanel);
+    browserLayout->setContentsMargins(4, 4, 4, 4);
+
+    QHBoxLayout *filterLayout = new QHBoxLayout();
+    QLineEdit *editPatientID = new QLineEdit;
+    editPatientID->setPlaceholderText("Patient ID");
+    QLineEdit *editDateFrom = new QLineEdit;
+    editDateFrom->setPlaceholderText("De (AAAAMMDD)");
+    QLineEdit *editDateTo = new QLineEdit;
+    editDateTo->setPlaceholderText("Até (AAAAMMDD)");
+    QLineEdit *editModality = new QLineEdit;
+    editModality->setPlaceholderText("Mod.");
+    editModality->setMaximumWidth(60);
+    QPushButton *btnFilter = new QPushButton("Filtrar");
+    QPushButton *btnClearFilter = new QPushButton("Limpar");
+    QPushButton *btnGallery = new QPushButton("Miniaturas");
+    filterLayout->addWidget(editPatientID);
+    filterLayout->addWidget(editDateFrom);
+    filterLayout->addWidget(editDateTo);
+    filterLayout->addWidget(editModality);
+    filterLayout->addWidget(btnFilter);
+    filterLayout->addWidget(btnClearFilter);
+    filterLayout->addWidget(btnGallery);
+    browserLayout->addLayout(filterLayout);
+
+    DicomBrowser *browser = new DicomBrowser;
+    browserLayout->addWidget(browser);
+
+    QDockWidget *browserDock = new QDockWidget("Navegador", &window);
+    browserDock->setWidget(browserPanel);
+    browserDock->setFeatures(QDockWidget::DockWidgetClosable | QDockWidget::DockWidgetMovable);
+    window.addDockWidget(Qt::LeftDockWidgetArea, browserDock);
+    browserDock->hide();
+
     // =========================================================
     // LÓGICA E CONEXÕES (Signals & Slots)
     // =========================================================
 
+    // Estado da imagem exibida (compartilhado entre os lambdas abaixo)
+    DicomImageItem *currentItem = nullptr; // Item com pixels nativos exibido (pertence à cena)
+    QGraphicsPixmapItem *currentPixmap = nullptr; // Item em 8 bits exibido (coloridas; pertence à cena)
+    DicomVolume currentVolume;             // Série empilhada exibida (vazio para arquivos isolados)
+    int currentSlice = 0;                  // Plano exibido na orientação atual
+    DicomMpr::Plane currentPlane = DicomMpr::Plane::Axial; // Orientação exibida (MPR)
+    DicomBrickedVolume currentBricks;      // Volume em blocos (criado na primeira troca para coronal/sagital)
+    bool slabOn = false;                   // Projeção em slab espesso (mantida entre séries)
+    DicomMpr::Projection slabProjection = DicomMpr::Projection::Maximum;
+    int slabThickness = 9;                 // Planos do slab
+    QString currentModality;               // Modalidade da série (presets 3D de CT)
+    int renderMode = 0;                    // 3D: 0 desligado, 1 janela, 2 osso, 3 tecidos moles
+    QGraphicsPixmapItem *renderItem = nullptr; // Imagem 3D exibida no lugar do plano
+
+    // Atualiza o texto da janela atual no overlay
+    auto showWindowLevel = [lblBottomLeft](double center, double width) {
+        lblBottomLeft->setText(QString("WL: %1  WW: %2").arg(qRound(center)).arg(qRound(width)));
+    };
+
+    // Carregador assíncrono: a decodificação roda fora da thread da interface
+    DicomLoader *loader = new DicomLoader(&window);
+
+    // Reprodutor cine: frames decodificados à frente em segundo plano, exibidos no ritmo do relógio
+    DicomCinePlayer *cine = new DicomCinePlayer(&window);
+
+    // Renderização 3D: pré-visualização na hora durante a interação, resolução completa depois
+    DicomVolumeRenderer *renderer = new DicomVolumeRenderer(&window);
+
+    // Frame atual, taxa e contadores da reprodução (vazio fora de multi-frames);
+    // para uma série empilhada, o corte atual e o espaçamento entre cortes
+    auto showCine = [cine, lblCine, &currentVolume, &currentSlice, &currentPlane,
+                     &slabOn, &slabProjection, &slabThickness]() {
+        if (!currentVolume.isNull()) {
+            // Distância entre planos da orientação exibida
+            const QString names[] = {"AXIAL", "CORONAL", "SAGITAL"};
+            const double spacings[] = {currentVolume.spacingZ, currentVolume.spacingY, currentVolume.spacingX};
+            const int plane = int(currentPlane);
+            QString text = QString("%1: %2 / %3  (%4 mm)")
+                               .arg(names[plane])
+                               .arg(currentSlice + 1)
+                               .arg(DicomMpr::sliceCount(currentVolume, currentPlane))
+                               .arg(spacings[plane], 0, 'f', 2);
+            if (slabOn) {
+                const QString projections[] = {"MIP", "MinIP", "MÉDIA"};
+                const int planes = qMin(slabThickness, DicomMpr::sliceCount(currentVolume, currentPlane));
+                text += QString("\nSLAB %1: %2 planos (%3 mm)")
+                            .arg(projections[int(slabProjection)])
+                            .arg(planes)
+                            .arg(planes * spacings[plane], 0, 'f', 1);
+            }
+            lblCine->setText(text);
+            return;
+        }
+        if (!cine->isActive()) {
+            lblCine->clear();
+            return;
+        }
+        const DicomCinePlayer::Stats stats = cine->stats();
+        lblCine->setText(QString("FRAME: %1 / %2  (%3 fps)\nDESCARTADOS: %4  ATRASADOS: %5")
+                             .arg(cine->currentFrame() + 1)
+                             .arg(cine->frameCount())
+                             .arg(cine->frameRate(), 0, 'f', 1)
+                             .arg(stats.dropped)
+                             .arg(stats.late));
+    };
+
+    // Janela de "Aguarde" não-modal: a interface continua respondendo durante a decodificação
+    QProgressDialog *progress = new QProgressDialog("Processando imagem e metadados...", "Cancelar", 0, 100, &window);
+    progress->setWindowTitle("Aguarde");
+    progress->setWindowModality(Qt::NonModal);
+    progress->setMinimumDuration(0);
+    progress->reset(); // Impede a exibição automática antes do primeiro carregamento
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+
+    // Encerra o feedback visual (diálogo + cursor) ao fim de uma requisição
+    auto finishFeedback = [progress]() {
+        progress->hide();
+        if (QApplication::overrideCursor() != nullptr) {
+            QApplication::restoreOverrideCursor();
+        }
+    };
+
+    // Inicia o carregamento de um arquivo com feedback visual
+    auto openPath = [loader, progress](const QString &path) {
+        // Arquivos já decodificados (cache) chegam imediatamente: sem diálogo nem cursor
+        const bool cached = DicomCache::instance().contains(DicomCache::keyFor(path));
+
+        // [1] Trabalho Pesado em segundo plano (cancela automaticamente o arquivo anterior)
+        loader->load(path);
+
+        // [2] Feedback Visual (o cursor só é empilhado uma vez, mesmo com requisições seguidas)
+        if (cached) {
+            return;
+        }
+        if (QApplication::overrideCursor() == nullptr) {
+            QApplication::setOverrideCursor(Qt::BusyCursor);
+        }
+        progress->setLabelText(QString("Processando imagem e metadados...\n%1").arg(QFileInfo(path).fileName()));
+        progress->setValue(0);
+        progress->show();
+    };
+
+    // Sai da renderização 3D: volta ao plano exibido e ao pan com o botão esquerdo
+    auto exit3D = [&currentItem, &renderMode, &renderItem, renderer, view, btn3D]() {
+        renderer->clear();
+        delete renderItem;
+        renderItem = nullptr;
+        renderMode = 0;
+        btn3D->setText("3D: Desligado");
+        view->setOrbitMode(false);
+        view->setDragMode(QGraphicsView::ScrollHandDrag);
+        if (currentItem != nullptr) {
+            currentItem->show();
+        }
+    };
+
+    // Esquece a série exibida (volume, blocos e orientação) ao abrir outra imagem ou voltar
+    auto resetVolume = [&currentVolume, &currentBricks, &currentPlane, exit3D, view, btnPlane, btnSlab, btn3D]() {
+        exit3D();
+        currentVolume = DicomVolume();
+        currentBricks = DicomBrickedVolume();
+        currentPlane = DicomMpr::Plane::Axial;
+        btnPlane->setText("Plano: Axial");
+        btnPlane->setEnabled(false);
+        btnSlab->setEnabled(false);
+        btn3D->setEnabled(false);
+        view->setSliceScrolling(false);
+    };
+
+    // Exibe o plano atual do volume: axial aponta para o próprio volume (sem cópia); coronal e
+    // sagital são reformatados do volume em blocos (alguns ms, em todos os núcleos). Com o slab
+    // ligado, os planos em volta do atual são projetados (MIP / MinIP / média) em um só.
+    auto showSlice = [&currentItem, &currentVolume, &currentBricks, &currentPlane, &currentSlice,
+                      &slabOn, &slabProjection, &slabThickness]() {
+        if (currentItem == nullptr) {
+            return;
+        }
+        if (slabOn) {
+            currentItem->setPyramid({DicomMpr::slab(currentVolume, currentBricks, currentPlane, currentSlice,
+                                                    slabThickness, slabProjection)});
+        } else if (currentPlane == DicomMpr::Plane::Axial) {
+            currentItem->setPyramid({currentVolume.frame(currentSlice)});
+        } else {
+            currentItem->setPyramid({DicomMpr::reformat(currentVolume, currentBricks, currentPlane, currentSlice)});
+        }
+    };
+
+    // Inicia o empilhamento de uma série (todas as instâncias em um volume) com feedback visual
+    auto openSeries = [loader, progress](const QStringList &paths) {
+        loader->loadSeries(paths);
+
+        if (QApplication::overrideCursor() == nullptr) {
+            QApplication::setOverrideCursor(Qt::BusyCursor);
+        }
+        progress->setLabelText(QString("Montando volume da série...\n%1 cortes").arg(paths.size()));
+        progress->setValue(0);
+        progress->show();
+    };
+
+    // Decodifica todos os frames de um multi-frame (ex.: tomossíntese) em um volume
+    auto openVolume = [loader, progress](const QString &path) {
+        loader->loadVolume(path);
+
+        if (QApplication::overrideCursor() == nullptr) {
+            QApplication::setOverrideCursor(Qt::BusyCursor);
+        }
+        progress->setLabelText(QString("Montando volume dos frames...\n%1").arg(QFileInfo(path).fileName()));
+        progress->setValue(0);
+        progress->show();
+    };
+
     // Lambda para abrir arquivo
-    auto openDicomAction = [&window, stackedWidget, scene, view, lblTopLeft, lblTopRight, lblBottomRight]() {
+    auto openDicomAction = [&window, openPath]() {
         
         QString initialDir = QCoreApplication::applicationDirPath() + "/../ArquivosDesafio";
         if (!QDir(initialDir).exists()) {
@@ -240,80 +573,595 @@ int main(int argc, char *argv[]) {
         );
 
         if (!path.isEmpty()) {
-            // [1] Feedback Visual
-            QApplication::setOverrideCursor(Qt::WaitCursor);
-            QProgressDialog progress("Processando imagem e metadados...", nullptr, 0, 0, &window);
-            progress.setWindowTitle("Aguarde");
-            progress.setWindowModality(Qt::WindowModal);
-            progress.setMinimumDuration(0);
-            progress.show();
-            QCoreApplication::processEvents(); 
-
-            // [2] Trabalho Pesado (Carrega Imagem + Metadados)
-            QImage img = DicomManager::loadDicomImage(path);
-            DicomMetadata meta = DicomManager::extractMetadata(path); // <--- NOVO
-
-            // [3] Remove Feedback
-            progress.close();
-            QApplication::restoreOverrideCursor();
+            openPath(path);
+        }
+    };
 
-            if (!img.isNull()) {
-                scene->clear(); 
-                scene->setSceneRect(-10000, -10000, 20000, 20000); 
+    // Varredura de pastas: só Headers, em paralelo; a árvore é preenchida a cada lote
+    DicomScanner *scanner = new DicomScanner(&window);
 
-                QGraphicsPixmapItem *item = scene->addPixmap(QPixmap::fromImage(img));
-                item->setOffset(-img.width() / 2.0, -img.height() / 2.0);
+    // Índice persistente da pasta aberta: preenche o navegador na hora e evita reler Headers
+    DicomArchiveIndex archive;
+    QString archiveFile;
+    bool filterActive = false; // Navegador mostrando o resultado de uma consulta
 
-                view->fitInView(item, Qt::KeepAspectRatio);
-                view->scale(0.95, 0.95); 
-                view->centerOn(0, 0);
+    auto openFolderAction = [&window, &archive, &archiveFile, &filterActive, scanner, browser, browserDock]() {
+        QString initialDir = QCoreApplication::applicationDirPath() + "/../ArquivosDesafio";
+        if (!QDir(initialDir).exists()) {
+             initialDir = QCoreApplication::applicationDirPath() + "/..";
+        }
+
+        const QString directory = QFileDialog::getExistingDirectory(&window, "Abrir Pasta DICOM", initialDir);
+        if (directory.isEmpty()) {
+            return;
+        }
+
+        // [1] O que já foi indexado aparece imediatamente
+        archiveFile = DicomArchiveIndex::indexFileFor(directory);
+        archive.load(archiveFile);
+        filterActive = false;
+        browser->clearIndex();
+        browser->addInstances(archive.instances());
+        browserDock->setWindowTitle("Navegador - verificando alterações...");
+        browserDock->show();
+
+        // [2] Reindexação incremental: só arquivos novos ou alterados têm o Header lido
+        archive.beginScan();
+        scanner->scan(directory, archive.snapshot());
+    };
 
-                // --- ATUALIZAÇÃO DO OVERLAY ---
-                if (meta.isValid) {
-                    lblTopLeft->setText(QString("NOME: %1\nID: %2\nMOD: %3")
-                                        .arg(meta.patientName)
-                                        .arg(meta.patientID)
-                                        .arg(meta.modality));
-
-                    lblTopRight->setText(QString("%1\nDATA: %2")
-                                         .arg(meta.institution)
-                                         .arg(meta.studyDate));
-
-                    lblBottomRight->setText(QString("DIM: %1").arg(meta.dimensions));
-                } else {
-                    lblTopLeft->setText("METADADOS INDISPONÍVEIS");
-                    lblTopRight->clear();
-                    lblBottomRight->clear();
+    QObject::connect(scanner, &DicomScanner::batchReady,
+        [&archive, &filterActive, browser](const QVector<DicomInstanceInfo> &instances) {
+            archive.update(instances);
+            if (!filterActive) {
+                browser->addInstances(instances); // Repetidas e não-DICOM são ignoradas
+            }
+        });
+    QObject::connect(scanner, &DicomScanner::progressChanged, [browserDock](int scanned, int found) {
+        browserDock->setWindowTitle(QString("Navegador - lendo %1 de %2 arquivos...").arg(scanned).arg(found));
+    });
+    QObject::connect(scanner, &DicomScanner::finished,
+        [&archive, &archiveFile, &filterActive, browser, browserDock](int scanned, int valid) {
+            // Arquivos apagados desde a última varredura saem do índice (e da árvore)
+            if (archive.endScan() > 0 && !filterActive) {
+                browser->clearIndex();
+                browser->addInstances(archive.instances());
+            }
+            archive.save(archiveFile);
+            browserDock->setWindowTitle(QString("Navegador - %1 imagens (%2 arquivos)").arg(valid).arg(scanned));
+        });
+
+    // Consultas ao índice (Patient ID, intervalo de datas e modalidade)
+    auto applyFilter = [&archive, &filterActive, browser, browserDock,
+                        editPatientID, editDateFrom, editDateTo, editModality]() {
+        DicomArchiveIndex::Query query;
+        query.patientID = editPatientID->text().trimmed();
+        query.dateFrom = editDateFrom->text().trimmed();
+        query.dateTo = editDateTo->text().trimmed();
+        query.modality = editModality->text().trimmed().toUpper();
+
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<DicomInstanceInfo> results = archive.query(query);
+        const qint64 elapsed = timer.elapsed();
+
+        filterActive = true;
+        browser->clearIndex();
+        browser->addInstances(results);
+        browserDock->setWindowTitle(QString("Navegador - %1 imagens encontradas (%2 ms)").arg(results.size()).arg(elapsed));
+    };
+    auto clearFilter = [&archive, &filterActive, browser, browserDock,
+                        editPatientID, editDateFrom, editDateTo, editModality]() {
+        editPatientID->clear();
+        editDateFrom->clear();
+        editDateTo->clear();
+        editModality->clear();
+        filterActive = false;
+        browser->clearIndex();
+        browser->addInstances(archive.instances());
+        browserDock->setWindowTitle(QString("Navegador - %1 imagens").arg(browser->index().instanceCount()));
+    };
+    QObject::connect(btnFilter, &QPushButton::clicked, applyFilter);
+    QObject::connect(btnClearFilter, &QPushButton::clicked, clearFilter);
+    for (QLineEdit *edit : {editPatientID, editDateFrom, editDateTo, editModality}) {
+        QObject::connect(edit, &QLineEdit::returnPressed, applyFilter);
+    }
+
+    QObject::connect(browser, &DicomBrowser::instanceActivated, openPath);
+    QObject::connect(browser, &DicomBrowser::seriesActivated, openSeries);
+
+    // Galeria: instâncias do navegador (já filtradas) na ordem paciente -> estudo -> série
+    auto openGallery = [browser, thumbnailModel, galleryView, lblGalleryCount, stackedWidget]() {
+        QVector<DicomInstanceInfo> instances;
+        instances.reserve(browser->index().instanceCount());
+        for (const DicomPatientNode &patient : browser->index().patients()) {
+            for (const DicomStudyNode &study : patient.studies) {
+                for (const DicomSeriesNode &series : study.series) {
+                    QVector<DicomInstanceInfo> sorted = series.instances;
+                    std::sort(sorted.begin(), sorted.end(), [](const DicomInstanceInfo &a, const DicomInstanceInfo &b) {
+                        return a.instanceNumber < b.instanceNumber;
+                    });
+                    instances += sorted;
                 }
+            }
+        }
+        thumbnailModel->setInstances(instances);
+        galleryView->scrollToTop();
+        lblGalleryCount->setText(QString("  %1 imagens").arg(instances.size()));
+        stackedWidget->setCurrentIndex(2);
+    };
+    QObject::connect(btnGallery, &QPushButton::clicked, openGallery);
+
+    // Faixa visível: pedidos de miniaturas que saíram da tela são descartados antes de decodificar
+    auto updateVisibleRange = [galleryView, thumbnailModel]() {
+        const QRect viewport = galleryView->viewport()->rect();
+        const QModelIndex first = galleryView->indexAt(viewport.topLeft() + QPoint(4, 4));
+        QModelIndex last = galleryView->indexAt(viewport.bottomRight() - QPoint(4, 4));
+        if (!last.isValid()) {
+            last = thumbnailModel->index(thumbnailModel->rowCount() - 1);
+        }
+        thumbnailModel->setVisibleRange(first.isValid() ? first.row() : 0, last.row());
+    };
+    QObject::connect(galleryView->verticalScrollBar(), &QScrollBar::valueChanged, updateVisibleRange);
+    QObject::connect(galleryView->verticalScrollBar(), &QScrollBar::rangeChanged, updateVisibleRange);
+
+    QObject::connect(galleryView, &QListView::activated, [openPath](const QModelIndex &index) {
+        openPath(index.data(DicomThumbnailModel::PathRole).toString());
+    });
+    QObject::connect(btnGalleryBack, &QPushButton::clicked, [stackedWidget, scene]() {
+        stackedWidget->setCurrentIndex(scene->items().isEmpty() ? 0 : 1); // Volta à imagem aberta, se houver
+    });
+
+    // Arquivo exibido e navegação pelos arquivos .dcm da mesma pasta (PageUp / PageDown)
+    QString currentPath;
+
+    // Lista ordenada dos arquivos .dcm da pasta de um arquivo (caminhos absolutos)
+    auto siblingFiles = [](const QString &path) {
+        const QDir dir = QFileInfo(path).absoluteDir();
+        QStringList files;
+        for (const QString &name : dir.entryList({"*.dcm", "*.DCM"}, QDir::Files, QDir::Name | QDir::IgnoreCase)) {
+            files.append(dir.absoluteFilePath(name));
+        }
+        files.removeDuplicates(); // "*.dcm" e "*.DCM" coincidem em sistemas sem distinção de maiúsculas
+        return files;
+    };
+
+    // Abre o arquivo 'step' posições à frente (ou atrás) do atual
+    auto navigate = [&currentPath, siblingFiles, openPath](int step) {
+        if (currentPath.isEmpty()) {
+            return;
+        }
+        const QStringList files = siblingFiles(currentPath);
+        const int index = files.indexOf(QFileInfo(currentPath).absoluteFilePath());
+        const int target = index + step;
+        if (index < 0 || target < 0 || target >= files.size()) {
+            return;
+        }
+        openPath(files.at(target));
+    };
+
+    // Pré-carrega os vizinhos do arquivo exibido enquanto o usuário analisa a imagem
+    auto prefetchNeighbours = [loader, siblingFiles](const QString &path) {
+        const QStringList files = siblingFiles(path);
+        const int index = files.indexOf(QFileInfo(path).absoluteFilePath());
+        if (index < 0) {
+            return;
+        }
+        QStringList neighbours;
+        if (index + 1 < files.size()) neighbours.append(files.at(index + 1)); // Próximo primeiro
+        if (index > 0) neighbours.append(files.at(index - 1));
+        loader->prefetch(neighbours);
+    };
+
+    // Atualiza os textos do overlay a partir dos metadados
+    auto showMetadata = [lblTopLeft, lblTopRight, lblBottomRight](const DicomMetadata &meta) {
+        if (meta.isValid) {
+            lblTopLeft->setText(QString("NOME: %1\nID: %2\nMOD: %3")
+                                .arg(meta.patientName)
+                                .arg(meta.patientID)
+                                .arg(meta.modality));
+
+            lblTopRight->setText(QString("%1\nDATA: %2")
+                                 .arg(meta.institution)
+                                 .arg(meta.studyDate));
+
+            lblBottomRight->setText(QString("DIM: %1").arg(meta.dimensions));
+        } else {
+            lblTopLeft->setText("METADADOS INDISPONÍVEIS");
+            lblTopRight->clear();
+            lblBottomRight->clear();
+        }
+    };
+
+    // Contadores do cache (canto inferior direito, abaixo das dimensões)
+    auto showCacheStats = [lblBottomRight]() {
+        const DicomCache::Stats stats = DicomCache::instance().stats();
+        lblBottomRight->setText(lblBottomRight->text() +
+                                QString("\nCACHE: %1 acertos / %2 falhas / %3 descartes - %4 de %5 MB")
+                                    .arg(stats.hits)
+                                    .arg(stats.misses)
+                                    .arg(stats.evictions)
+                                    .arg(stats.bytes / (1024 * 1024))
+                                    .arg(stats.budget / (1024 * 1024)));
+    };
 
-                stackedWidget->setCurrentIndex(1); 
+    // [3a] Pré-visualização (ícone embutido): exibida esticada para o tamanho original, de modo
+    // que o enquadramento não muda quando a imagem completa substituí-la
+    QObject::connect(loader, &DicomLoader::previewReady,
+        [&currentItem, &currentPixmap, resetVolume, stackedWidget, scene, view, lblBottomLeft, showMetadata, cine, btnCine, showCine](const DicomPreview &preview) {
+            const QImage &img = preview.image;
+
+            resetVolume();
+            cine->clear();
+            btnCine->setEnabled(false);
+            showCine();
+            scene->clear();
+            currentItem = nullptr;
+            currentPixmap = nullptr;
+            scene->setSceneRect(-10000, -10000, 20000, 20000);
+
+            QGraphicsPixmapItem *pixmapItem = scene->addPixmap(QPixmap::fromImage(img, Qt::NoFormatConversion));
+            pixmapItem->setTransformationMode(Qt::SmoothTransformation);
+            pixmapItem->setOffset(-img.width() / 2.0, -img.height() / 2.0);
+            pixmapItem->setTransform(QTransform::fromScale(double(preview.fullSize.width()) / img.width(),
+                                                           double(preview.fullSize.height()) / img.height()));
+
+            view->fitInView(pixmapItem, Qt::KeepAspectRatio);
+            view->scale(0.95, 0.95);
+            view->centerOn(0, 0);
+
+            showMetadata(preview.metadata);
+            lblBottomLeft->clear(); // Janela só vale para os pixels completos
+
+            stackedWidget->setCurrentIndex(1);
+        });
+
+    // [3b] Resultado completo entregue pela thread de trabalho (sinal enfileirado)
+    QObject::connect(loader, &DicomLoader::loaded,
+        [&currentItem, &currentPixmap, resetVolume, stackedWidget, scene, view, lblBottomLeft,
+         finishFeedback, showWindowLevel, showMetadata, showCacheStats,
+         &currentPath, prefetchNeighbours, cine, btnCine, btnSlab, showCine](const DicomLoadResult &loaded) {
+            finishFeedback();
+
+            resetVolume();
+            cine->clear();
+            scene->clear(); 
+            currentItem = nullptr;
+            currentPixmap = nullptr;
+            scene->setSceneRect(-10000, -10000, 20000, 20000); 
+
+            QGraphicsItem *item = nullptr;
+            if (!loaded.pyramid.isEmpty()) {
+                // Pixels nativos: o item desenha o nível da pirâmide adequado ao zoom e permite janelamento
+                const DicomPixelData &pixels = loaded.pixels;
+                currentItem = new DicomImageItem(loaded.pyramid);
+                scene->addItem(currentItem);
+                item = currentItem;
+
+                const double range = double(pixels.maxStored) - pixels.minStored;
+                view->setWindowLevel(pixels.windowCenter, pixels.windowWidth);
+                view->setWindowStep(qMax(1.0, range / 1024.0));
+                showWindowLevel(pixels.windowCenter, pixels.windowWidth);
             } else {
-                QMessageBox::critical(&window, "Erro", "Falha ao processar imagem DICOM.");
+                // Imagens coloridas: 8 bits da DCMTK, sem janelamento.
+                // NoFormatConversion: o QPixmap compartilha o buffer da QImage (sem nova cópia)
+                const QImage &img = loaded.image;
+                currentPixmap = scene->addPixmap(QPixmap::fromImage(img, Qt::NoFormatConversion));
+                currentPixmap->setOffset(-img.width() / 2.0, -img.height() / 2.0);
+                item = currentPixmap;
+                lblBottomLeft->clear();
+            }
+
+            view->fitInView(item, Qt::KeepAspectRatio);
+            view->scale(0.95, 0.95); 
+            view->centerOn(0, 0);
+
+            // --- CINE (multi-frame: pixels nativos ou, coloridos, 8 bits) ---
+            if (loaded.frameCount > 1) {
+                cine->setSource(loaded);
             }
+            btnCine->setEnabled(cine->isActive());
+            btnSlab->setEnabled(cine->isActive() && !cine->isColor()); // Slab abre o multi-frame como volume
+            view->setSliceScrolling(cine->isActive()); // Roda do mouse percorre os frames
+            showCine();
+
+            // --- ATUALIZAÇÃO DO OVERLAY ---
+            showMetadata(loaded.metadata);
+            showCacheStats();
+
+            stackedWidget->setCurrentIndex(1); 
+
+            // --- NAVEGAÇÃO ---
+            currentPath = loaded.path;
+            prefetchNeighbours(loaded.path);
+        });
+
+    // [3c] Série empilhada: o volume inteiro fica em memória e a roda do mouse troca o corte
+    QObject::connect(loader, &DicomLoader::seriesLoaded,
+        [&currentItem, &currentPixmap, &currentVolume, &currentSlice, &slabOn, &currentModality, resetVolume, stackedWidget, scene, view,
+         btnPlane, btnSlab, btn3D, finishFeedback, showWindowLevel, showMetadata, &currentPath, cine, btnCine, showSlice, showCine](const DicomSeriesResult &series) {
+            finishFeedback();
+
+            resetVolume();
+            cine->clear();
+            btnCine->setEnabled(false);
+            scene->clear();
+            currentPixmap = nullptr;
+            scene->setSceneRect(-10000, -10000, 20000, 20000);
+
+            currentVolume = series.volume;
+            currentSlice = 0;
+            const DicomVolume &volume = currentVolume;
+            currentItem = new DicomImageItem({volume.frame(currentSlice)});
+            scene->addItem(currentItem);
+
+            const double range = double(volume.maxStored) - volume.minStored;
+            view->setWindowLevel(volume.windowCenter, volume.windowWidth);
+            view->setWindowStep(qMax(1.0, range / 1024.0));
+            view->setSliceScrolling(true);
+            btnPlane->setEnabled(volume.depth > 1);
+            btnSlab->setEnabled(volume.depth > 1);
+            btn3D->setEnabled(volume.depth > 1);
+            currentModality = series.metadata.modality;
+            if (slabOn) {
+                showSlice(); // Projeta já o primeiro plano
+            }
+            showWindowLevel(volume.windowCenter, volume.windowWidth);
+
+            view->fitInView(currentItem, Qt::KeepAspectRatio);
+            view->scale(0.95, 0.95);
+            view->centerOn(0, 0);
+
+            showMetadata(series.metadata);
+            showCine();
+            stackedWidget->setCurrentIndex(1);
+
+            currentPath = series.paths.first();
+        });
+
+    QObject::connect(loader, &DicomLoader::failed, [&window, finishFeedback](const QString &) {
+        finishFeedback();
+        QMessageBox::critical(&window, "Erro", "Falha ao processar imagem DICOM.");
+    });
+
+    // Janelamento interativo (arraste com o botão direito): re-renderiza a partir dos pixels
+    // nativos em memória, sem reler o arquivo nem passar pelo codec.
+    QObject::connect(view, &DicomView::windowLevelChanged,
+        [&currentItem, &renderMode, renderer, showWindowLevel](double center, double width) {
+            if (currentItem == nullptr) {
+                return;
+            }
+            currentItem->setWindowLevel(center, width); // Só o nível exibido é renderizado novamente
+            showWindowLevel(center, width);
+            if (renderMode == 1) {
+                renderer->setTransferFunction(DicomVolumeRenderer::windowPreset(center, width));
+            }
+        });
+
+    // Cine: cada frame troca só os pixels do item (janela e enquadramento são mantidos)
+    QObject::connect(cine, &DicomCinePlayer::frameChanged,
+        [&currentItem, &currentPixmap, showCine](int, const DicomPixelData &pixels, const QImage &image) {
+            if (currentItem != nullptr && !pixels.isNull()) {
+                currentItem->setPyramid({pixels});
+            } else if (currentPixmap != nullptr && !image.isNull()) {
+                currentPixmap->setPixmap(QPixmap::fromImage(image, Qt::NoFormatConversion));
+            }
+            showCine();
+        });
+    QObject::connect(cine, &DicomCinePlayer::playingChanged, [btnCine, showCine](bool playing) {
+        btnCine->setText(playing ? "⏸ Pausar" : "▶ Cine");
+        showCine();
+    });
+    QObject::connect(btnCine, &QPushButton::clicked, cine, &DicomCinePlayer::toggle);
+
+    // Troca de corte (roda do mouse / setas): com um volume, só o plano exibido muda (os
+    // voxels já estão em memória; o custo é o remapeamento da janela); com um multi-frame,
+    // o cine avança ou recua frames
+    auto scrollFrames = [&currentItem, &currentVolume, &currentSlice, &currentPlane, cine, showSlice, showCine](int delta) {
+        if (!currentVolume.isNull() && currentItem != nullptr) {
+            const int count = DicomMpr::sliceCount(currentVolume, currentPlane);
+            const int slice = qBound(0, currentSlice + delta, count - 1);
+            if (slice != currentSlice) {
+                currentSlice = slice;
+                showSlice();
+                showCine();
+            }
+            return;
         }
+        cine->step(delta);
     };
+    QObject::connect(view, &DicomView::sliceScrolled, scrollFrames);
+
+    // MPR: alterna axial -> coronal -> sagital, começando no plano central da orientação
+    auto cyclePlane = [&currentItem, &currentVolume, &currentBricks, &currentPlane, &currentSlice, &renderMode,
+                       &window, view, btnPlane, showSlice, showCine]() {
+        if (currentVolume.isNull() || currentItem == nullptr || currentVolume.depth < 2 || renderMode != 0) {
+            return;
+        }
+        const DicomMpr::Plane next = DicomMpr::Plane((int(currentPlane) + 1) % 3);
+        if (next != DicomMpr::Plane::Axial && currentBricks.isNull()) {
+            // Cópia única do volume em blocos (paralela), mantida enquanto a série estiver aberta
+            QApplication::setOverrideCursor(Qt::BusyCursor);
+            currentBricks = DicomMpr::brick(currentVolume);
+            QApplication::restoreOverrideCursor();
+            if (currentBricks.isNull()) {
+                QMessageBox::warning(&window, "MPR", "Memória insuficiente para a reconstrução multiplanar.");
+                return;
+            }
+        }
+
+        const QString names[] = {"Axial", "Coronal", "Sagital"};
+        currentPlane = next;
+        currentSlice = DicomMpr::sliceCount(currentVolume, currentPlane) / 2;
+        showSlice();
+        btnPlane->setText(QString("Plano: %1").arg(names[int(currentPlane)]));
+
+        view->fitInView(currentItem, Qt::KeepAspectRatio);
+        view->scale(0.95, 0.95);
+        view->centerOn(0, 0);
+        showCine();
+    };
+    QObject::connect(btnPlane, &QPushButton::clicked, cyclePlane);
+
+    // Slab: desligado -> MIP -> MinIP -> média -> desligado. Em um multi-frame (cine), liga o
+    // MIP e abre o objeto inteiro como volume; a projeção é aplicada quando o volume chega.
+    auto showSlabButton = [&slabOn, &slabProjection, btnSlab]() {
+        const QString names[] = {"MIP", "MinIP", "Média"};
+        btnSlab->setText(slabOn ? QString("Slab: %1").arg(names[int(slabProjection)]) : QString("Slab: Desligado"));
+    };
+    auto cycleSlab = [&currentVolume, &currentPath, &slabOn, &slabProjection, cine, openVolume,
+                      showSlabButton, showSlice, showCine]() {
+        if (currentVolume.isNull()) {
+            if (cine->isActive() && !cine->isColor() && !currentPath.isEmpty()) {
+                slabOn = true;
+                slabProjection = DicomMpr::Projection::Maximum;
+                showSlabButton();
+                openVolume(currentPath);
+            }
+            return;
+        }
+
+        if (!slabOn) {
+            slabOn = true;
+            slabProjection = DicomMpr::Projection::Maximum;
+        } else if (slabProjection == DicomMpr::Projection::Average) {
+            slabOn = false;
+        } else {
+            slabProjection = DicomMpr::Projection(int(slabProjection) + 1);
+        }
+        showSlabButton();
+        showSlice();
+        showCine();
+    };
+    QObject::connect(btnSlab, &QPushButton::clicked, cycleSlab);
+
+    // 3D: desligado -> janela atual (arraste com o botão direito ajusta) -> osso -> tecidos
+    // moles (presets só para CT) -> desligado. O plano fica oculto sob a imagem renderizada;
+    // o botão esquerdo gira a câmera e a roda do mouse volta a ser zoom.
+    auto cycle3D = [&currentItem, &currentVolume, &currentBricks, &currentModality, &renderMode, &window,
+                    exit3D, renderer, view, btn3D, showCine]() {
+        if (currentVolume.isNull() || currentItem == nullptr || currentVolume.depth < 2) {
+            return;
+        }
+        int next = (renderMode + 1) % 4;
+        if (next >= 2 && currentModality != "CT") {
+            next = 0;
+        }
+        if (next == 0) {
+            exit3D();
+            view->setSliceScrolling(true);
+            view->fitInView(currentItem, Qt::KeepAspectRatio);
+            view->scale(0.95, 0.95);
+            view->centerOn(0, 0);
+            showCine();
+            return;
+        }
+
+        if (renderMode == 0) {
+            if (currentBricks.isNull()) {
+                QApplication::setOverrideCursor(Qt::BusyCursor);
+                currentBricks = DicomMpr::brick(currentVolume);
+                QApplication::restoreOverrideCursor();
+                if (currentBricks.isNull()) {
+                    QMessageBox::warning(&window, "3D", "Memória insuficiente para a renderização 3D.");
+                    return;
+                }
+            }
+            const QSize viewport = view->viewport()->size();
+            renderer->setImageSize(qBound(256, qMax(viewport.width(), viewport.height()), 1024));
+            renderer->setVolume(currentVolume, currentBricks);
+            currentItem->hide();
+            view->setDragMode(QGraphicsView::NoDrag);
+            view->setOrbitMode(true);
+            view->setSliceScrolling(false);
+        }
+
+        const QString names[] = {"Desligado", "Janela", "Osso", "Tecidos"};
+        renderMode = next;
+        btn3D->setText(QString("3D: %1").arg(names[renderMode]));
+        if (renderMode == 1) {
+            renderer->setTransferFunction(DicomVolumeRenderer::windowPreset(view->windowCenter(), view->windowWidth()));
+        } else if (renderMode == 2) {
+            renderer->setTransferFunction(DicomVolumeRenderer::ctBonePreset());
+        } else {
+            renderer->setTransferFunction(DicomVolumeRenderer::ctSoftTissuePreset());
+        }
+    };
+    QObject::connect(btn3D, &QPushButton::clicked, cycle3D);
+
+    // Imagem 3D: a pré-visualização (resolução reduzida) é esticada para o tamanho final, de
+    // modo que o enquadramento não muda quando a resolução completa chega
+    QObject::connect(renderer, &DicomVolumeRenderer::imageReady,
+        [&renderMode, &renderItem, scene, view](const QImage &image, int downsample) {
+            if (renderMode == 0) {
+                return;
+            }
+            const bool first = (renderItem == nullptr);
+            if (first) {
+                renderItem = scene->addPixmap(QPixmap());
+                renderItem->setTransformationMode(Qt::SmoothTransformation);
+            }
+            renderItem->setPixmap(QPixmap::fromImage(image, Qt::NoFormatConversion));
+            renderItem->setOffset(-image.width() / 2.0, -image.height() / 2.0);
+            renderItem->setTransform(QTransform::fromScale(downsample, downsample));
+            if (first) {
+                view->fitInView(renderItem, Qt::KeepAspectRatio);
+                view->centerOn(0, 0);
+            }
+        });
+    QObject::connect(view, &DicomView::orbitDragged, [renderer](const QPoint &delta) {
+        renderer->rotate(delta.x() * 0.5, delta.y() * 0.5); // Meio grau por pixel
+    });
+
+    // Espessura do slab (2 planos por passo, mantendo o plano atual no centro)
+    auto changeSlabThickness = [&currentVolume, &slabOn, &slabThickness, showSlice, showCine](int delta) {
+        if (!slabOn || currentVolume.isNull()) {
+            return;
+        }
+        const int largest = qMax(currentVolume.width, qMax(currentVolume.height, currentVolume.depth));
+        slabThickness = qBound(1, slabThickness + delta, largest);
+        showSlice();
+        showCine();
+    };
+
+    // Progresso e cancelamento
+    QObject::connect(loader, &DicomLoader::progressChanged, progress, &QProgressDialog::setValue);
+    QObject::connect(progress, &QProgressDialog::canceled, loader, &DicomLoader::cancel);
+    QObject::connect(loader, &DicomLoader::canceled, [loader, finishFeedback](const QString &) {
+        // Uma nova requisição pode ter sido iniciada logo após o cancelamento da anterior
+        if (!loader->isLoading()) {
+            finishFeedback();
+        }
+    });
 
     // Conexões dos Botões
     QObject::connect(btnBigOpen, &QPushButton::clicked, openDicomAction);
     QObject::connect(btnOpenAnother, &QPushButton::clicked, openDicomAction);
+    QObject::connect(btnBigOpenFolder, &QPushButton::clicked, openFolderAction);
+    QObject::connect(btnOpenFolder, &QPushButton::clicked, openFolderAction);
     
     // Controles de Zoom
     QObject::connect(btnZoomIn, &QPushButton::clicked, [view]() { view->scale(1.25, 1.25); });
     QObject::connect(btnZoomOut, &QPushButton::clicked, [view]() { view->scale(0.8, 0.8); });
     
     // Resetar visualização (Fit to Screen)
-    QObject::connect(btnFit, &QPushButton::clicked, [scene, view]() { 
+    QObject::connect(btnFit, &QPushButton::clicked, [scene, view, renderer]() { 
         view->fitInView(scene->itemsBoundingRect(), Qt::KeepAspectRatio); 
+        if (renderer->isActive()) {
+            renderer->resetCamera(); // 3D: volta à vista anterior
+        }
     });
     
     // Mostrar/esconder texto
     QObject::connect(btnToggleInfo, &QPushButton::toggled, 
-        [btnToggleInfo, lblTopLeft, lblTopRight, lblBottomRight](bool checked) {
+        [btnToggleInfo, lblTopLeft, lblTopRight, lblBottomLeft, lblBottomRight, lblCine](bool checked) {
             
             // Define a visibilidade baseada no estado do botão
             lblTopLeft->setVisible(checked);
             lblTopRight->setVisible(checked);
+            lblBottomLeft->setVisible(checked);
             lblBottomRight->setVisible(checked);
+            lblCine->setVisible(checked);
 
             // Muda o texto do botão para dar feedback ao usuário
             if (checked) {
@@ -325,8 +1173,15 @@ int main(int argc, char *argv[]) {
     );
 
     // Voltar para a Home
-    QObject::connect(btnBack, &QPushButton::clicked, [stackedWidget, scene]() {
+    QObject::connect(btnBack, &QPushButton::clicked, [&currentItem, &currentPixmap, resetVolume, &currentPath, stackedWidget, scene, cine, btnCine, showCine]() {
+        resetVolume(); // Libera o volume da série
+        cine->clear(); // Para a reprodução e libera o buffer de frames
+        btnCine->setEnabled(false);
+        showCine();
         scene->clear(); // Libera memória da imagem atual
+        currentItem = nullptr;
+        currentPixmap = nullptr;
+        currentPath.clear();
         stackedWidget->setCurrentIndex(0);
     });
 
@@ -360,6 +1215,45 @@ int main(int argc, char *argv[]) {
         btnToggleInfo->toggle(); 
     });
 
+    // 6. Atalho para Abrir Pasta (Ctrl + Shift + O)
+    QShortcut *shortcutOpenFolder = new QShortcut(QKeySequence("Ctrl+Shift+O"), &window);
+    QObject::connect(shortcutOpenFolder, &QShortcut::activated, openFolderAction);
+
+    // 7. Navegação entre os arquivos da pasta (PageDown = próximo, PageUp = anterior)
+    QShortcut *shortcutNext = new QShortcut(QKeySequence(Qt::Key_PageDown), &window);
+    QObject::connect(shortcutNext, &QShortcut::activated, [navigate]() { navigate(+1); });
+
+    QShortcut *shortcutPrevious = new QShortcut(QKeySequence(Qt::Key_PageUp), &window);
+    QObject::connect(shortcutPrevious, &QShortcut::activated, [navigate]() { navigate(-1); });
+
+    // 8. Cine (Espaço = reproduzir/pausar, Setas = frame ou corte anterior / próximo)
+    QShortcut *shortcutCine = new QShortcut(QKeySequence(Qt::Key_Space), &window);
+    QObject::connect(shortcutCine, &QShortcut::activated, cine, &DicomCinePlayer::toggle);
+
+    QShortcut *shortcutFrameNext = new QShortcut(QKeySequence(Qt::Key_Right), &window);
+    QObject::connect(shortcutFrameNext, &QShortcut::activated, [scrollFrames]() { scrollFrames(+1); });
+
+    QShortcut *shortcutFramePrevious = new QShortcut(QKeySequence(Qt::Key_Left), &window);
+    QObject::connect(shortcutFramePrevious, &QShortcut::activated, [scrollFrames]() { scrollFrames(-1); });
+
+    // 9. Plano da reconstrução multiplanar (M = axial / coronal / sagital)
+    QShortcut *shortcutPlane = new QShortcut(QKeySequence(Qt::Key_M), &window);
+    QObject::connect(shortcutPlane, &QShortcut::activated, cyclePlane);
+
+    // 10. Slab (S = desligado / MIP / MinIP / média; Setas para cima / baixo = mais / menos espesso)
+    QShortcut *shortcutSlab = new QShortcut(QKeySequence(Qt::Key_S), &window);
+    QObject::connect(shortcutSlab, &QShortcut::activated, cycleSlab);
+
+    QShortcut *shortcutSlabThicker = new QShortcut(QKeySequence(Qt::Key_Up), &window);
+    QObject::connect(shortcutSlabThicker, &QShortcut::activated, [changeSlabThickness]() { changeSlabThickness(+2); });
+
+    QShortcut *shortcutSlabThinner = new QShortcut(QKeySequence(Qt::Key_Down), &window);
+    QObject::connect(shortcutSlabThinner, &QShortcut::activated, [changeSlabThickness]() { changeSlabThickness(-2); });
+
+    // 11. Renderização 3D (V = desligado / janela / osso / tecidos moles)
+    QShortcut *shortcut3D = new QShortcut(QKeySequence(Qt::Key_V), &window);
+    QObject::connect(shortcut3D, &QShortcut::activated, cycle3D);
+
     window.show();
 
     // Executa a aplicação